@@ -0,0 +1,479 @@
+#include "plain_nn.hpp"
+#include "kernels.hpp"
+#include "model_storage.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#ifndef PLAIN_NN_BUILD_TYPE
+#define PLAIN_NN_BUILD_TYPE ""
+#endif
+
+/**
+ * @brief Command line options of the benchmark
+ */
+struct BenchmarkOptions{
+    std::string filter;         // @brief Only the benchmarks whose name contains it are run
+    std::string output;         // @brief The JSON file the results are written to
+    std::string label;          // @brief Free text saved with the results, e.g. the commit
+    double min_time;            // @brief The minimum time of each repetition, in seconds
+    int repetitions;            // @brief The number of timed repetitions of each benchmark
+};
+
+/**
+ * @brief Timing of a benchmark, the rates are computed
+ * from the median time of the repetitions
+ */
+struct BenchmarkResult{
+    std::string name;
+    long int iterations;        // @brief The iterations of each repetition
+    double ns_per_op;           // @brief The median time of an iteration
+    double ns_per_op_min;       // @brief The fastest repetition
+    double gflops;              // @brief The floating point operations per second, 0 if not meaningful
+    double gbps;                // @brief The bytes moved per second, 0 if not meaningful
+};
+
+// Every benchmark folds a value of its result in here,
+// so that the compiler can not drop the measured work
+static volatile double benchmark_sink = 0;
+
+static std::vector<BenchmarkResult> results;
+static BenchmarkOptions options;
+
+/**
+ * @brief Time an operation and record its result
+ *
+ * @param name The name of the benchmark, e.g. dense/forward/f64/b64/784x128
+ * @param flops The floating point operations of a single call
+ * @param bytes The bytes read and written by a single call
+ * @param op The operation
+ */
+void run_benchmark(std::string name, double flops, double bytes, const std::function<void()>& op){
+    if(!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+
+    typedef std::chrono::steady_clock Clock;
+
+    // The number of iterations is doubled until a repetition
+    // lasts at least min_time, the first call warms the caches
+    op();
+    long int iterations = 1;
+    while(true){
+        Clock::time_point start = Clock::now();
+        for(long int i = 0; i < iterations; i++) op();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        if(elapsed.count() >= options.min_time || iterations >= (1L << 30)) break;
+        iterations *= 2;
+    }
+
+    std::vector<double> times;
+    for(int rep = 0; rep < options.repetitions; rep++){
+        Clock::time_point start = Clock::now();
+        for(long int i = 0; i < iterations; i++) op();
+        std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        times.push_back(elapsed.count() / iterations);
+    }
+    std::sort(times.begin(), times.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.ns_per_op = times[times.size() / 2];
+    result.ns_per_op_min = times[0];
+    result.gflops = flops / result.ns_per_op;
+    result.gbps = bytes / result.ns_per_op;
+    results.push_back(result);
+
+    char gflops_buff[16] = "-", gbps_buff[16] = "-";
+    if(flops > 0) std::snprintf(gflops_buff, sizeof(gflops_buff), "%.2f", result.gflops);
+    if(bytes > 0) std::snprintf(gbps_buff, sizeof(gbps_buff), "%.2f", result.gbps);
+    std::printf("%-44s %12ld %14.1f %10s %10s\n", name.c_str(), iterations, result.ns_per_op, gflops_buff, gbps_buff);
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Benchmark the forward, backward and update of a Dense layer
+ * without activation, the products dominate the time
+ */
+template<typename T>
+void bench_dense(const char* dtype, int batch_size, int input_size, int output_size){
+    char suffix[64];
+    std::snprintf(suffix, sizeof(suffix), "/%s/b%d/%dx%d", dtype, batch_size, input_size, output_size);
+    double elem = sizeof(T);
+    double params = (double) input_size * output_size + output_size;
+
+    BasicDense<T> layer(input_size, output_size, new BasicNone<T>());
+    BasicTensor<T> input({batch_size, input_size}, true);
+    BasicTensor<T> error({batch_size, output_size}, true);
+
+    run_benchmark(std::string("dense/forward") + suffix,
+        2.0 * batch_size * input_size * output_size,
+        elem * ((double) batch_size * input_size + params + (double) batch_size * output_size),
+        [&](){
+            BasicTensor<T>& output = layer.forward(input);
+            benchmark_sink = benchmark_sink + output[0];
+        });
+
+    // As the last layer the error is copied and the gradients
+    // of the weights are accumulated, dW += X^T * G
+    run_benchmark(std::string("dense/backward") + suffix,
+        2.0 * batch_size * input_size * output_size + (double) batch_size * output_size,
+        elem * ((double) batch_size * input_size + 2 * params + 3.0 * batch_size * output_size),
+        [&](){
+            BasicTensor<T>& grads = layer.backward(&input, nullptr, &error);
+            benchmark_sink = benchmark_sink + grads[0];
+        });
+
+    // The SGD update reads the weights and the gradients and
+    // writes both, the gradients are reset for the next batch
+    run_benchmark(std::string("dense/step") + suffix,
+        2.0 * params,
+        elem * 4 * params,
+        [&](){
+            layer.step(0.0, batch_size);
+        });
+}
+
+/**
+ * @brief Benchmark the in place forward and backward of an activation
+ */
+void bench_activation(const char* name, ActivationFn& activation_fn, int batch_size, int features){
+    char suffix[64];
+    std::snprintf(suffix, sizeof(suffix), "/b%d/%d", batch_size, features);
+    double size = (double) batch_size * features;
+
+    Tensor values({batch_size, features}, true);
+    Tensor grads({batch_size, features}, true);
+
+    run_benchmark(std::string("activation/") + name + "/forward" + suffix, 0, sizeof(double) * 2 * size,
+        [&](){
+            activation_fn.forward_inplace(values);
+            benchmark_sink = benchmark_sink + values[0];
+        });
+
+    run_benchmark(std::string("activation/") + name + "/backward" + suffix, 0, sizeof(double) * 3 * size,
+        [&](){
+            activation_fn.backward_inplace(values, grads);
+            benchmark_sink = benchmark_sink + grads[0];
+        });
+}
+
+/**
+ * @brief Benchmark the allocation and the copies of a Tensor
+ */
+void bench_tensor(int size){
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "/%d", size);
+    Tensor source({size}, true);
+    Tensor target({size});
+
+    run_benchmark(std::string("tensor/construct") + suffix, 0, sizeof(double) * (double) size,
+        [&](){
+            Tensor tensor({size});
+            benchmark_sink = benchmark_sink + tensor[0];
+        });
+
+    run_benchmark(std::string("tensor/copy_construct") + suffix, 0, sizeof(double) * 2.0 * size,
+        [&](){
+            Tensor tensor(source);
+            benchmark_sink = benchmark_sink + tensor[0];
+        });
+
+    run_benchmark(std::string("tensor/copy_assign") + suffix, 0, sizeof(double) * 2.0 * size,
+        [&](){
+            target = source;
+            benchmark_sink = benchmark_sink + target[0];
+        });
+}
+
+static void write_idx_int(std::ofstream& file, int value){
+    value = __builtin_bswap32(value);
+    file.write(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Benchmark the batches of the MNIST data loader over
+ * generated IDX files of 28x28 images
+ */
+void bench_mnist(int batch_size){
+    const int count = 10000, pixels = 28 * 28;
+    std::string images_path = "plain_nn_bench_images.idx";
+    std::string labels_path = "plain_nn_bench_labels.idx";
+    {
+        std::ofstream images(images_path, std::ios::binary);
+        write_idx_int(images, 0x00000803);
+        write_idx_int(images, count);
+        write_idx_int(images, 28);
+        write_idx_int(images, 28);
+        std::vector<unsigned char> image(pixels);
+        for(int i = 0; i < count; i++){
+            for(int j = 0; j < pixels; j++) image[j] = (unsigned char) (i * 31 + j * 7);
+            images.write(reinterpret_cast<char*>(image.data()), pixels);
+        }
+
+        std::ofstream labels(labels_path, std::ios::binary);
+        write_idx_int(labels, 0x00000801);
+        write_idx_int(labels, count);
+        for(int i = 0; i < count; i++){
+            unsigned char label = (unsigned char) (i % 10);
+            labels.write(reinterpret_cast<char*>(&label), 1);
+        }
+    }
+
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "/b%d", batch_size);
+
+    // The shuffled loader gathers random images, a new epoch
+    // starts when the batches of the previous one are used
+    MNISTDataLoader loader(images_path, labels_path, true, true);
+    loader.load();
+    int steps = loader.steps_per_epoch(batch_size);
+    int step = 0;
+    BatchData batch;
+    double bytes = (double) batch_size * (pixels + 1 + sizeof(double) * (pixels + 10));
+
+    run_benchmark(std::string("mnist/fill_batch") + suffix, 0, bytes,
+        [&](){
+            if(step++ == steps){
+                loader.new_epoch();
+                step = 1;
+            }
+            loader.fill_batch(batch_size, batch);
+            benchmark_sink = benchmark_sink + batch.input_data[0];
+        });
+
+    run_benchmark(std::string("mnist/get_batch") + suffix, 0, bytes,
+        [&](){
+            if(step++ == steps){
+                loader.new_epoch();
+                step = 1;
+            }
+            BatchData new_batch = loader.get_batch(batch_size);
+            benchmark_sink = benchmark_sink + new_batch.input_data[0];
+        });
+
+    std::remove(images_path.c_str());
+    std::remove(labels_path.c_str());
+}
+
+void build_mlp(PlainNN& model){
+    model.add_layer(new Input({784}));
+    model.add_layer(new Dense(128, new ReLU()));
+    model.add_layer(new Dense(64, new ReLU()));
+    model.add_layer(new Dense(10, new Softmax()));
+}
+
+/**
+ * @brief Benchmark saving and loading a 784-128-64-10 model
+ */
+void bench_storage(){
+    PlainNN model;
+    build_mlp(model);
+    std::string file_name = "plain_nn_bench_model";
+
+    double params = 0;
+    for(int layer_idx = 1; layer_idx < 4; layer_idx++) params += model.get_layer(layer_idx)->get_saveable_params().size();
+    double bytes = sizeof(double) * params;
+
+    run_benchmark("model_storage/save", 0, bytes,
+        [&](){
+            model.save(file_name);
+        });
+
+    run_benchmark("model_storage/load", 0, bytes,
+        [&](){
+            PlainNN loaded;
+            loaded.load(file_name);
+            benchmark_sink = benchmark_sink + loaded.get_layer(1)->get_params()->data()[0];
+        });
+
+    run_benchmark("model_storage/load_weights", 0, bytes,
+        [&](){
+            model.load(file_name, true);
+        });
+
+    std::remove((file_name + MODEL_ARCH_FILE_EXT).c_str());
+    std::remove((file_name + MODEL_WEIGHTS_FILE_EXT).c_str());
+}
+
+/**
+ * @brief Benchmark the end to end inference of a 784-128-64-10 model
+ */
+void bench_model(int batch_size){
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "/b%d", batch_size);
+
+    PlainNN model;
+    build_mlp(model);
+    model.compile(batch_size);
+
+    Tensor input = batch_size > 1 ? Tensor({batch_size, 784}, true) : Tensor({784}, true);
+    double flops = 2.0 * batch_size * (784 * 128 + 128 * 64 + 64 * 10);
+    double bytes = sizeof(double) * ((784 * 128 + 128 * 64 + 64 * 10) + (double) batch_size * (784 + 128 + 64 + 10));
+
+    run_benchmark(std::string("model/forward") + suffix, flops, bytes,
+        [&](){
+            Tensor output = model.forward(input);
+            benchmark_sink = benchmark_sink + output[0];
+        });
+
+    run_benchmark(std::string("model/predict") + suffix, flops, bytes,
+        [&](){
+            Tensor& output = model.predict(input);
+            benchmark_sink = benchmark_sink + output[0];
+        });
+}
+
+/**
+ * @brief Escape the quotes and backslashes of a JSON string
+ */
+std::string escape_json(const std::string& str){
+    std::string escaped;
+    for(char c : str){
+        if(c == '"' || c == '\\') escaped += '\\';
+        if(static_cast<unsigned char>(c) >= 0x20) escaped += c;
+    }
+    return escaped;
+}
+
+void write_json(std::string file_name){
+    std::FILE* file = std::fopen(file_name.c_str(), "w");
+    if(file == nullptr){
+        throw std::runtime_error("Error opening benchmark output file: " + file_name);
+    }
+
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::fprintf(file, "{\n  \"context\": {\n");
+    std::fprintf(file, "    \"date\": \"%s\",\n", date);
+    std::fprintf(file, "    \"label\": \"%s\",\n", escape_json(options.label).c_str());
+    std::fprintf(file, "    \"build_type\": \"%s\",\n", PLAIN_NN_BUILD_TYPE);
+    std::fprintf(file, "    \"isa\": \"%s\",\n", ISA_LEVEL_NAMES[get_isa_level()]);
+    std::fprintf(file, "    \"huge_pages\": \"%s\",\n", HUGE_PAGE_MODE_NAMES[huge_page_mode()].c_str());
+    std::fprintf(file, "    \"min_time\": %g,\n", options.min_time);
+    std::fprintf(file, "    \"repetitions\": %d\n", options.repetitions);
+    std::fprintf(file, "  },\n  \"benchmarks\": [\n");
+
+    for(size_t i = 0; i < results.size(); i++){
+        BenchmarkResult& result = results[i];
+        std::fprintf(file, "    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.3f, \"ns_per_op_min\": %.3f, ",
+            escape_json(result.name).c_str(), result.iterations, result.ns_per_op, result.ns_per_op_min);
+        if(result.gflops > 0) std::fprintf(file, "\"gflops\": %.4f, ", result.gflops);
+        else std::fprintf(file, "\"gflops\": null, ");
+        if(result.gbps > 0) std::fprintf(file, "\"gb_per_s\": %.4f}", result.gbps);
+        else std::fprintf(file, "\"gb_per_s\": null}");
+        std::fprintf(file, "%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+}
+
+void print_usage(const char* program){
+    std::printf("Usage: %s [options]\n", program);
+    std::printf("  --filter <text>     Run only the benchmarks whose name contains the text\n");
+    std::printf("  --output <file>     The JSON file of the results, default is plain_nn_bench.json\n");
+    std::printf("  --label <text>      Saved in the results, e.g. the commit being measured\n");
+    std::printf("  --min-time <s>      The minimum time of each repetition, default is 0.1\n");
+    std::printf("  --repetitions <n>   The timed repetitions of each benchmark, default is 5\n");
+    std::printf("  --isa <name>        Force the kernels to scalar, avx2 or avx512\n");
+}
+
+int main(int argc, char* argv[]){
+
+    options.output = "plain_nn_bench.json";
+    options.min_time = 0.1;
+    options.repetitions = 5;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h"){
+            print_usage(argv[0]);
+            return 0;
+        }
+        if(i + 1 >= argc){
+            std::printf("Missing value for %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        if(arg == "--filter") options.filter = value;
+        else if(arg == "--output") options.output = value;
+        else if(arg == "--label") options.label = value;
+        else if(arg == "--min-time") options.min_time = std::atof(value.c_str());
+        else if(arg == "--repetitions") options.repetitions = std::max(1, std::atoi(value.c_str()));
+        else if(arg == "--isa"){
+            int isa = 0;
+            while(isa <= ISA_AVX512 && ISA_LEVEL_NAMES[isa] != value) isa++;
+            if(isa > ISA_AVX512){
+                std::printf("Unknown instruction set: %s\n", value.c_str());
+                return 1;
+            }
+            set_isa_level(static_cast<IsaLevel>(isa));
+        }
+        else{
+            std::printf("Unknown option: %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(std::strcmp(PLAIN_NN_BUILD_TYPE, "Release") != 0){
+        std::printf("Warning: not a Release build, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n");
+    }
+
+    std::printf("Kernels: %s\n", ISA_LEVEL_NAMES[get_isa_level()]);
+    std::printf("_____________________________________________________________________________________________\n");
+    std::printf("%-44s %12s %14s %10s %10s\n", "Benchmark", "Iterations", "ns/op", "GFLOP/s", "GB/s");
+    std::printf("=============================================================================================\n");
+
+    // The sizes of the MNIST models, a square hidden layer
+    // and a single sample as in serving
+    const int dense_sizes[][3] = {
+        {1, 784, 128},
+        {64, 784, 128},
+        {64, 128, 10},
+        {64, 1024, 1024},
+        {256, 784, 512},
+    };
+    for(const int* size : dense_sizes){
+        bench_dense<double>("f64", size[0], size[1], size[2]);
+        bench_dense<float>("f32", size[0], size[1], size[2]);
+    }
+
+    ReLU relu;
+    Sigmoid sigmoid;
+    Tanh tanh;
+    Softmax softmax;
+    bench_activation("relu", relu, 64, 1024);
+    bench_activation("sigmoid", sigmoid, 64, 1024);
+    bench_activation("tanh", tanh, 64, 1024);
+    bench_activation("softmax", softmax, 64, 1024);
+
+    bench_tensor(1024);
+    bench_tensor(1 << 20);
+
+    bench_mnist(64);
+
+    bench_storage();
+
+    bench_model(1);
+    bench_model(64);
+
+    std::printf("_____________________________________________________________________________________________\n");
+
+    write_json(options.output);
+    std::printf("Results written to %s\n", options.output.c_str());
+
+    return 0;
+}
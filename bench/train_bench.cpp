@@ -0,0 +1,324 @@
+#include "plain_nn.hpp"
+#include "kernels.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/resource.h>
+
+#ifndef PLAIN_NN_BUILD_TYPE
+#define PLAIN_NN_BUILD_TYPE ""
+#endif
+
+/**
+ * @brief Command line options of the benchmark
+ */
+struct TrainBenchOptions{
+    std::vector<int> layers;        // @brief The input features, the hidden sizes and the classes
+    std::vector<int> threads;       // @brief The thread counts to measure
+    TrainingStrategy strategy;
+    int batch_size;
+    int samples;                    // @brief The samples of the synthetic dataset
+    int epochs;
+    std::string output;             // @brief The JSON file the results are written to
+    std::string label;              // @brief Free text saved with the results, e.g. the commit
+};
+
+/**
+ * @brief Throughput, latency and memory of a training run
+ */
+struct TrainBenchResult{
+    int num_threads;
+    TrainingStats stats;
+    long int steps;                 // @brief The number of timed steps
+    double p50, p90, p99, max;      // @brief The percentiles of the step latency, in milliseconds
+    double peak_rss;                // @brief The peak resident memory during the run, in MB
+};
+
+/**
+ * @brief Data loader that wraps another one and times the steps, a
+ * step of a thread lasts from one of its batches to the next one
+ *
+ * @note In the synchronous strategy the batches are all requested by
+ * the calling thread, with Hogwild! each worker requests its own.
+ * The last step of an epoch is not timed, no batch follows it.
+ */
+class StepTimer : public DataLoader{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        StepTimer(DataLoader& dataloader, long int max_steps) : m_dataloader(dataloader){
+            m_step_times.reserve(max_steps);
+        }
+
+        void fill_batch(int batch_size, BatchData& batch){
+            Clock::time_point now = Clock::now();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::map<std::thread::id, Clock::time_point>::iterator last = m_last_batch.find(std::this_thread::get_id());
+                if(last != m_last_batch.end()){
+                    std::chrono::duration<double, std::milli> step_time = now - last->second;
+                    m_step_times.push_back(step_time.count());
+                    last->second = now;
+                } else{
+                    m_last_batch[std::this_thread::get_id()] = now;
+                }
+            }
+            m_dataloader.fill_batch(batch_size, batch);
+        }
+
+        void new_epoch(){
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_last_batch.clear();
+            m_dataloader.new_epoch();
+        }
+
+        void load(){ m_dataloader.load(); }
+        int num_classes(){ return m_dataloader.num_classes(); }
+        void shuffle(){ m_dataloader.shuffle(); }
+        int steps_per_epoch(int batch_size){ return m_dataloader.steps_per_epoch(batch_size); }
+
+        std::vector<double>& step_times(){ return m_step_times; }
+
+    private:
+        DataLoader& m_dataloader;
+        std::mutex m_mutex;
+        std::map<std::thread::id, Clock::time_point> m_last_batch;
+        std::vector<double> m_step_times;
+};
+
+/**
+ * @brief Reset the peak resident memory of the process, so that
+ * each run reports its own, only supported by Linux
+ */
+void reset_peak_rss(){
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if(clear_refs.is_open()) clear_refs << "5";
+}
+
+/**
+ * @brief Get the peak resident memory of the process
+ *
+ * @return double The peak resident memory in MB
+ */
+double peak_rss(){
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line)){
+        if(line.compare(0, 6, "VmHWM:") == 0){
+            return std::atof(line.c_str() + 6) / 1024.0;
+        }
+    }
+
+    // The maximum since the start of the process
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+double percentile(std::vector<double>& sorted, double p){
+    if(sorted.empty()) return 0;
+    size_t idx = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+std::vector<int> parse_list(std::string value){
+    std::vector<int> list;
+    std::stringstream stream(value);
+    std::string item;
+    while(std::getline(stream, item, ',')){
+        list.push_back(std::atoi(item.c_str()));
+    }
+    return list;
+}
+
+std::string topology_str(std::vector<int>& layers){
+    std::string str;
+    for(size_t i = 0; i < layers.size(); i++){
+        str += (i > 0 ? "-" : "") + std::to_string(layers[i]);
+    }
+    return str;
+}
+
+TrainBenchResult run_training(TrainBenchOptions& options, int num_threads){
+    int features = options.layers.front();
+    int classes = options.layers.back();
+
+    // Every run trains on the same samples
+    SyntheticDataLoader dataloader(options.samples, features, classes);
+    dataloader.load();
+    StepTimer timer(dataloader, (long int) dataloader.steps_per_epoch(options.batch_size) * options.epochs);
+
+    PlainNN model(num_threads);
+    model.set_training_strategy(options.strategy);
+    model.add_layer(new Input({features}));
+    for(size_t i = 1; i + 1 < options.layers.size(); i++){
+        model.add_layer(new Dense(options.layers[i], new ReLU()));
+    }
+    model.add_layer(new Dense(classes, new Softmax()));
+    model.set_loss(new CrossEntropy());
+
+    reset_peak_rss();
+
+    TrainBenchResult result;
+    result.num_threads = num_threads;
+    result.stats = model.train(timer, 0.01, options.epochs, options.batch_size);
+    result.peak_rss = peak_rss();
+
+    std::vector<double>& step_times = timer.step_times();
+    std::sort(step_times.begin(), step_times.end());
+    result.steps = step_times.size();
+    result.p50 = percentile(step_times, 50);
+    result.p90 = percentile(step_times, 90);
+    result.p99 = percentile(step_times, 99);
+    result.max = step_times.empty() ? 0 : step_times.back();
+    return result;
+}
+
+void write_json(TrainBenchOptions& options, std::vector<TrainBenchResult>& results){
+    std::FILE* file = std::fopen(options.output.c_str(), "w");
+    if(file == nullptr){
+        throw std::runtime_error("Error opening benchmark output file: " + options.output);
+    }
+
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::fprintf(file, "{\n  \"context\": {\n");
+    std::fprintf(file, "    \"date\": \"%s\",\n", date);
+    std::fprintf(file, "    \"label\": \"%s\",\n", options.label.c_str());
+    std::fprintf(file, "    \"build_type\": \"%s\",\n", PLAIN_NN_BUILD_TYPE);
+    std::fprintf(file, "    \"isa\": \"%s\",\n", ISA_LEVEL_NAMES[get_isa_level()]);
+    std::fprintf(file, "    \"layers\": \"%s\",\n", topology_str(options.layers).c_str());
+    std::fprintf(file, "    \"strategy\": \"%s\",\n", TRAINING_STRATEGY_NAMES[options.strategy].c_str());
+    std::fprintf(file, "    \"batch_size\": %d,\n", options.batch_size);
+    std::fprintf(file, "    \"samples\": %d,\n", options.samples);
+    std::fprintf(file, "    \"epochs\": %d\n", options.epochs);
+    std::fprintf(file, "  },\n  \"runs\": [\n");
+
+    for(size_t i = 0; i < results.size(); i++){
+        TrainBenchResult& result = results[i];
+        std::fprintf(file, "    {\"threads\": %d, \"samples_per_sec\": %.1f, \"train_time\": %.4f, \"loader_time\": %.4f, "
+            "\"steps\": %ld, \"step_ms\": {\"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}, \"peak_rss_mb\": %.1f}%s\n",
+            result.num_threads, result.stats.samples_per_sec, result.stats.train_time, result.stats.loader_time,
+            result.steps, result.p50, result.p90, result.p99, result.max, result.peak_rss,
+            i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+}
+
+void print_usage(const char* program){
+    std::printf("Usage: %s [options]\n", program);
+    std::printf("  --layers <list>     Input features, hidden sizes and classes, default is 784,128,10\n");
+    std::printf("  --threads <list>    The thread counts to measure, default is 1 and all the cores\n");
+    std::printf("  --strategy <name>   synchronous or hogwild, default is synchronous\n");
+    std::printf("  --batch-size <n>    Default is 64\n");
+    std::printf("  --samples <n>       The samples of the synthetic dataset, default is 60000\n");
+    std::printf("  --epochs <n>        Default is 1\n");
+    std::printf("  --output <file>     The JSON file of the results, default is train_bench.json\n");
+    std::printf("  --label <text>      Saved in the results, e.g. the commit being measured\n");
+}
+
+int main(int argc, char* argv[]){
+
+    TrainBenchOptions options;
+    options.layers = {784, 128, 10};
+    options.threads = {1};
+    int cores = std::thread::hardware_concurrency();
+    if(cores > 1) options.threads.push_back(cores);
+    options.strategy = TrainingStrategy::SYNCHRONOUS;
+    options.batch_size = 64;
+    options.samples = 60000;
+    options.epochs = 1;
+    options.output = "train_bench.json";
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h"){
+            print_usage(argv[0]);
+            return 0;
+        }
+        if(i + 1 >= argc){
+            std::printf("Missing value for %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        if(arg == "--layers") options.layers = parse_list(value);
+        else if(arg == "--threads") options.threads = parse_list(value);
+        else if(arg == "--batch-size") options.batch_size = std::atoi(value.c_str());
+        else if(arg == "--samples") options.samples = std::atoi(value.c_str());
+        else if(arg == "--epochs") options.epochs = std::atoi(value.c_str());
+        else if(arg == "--output") options.output = value;
+        else if(arg == "--label") options.label = value;
+        else if(arg == "--strategy"){
+            if(value == TRAINING_STRATEGY_NAMES[TrainingStrategy::SYNCHRONOUS]) options.strategy = TrainingStrategy::SYNCHRONOUS;
+            else if(value == TRAINING_STRATEGY_NAMES[TrainingStrategy::HOGWILD]) options.strategy = TrainingStrategy::HOGWILD;
+            else{
+                std::printf("Unknown training strategy: %s\n", value.c_str());
+                return 1;
+            }
+        }
+        else{
+            std::printf("Unknown option: %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.layers.size() < 2 || options.batch_size < 1 || options.samples < options.batch_size || options.epochs < 1){
+        std::printf("At least the input features and the classes, and enough samples for a batch are needed\n");
+        return 1;
+    }
+    for(size_t i = 0; i < options.threads.size(); i++){
+        if(options.threads[i] < 1){
+            std::printf("The thread counts must be at least 1\n");
+            return 1;
+        }
+    }
+
+    if(std::strcmp(PLAIN_NN_BUILD_TYPE, "Release") != 0){
+        std::printf("Warning: not a Release build, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n");
+    }
+
+    std::vector<TrainBenchResult> results;
+    for(size_t i = 0; i < options.threads.size(); i++){
+        std::printf("Training %s with %d thread%s\n", topology_str(options.layers).c_str(),
+            options.threads[i], options.threads[i] > 1 ? "s" : "");
+        results.push_back(run_training(options, options.threads[i]));
+    }
+
+    std::printf("_____________________________________________________________________________________\n");
+    std::printf("Model: %s - %s - batch size %d - %d samples - %d epoch%s\n", topology_str(options.layers).c_str(),
+        TRAINING_STRATEGY_NAMES[options.strategy].c_str(), options.batch_size, options.samples,
+        options.epochs, options.epochs > 1 ? "s" : "");
+    std::printf("%-8s %12s %10s %10s %10s %10s %10s %12s\n", "Threads", "Samples/s", "Speedup",
+        "p50 (ms)", "p90 (ms)", "p99 (ms)", "Max (ms)", "Peak RSS (MB)");
+    std::printf("=====================================================================================\n");
+    for(size_t i = 0; i < results.size(); i++){
+        TrainBenchResult& result = results[i];
+        std::printf("%-8d %12.0f %9.2fx %10.3f %10.3f %10.3f %10.3f %12.1f\n", result.num_threads,
+            result.stats.samples_per_sec, result.stats.samples_per_sec / results[0].stats.samples_per_sec,
+            result.p50, result.p90, result.p99, result.max, result.peak_rss);
+    }
+    std::printf("_____________________________________________________________________________________\n");
+
+    write_json(options, results);
+    std::printf("Results written to %s\n", options.output.c_str());
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "plain_nn.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Time needed by a training strategy to reach the target accuracy
+ */
+struct BenchmarkResult{
+    TrainingStrategy strategy;
+    int epochs;                 // @brief The number of epochs trained
+    double train_time;          // @brief The time spent training, evaluation excluded
+    double accuracy;            // @brief The test accuracy after the last epoch
+    bool reached;               // @brief Whether the target accuracy was reached
+};
+
+int main(int argc, char* argv[]){
+
+    // Each strategy trains until the test accuracy reaches the target
+    // or the maximum number of epochs is done, the number of threads
+    // defaults to the number of cores
+    double target_accuracy = 0.95;
+    int max_epochs = 10;
+    int num_threads = std::thread::hardware_concurrency();
+    if(argc > 1) target_accuracy = std::atof(argv[1]);
+    if(argc > 2) max_epochs = std::atoi(argv[2]);
+    if(argc > 3) num_threads = std::atoi(argv[3]);
+    if(num_threads < 1) num_threads = 1;
+
+    MNISTDataLoader data_loader("../../data/mnist_dataset/train-images-idx3-ubyte", "../../data/mnist_dataset/train-labels-idx1-ubyte", true, true);
+    data_loader.load();
+
+    MNISTDataLoader test_data_loader("../../data/mnist_dataset/t10k-images-idx3-ubyte", "../../data/mnist_dataset/t10k-labels-idx1-ubyte", true, true);
+    test_data_loader.load();
+
+    const TrainingStrategy strategies[] = {TrainingStrategy::SYNCHRONOUS, TrainingStrategy::HOGWILD};
+
+    std::vector<BenchmarkResult> results;
+    for(TrainingStrategy strategy : strategies){
+        PlainNN model(num_threads);
+        model.set_training_strategy(strategy);
+        model.add_layer(new Input({784}));
+        model.add_layer(new Dense(128, new ReLU()));
+        model.add_layer(new Dense(10, new Sigmoid()));
+
+        std::printf("Training with the %s strategy and %d threads\n", TRAINING_STRATEGY_NAMES[strategy].c_str(), num_threads);
+
+        BenchmarkResult result = {strategy, 0, 0, 0, false};
+        while(result.epochs < max_epochs && !result.reached){
+            TrainingStats stats = model.train(data_loader, 0.01, 1, 64);
+            data_loader.new_epoch();
+
+            EvaluationResult evaluation = model.evaluate(test_data_loader, 100, false);
+
+            result.epochs++;
+            result.train_time += stats.train_time;
+            result.accuracy = evaluation.accuracy;
+            result.reached = evaluation.accuracy >= target_accuracy;
+            std::printf("Test accuracy: %.04f\n", evaluation.accuracy);
+        }
+        results.push_back(result);
+    }
+
+    std::printf("___________________________________________________________\n");
+    std::printf("Target accuracy: %.04f\n", target_accuracy);
+    std::printf("%-12s %8s %12s %12s %12s\n", "Strategy", "Epochs", "Accuracy", "Time (s)", "Reached");
+    std::printf("===========================================================\n");
+    for(size_t i = 0; i < results.size(); i++){
+        std::printf("%-12s %8d %12.4f %12.2f %12s\n", TRAINING_STRATEGY_NAMES[results[i].strategy].c_str(),
+            results[i].epochs, results[i].accuracy, results[i].train_time, results[i].reached ? "yes" : "no");
+    }
+    std::printf("___________________________________________________________\n");
+
+    return 0;
+}
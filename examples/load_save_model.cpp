@@ -17,7 +17,7 @@ int main(){
     // Evaluate the model on the test datasets
     MNISTDataLoader test_dataloader("../../data/mnist_dataset/t10k-images-idx3-ubyte", "../../data/mnist_dataset/t10k-labels-idx1-ubyte", true, true);
     test_dataloader.load();
-    EvaluationResult res = saved_model.evaluate(train_dataloader);
+    EvaluationResult res = saved_model.evaluate(train_dataloader, 100);
     std::printf("Correct: %d/%d\n", res.correct, res.total);
 
     // Save the new model
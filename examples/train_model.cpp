@@ -28,7 +28,7 @@ int main(){
     test_data_loader.load();
 
     // Evaluate the model on the test dataset
-    EvaluationResult result = model.evaluate(test_data_loader);
+    EvaluationResult result = model.evaluate(test_data_loader, 100);
 
     std::printf("Correct: %d/%d\n", result.correct, result.total);
 
@@ -0,0 +1,59 @@
+#include "plain_nn.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <memory>
+
+int main(int argc, char* argv[]){
+
+    // The maximum number of threads defaults to the number of cores,
+    // the model is trained for one epoch with 1, 2, 4, ... threads
+    int max_threads = std::thread::hardware_concurrency();
+    if(argc > 1) max_threads = std::atoi(argv[1]);
+    if(max_threads < 1) max_threads = 1;
+
+    // Batches are prefetched on a background thread when a depth is given
+    int prefetch_depth = 0;
+    if(argc > 2) prefetch_depth = std::atoi(argv[2]);
+
+    MNISTDataLoader data_loader("../../data/mnist_dataset/train-images-idx3-ubyte", "../../data/mnist_dataset/train-labels-idx1-ubyte", true, true);
+    data_loader.load();
+
+    DataLoader* train_loader = &data_loader;
+    std::unique_ptr<PrefetchDataLoader> prefetch_loader;
+    if(prefetch_depth > 0){
+        prefetch_loader.reset(new PrefetchDataLoader(data_loader, prefetch_depth));
+        train_loader = prefetch_loader.get();
+    }
+
+    std::vector<int> thread_counts;
+    for(int num_threads = 1; num_threads < max_threads; num_threads *= 2){
+        thread_counts.push_back(num_threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::vector<TrainingStats> results;
+    for(size_t i = 0; i < thread_counts.size(); i++){
+        PlainNN model(thread_counts[i]);
+        model.add_layer(new Input({784}));
+        model.add_layer(new Dense(128, new ReLU()));
+        model.add_layer(new Dense(10, new Sigmoid()));
+
+        std::printf("Training with %d threads\n", thread_counts[i]);
+        results.push_back(model.train(*train_loader, 0.01, 1, 64));
+        train_loader->new_epoch();
+    }
+
+    std::printf("__________________________________________________________________________\n");
+    std::printf("%-12s %15s %15s %15s %12s\n", "Threads", "Samples/s", "Time (s)", "Loader (s)", "Speedup");
+    std::printf("==========================================================================\n");
+    for(size_t i = 0; i < results.size(); i++){
+        std::printf("%-12d %15.0f %15.2f %15.2f %11.2fx\n", results[i].num_threads, results[i].samples_per_sec,
+            results[i].train_time, results[i].loader_time, results[i].samples_per_sec / results[0].samples_per_sec);
+    }
+    std::printf("__________________________________________________________________________\n");
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#ifndef PLAIN_NN_INFERENCE_PROTOCOL
+#define PLAIN_NN_INFERENCE_PROTOCOL
+
+/**
+ * Wire format shared by inference_server and load_generator, all
+ * values in the byte order of the host:
+ * - on connect the server sends three uint64, the input and the output
+ *   size of the model and the largest number of samples of a request
+ * - a request is a uint64 count followed by count doubles, one or more
+ *   samples of input_size features back to back
+ * - the reply is a uint64 count followed by count doubles, output_size
+ *   values per sample. A count of 0 means the request was rejected and
+ *   the server closes the connection
+ *
+ * A single sample request is the same as the messages of the former
+ * stdin loop of live_demo.
+ */
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// @brief The socket used when neither --socket nor --port are given
+#define DEFAULT_SOCKET_PATH "/tmp/plain_nn.sock"
+
+/**
+ * @brief Read exactly size bytes from a socket
+ *
+ * @param fd The socket
+ * @param buff The buffer to read into
+ * @param size The number of bytes to read
+ * @return bool False if the peer closed the connection or on error
+ */
+inline bool read_full(int fd, void* buff, size_t size){
+    char* _buff = static_cast<char*>(buff);
+    while(size > 0){
+        ssize_t count = ::read(fd, _buff, size);
+        if(count < 0 && errno == EINTR) continue;
+        if(count <= 0) return false;
+        _buff += count;
+        size -= count;
+    }
+    return true;
+}
+
+/**
+ * @brief Write exactly size bytes to a socket
+ *
+ * @param fd The socket
+ * @param buff The buffer to write
+ * @param size The number of bytes to write
+ * @return bool False if the peer closed the connection or on error
+ */
+inline bool write_full(int fd, const void* buff, size_t size){
+    const char* _buff = static_cast<const char*>(buff);
+    while(size > 0){
+        ssize_t count = ::send(fd, _buff, size, MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR) continue;
+        if(count <= 0) return false;
+        _buff += count;
+        size -= count;
+    }
+    return true;
+}
+
+/**
+ * @brief Open a listening socket, a Unix domain socket at
+ * socket_path or a TCP socket on localhost when port is not 0
+ *
+ * @param socket_path The path of the Unix domain socket, an
+ * existing file at the path is replaced
+ * @param port The TCP port, 0 to use the Unix domain socket
+ * @return int The listening socket
+ */
+inline int listen_socket(const std::string& socket_path, int port){
+    int fd;
+    if(port != 0){
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if(fd < 0) throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){
+            ::close(fd);
+            throw std::runtime_error("Cannot bind to 127.0.0.1:" + std::to_string(port) + ": " + std::strerror(errno));
+        }
+    } else {
+        sockaddr_un address = {};
+        if(socket_path.size() >= sizeof(address.sun_path)){
+            throw std::runtime_error("Socket path is too long: " + socket_path);
+        }
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0) throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        ::unlink(socket_path.c_str());
+        if(::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){
+            ::close(fd);
+            throw std::runtime_error("Cannot bind to " + socket_path + ": " + std::strerror(errno));
+        }
+    }
+
+    if(::listen(fd, SOMAXCONN) < 0){
+        ::close(fd);
+        throw std::runtime_error("Cannot listen: " + std::string(std::strerror(errno)));
+    }
+    return fd;
+}
+
+/**
+ * @brief Connect to a server, on the Unix domain socket at
+ * socket_path or on TCP on localhost when port is not 0
+ *
+ * @param socket_path The path of the Unix domain socket
+ * @param port The TCP port, 0 to use the Unix domain socket
+ * @return int The connected socket
+ */
+inline int connect_socket(const std::string& socket_path, int port){
+    int fd;
+    int result;
+    if(port != 0){
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if(fd < 0) throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+
+        // Requests are small, they are sent as soon as they are written
+        int no_delay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        sockaddr_un address = {};
+        if(socket_path.size() >= sizeof(address.sun_path)){
+            throw std::runtime_error("Socket path is too long: " + socket_path);
+        }
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0) throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+
+    if(result < 0){
+        std::string endpoint = port != 0 ? "127.0.0.1:" + std::to_string(port) : socket_path;
+        ::close(fd);
+        throw std::runtime_error("Cannot connect to " + endpoint + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+#endif // PLAIN_NN_INFERENCE_PROTOCOL
@@ -0,0 +1,394 @@
+#include "plain_nn.hpp"
+#include "batch_scheduler.hpp"
+#include "inference_protocol.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+
+/**
+ * @brief Command line options of the server
+ */
+struct ServerOptions{
+    std::string model_path;
+    std::string socket_path;        // @brief The Unix domain socket, used when port is 0
+    int port;                       // @brief The TCP port on localhost
+    int threads;                    // @brief The threads running the forward passes
+    int max_batch_size;             // @brief The largest number of samples of a request, and of a batch when batching
+    double batch_wait;              // @brief The longest wait of a sample for others in milliseconds, 0 disables batching
+    int io_threads;                 // @brief The threads reading the requests when batching
+    std::string trace_path;         // @brief The file the trace is saved to, empty when not tracing
+};
+
+/**
+ * @brief Connections with a request ready to be read, handed from
+ * the thread waiting on the sockets to the workers
+ */
+class ConnectionQueue{
+    public:
+        ConnectionQueue() : m_stop(false){}
+
+        void push(int fd){
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_connections.push_back(fd);
+            }
+            m_cv.notify_one();
+        }
+
+        /**
+         * @brief Wait for a connection
+         *
+         * @return int The connection, or -1 once the server stops
+         */
+        int pop(){
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stop || !m_connections.empty(); });
+            if(m_stop) return -1;
+            int fd = m_connections.front();
+            m_connections.pop_front();
+            return fd;
+        }
+
+        void stop(){
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+        }
+
+    private:
+        std::deque<int> m_connections;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_stop;
+};
+
+// @brief Written by the signal handler to wake up the thread waiting on the sockets
+static int stop_fd = -1;
+
+void handle_stop_signal(__attribute_maybe_unused__ int signal){
+    uint64_t one = 1;
+    ssize_t result = ::write(stop_fd, &one, sizeof(one));
+    (void) result;
+}
+
+/**
+ * @brief Accept the new connections and hand the ones with a
+ * request to read to the workers, until a stop signal
+ *
+ * @note Each connection is registered with EPOLLONESHOT, so that
+ * it is given to a single worker at a time. The worker registers
+ * it again once it has replied.
+ */
+void poll_connections(int listen_fd, int epoll_fd, uint64_t hello[3], bool tcp,
+        ConnectionQueue& queue, std::atomic<long int>& connections){
+    epoll_event events[64];
+    while(true){
+        int count = epoll_wait(epoll_fd, events, 64, -1);
+        if(count < 0){
+            if(errno == EINTR) continue;
+            std::perror("epoll_wait");
+            break;
+        }
+
+        for(int i = 0; i < count; i++){
+            int fd = events[i].data.fd;
+            if(fd == stop_fd){
+                queue.stop();
+                return;
+            }
+
+            if(fd != listen_fd){
+                queue.push(fd);
+                continue;
+            }
+
+            int connection_fd = ::accept(listen_fd, nullptr, nullptr);
+            if(connection_fd < 0) continue;
+
+            if(tcp){
+                int no_delay = 1;
+                setsockopt(connection_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+            }
+
+            // A client that stops in the middle of a request
+            // does not hold a worker for more than a few seconds
+            timeval timeout = {5, 0};
+            setsockopt(connection_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            if(!write_full(connection_fd, hello, 3 * sizeof(uint64_t))){
+                ::close(connection_fd);
+                continue;
+            }
+
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            event.data.fd = connection_fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection_fd, &event);
+            connections++;
+        }
+    }
+    queue.stop();
+}
+
+/**
+ * @brief Serve the requests of the connections handed by the queue
+ * until the server stops, with an inference plan of its own or, when
+ * scheduler is not a null pointer, through the batches of the scheduler
+ *
+ * @note With the scheduler each sample of a request joins the samples
+ * of the other connections in a batch, the worker waits for all of them.
+ * Each request is traced as a read, a predict or a wait for its batches,
+ * and a write
+ */
+void serve_requests(PlainNN& model, ServerOptions& options, int epoll_fd, ConnectionQueue& queue,
+        BatchScheduler* scheduler, std::atomic<long int>& requests, std::atomic<long int>& samples){
+    int input_size = model.input_size();
+    int output_size = model.output_size();
+
+    // The buffers of the worker are allocated once, the first pass grows
+    // the packing buffers of the matrix products of this thread
+    InferencePlan plan;
+    if(scheduler == nullptr){
+        plan = model.create_inference_plan(options.max_batch_size);
+        model.predict(plan.workspaces[0].output, plan);
+    }
+    Tensor input_buffer({options.max_batch_size, input_size});
+    Tensor output_buffer({options.max_batch_size, output_size});
+    std::vector<std::future<Tensor> > outputs;
+    outputs.reserve(options.max_batch_size);
+
+    while(true){
+        int fd = queue.pop();
+        if(fd < 0) return;
+
+        uint64_t count = 0;
+        uint64_t rows = 0;
+        {
+            TraceScope read_scope("read", "server");
+            if(!read_full(fd, &count, sizeof(count))){
+                ::close(fd);
+                continue;
+            }
+
+            rows = count / input_size;
+            if(count == 0 || count % input_size != 0 || rows > static_cast<uint64_t>(options.max_batch_size)){
+                uint64_t rejected = 0;
+                write_full(fd, &rejected, sizeof(rejected));
+                ::close(fd);
+                continue;
+            }
+
+            if(!read_full(fd, input_buffer.data(), count * sizeof(double))){
+                ::close(fd);
+                continue;
+            }
+        }
+
+        // The samples are read in place, the request is a view of its rows
+        Tensor input({static_cast<int>(rows), input_size}, input_buffer.data());
+
+        // A failed forward pass only rejects its request, the
+        // worker keeps serving the other connections
+        const double* _output = nullptr;
+        try{
+            TraceScope predict_scope(scheduler == nullptr ? "predict" : "wait batches", "server");
+            if(scheduler == nullptr){
+                _output = model.predict(input, plan).data();
+            } else{
+                for(uint64_t row = 0; row < rows; row++){
+                    Tensor sample({input_size}, input.data() + row * input_size);
+                    outputs.push_back(scheduler->submit(sample));
+                }
+                for(uint64_t row = 0; row < rows; row++){
+                    Tensor sample_output = outputs[row].get();
+                    std::memcpy(output_buffer.data() + row * output_size, sample_output.data(), output_size * sizeof(double));
+                }
+                _output = output_buffer.data();
+            }
+        } catch(std::exception& e){
+            std::fprintf(stderr, "Request of %lu samples failed: %s\n", static_cast<unsigned long>(rows), e.what());
+        }
+        // The samples already submitted are still run by the scheduler,
+        // their outputs are dropped with the futures
+        outputs.clear();
+
+        if(_output == nullptr){
+            uint64_t rejected = 0;
+            write_full(fd, &rejected, sizeof(rejected));
+            ::close(fd);
+            continue;
+        }
+
+        TraceScope write_scope("write", "server");
+        uint64_t output_count = rows * output_size;
+        if(!write_full(fd, &output_count, sizeof(output_count)) ||
+            !write_full(fd, _output, output_count * sizeof(double))){
+            ::close(fd);
+            continue;
+        }
+
+        requests++;
+        samples += rows;
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    }
+}
+
+void print_usage(const char* program){
+    std::printf("Usage: %s <model_path> [options]\n", program);
+    std::printf("  --socket <path>     The Unix domain socket to listen on, default is %s\n", DEFAULT_SOCKET_PATH);
+    std::printf("  --port <n>          Listen on TCP on 127.0.0.1 instead\n");
+    std::printf("  --threads <n>       The threads running the forward passes, default is all the cores\n");
+    std::printf("  --max-batch <n>     The largest number of samples of a request and of a batch, default is 64\n");
+    std::printf("  --batch-wait <ms>   Batch the samples of concurrent requests, each waiting at most this long, default is 0, disabled\n");
+    std::printf("  --io-threads <n>    The threads reading the requests when batching, default is 16\n");
+    std::printf("  --trace <file>      Trace the requests until the server stops and save the timeline to the file\n");
+}
+
+int main(int argc, char* argv[]){
+
+    ServerOptions options;
+    options.socket_path = DEFAULT_SOCKET_PATH;
+    options.port = 0;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.max_batch_size = 64;
+    options.batch_wait = 0;
+    options.io_threads = 16;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h"){
+            print_usage(argv[0]);
+            return 0;
+        }
+        if(arg.compare(0, 2, "--") != 0){
+            options.model_path = arg;
+            continue;
+        }
+        if(i + 1 >= argc){
+            std::printf("Missing value for %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        if(arg == "--socket") options.socket_path = value;
+        else if(arg == "--port") options.port = std::atoi(value.c_str());
+        else if(arg == "--threads") options.threads = std::atoi(value.c_str());
+        else if(arg == "--max-batch") options.max_batch_size = std::atoi(value.c_str());
+        else if(arg == "--batch-wait") options.batch_wait = std::atof(value.c_str());
+        else if(arg == "--io-threads") options.io_threads = std::atoi(value.c_str());
+        else if(arg == "--trace") options.trace_path = value;
+        else{
+            std::printf("Unknown option: %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.model_path.empty()){
+        print_usage(argv[0]);
+        return 1;
+    }
+    if(options.threads < 1 || options.io_threads < 1 || options.max_batch_size < 1 || options.batch_wait < 0
+        || options.port < 0 || options.port > 65535){
+        std::printf("The threads and the maximum batch size must be at least 1, the batch wait not negative, the port between 1 and 65535\n");
+        return 1;
+    }
+
+    PlainNN model;
+    model.load(options.model_path);
+
+    uint64_t hello[3] = {
+        static_cast<uint64_t>(model.input_size()),
+        static_cast<uint64_t>(model.output_size()),
+        static_cast<uint64_t>(options.max_batch_size)
+    };
+
+    int listen_fd = listen_socket(options.socket_path, options.port);
+    int epoll_fd = epoll_create1(0);
+    stop_fd = eventfd(0, 0);
+    if(epoll_fd < 0 || stop_fd < 0){
+        throw std::runtime_error("Cannot create the event descriptors: " + std::string(std::strerror(errno)));
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.fd = stop_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event);
+
+    std::signal(SIGINT, handle_stop_signal);
+    std::signal(SIGTERM, handle_stop_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if(options.port != 0) std::printf("Listening on 127.0.0.1:%d", options.port);
+    else std::printf("Listening on %s", options.socket_path.c_str());
+    std::printf(" - input size %d, output size %d, up to %d samples per request, %d thread%s\n",
+        model.input_size(), model.output_size(), options.max_batch_size, options.threads, options.threads > 1 ? "s" : "");
+
+    // When batching, the threads of the scheduler run the forward passes
+    // and the workers only read the requests and wait for their outputs
+    BatchScheduler* scheduler = nullptr;
+    int workers = options.threads;
+    if(options.batch_wait > 0){
+        scheduler = new BatchScheduler(model, options.max_batch_size, options.batch_wait, options.threads);
+        workers = options.io_threads;
+        std::printf("Batching up to %d samples, waiting at most %.3f ms, %d I/O threads\n",
+            options.max_batch_size, options.batch_wait, workers);
+    }
+    std::fflush(stdout);
+
+    // One task waits on the sockets, the others serve the requests.
+    // Every task runs until the server stops, so each gets its own thread
+    ConnectionQueue queue;
+    std::atomic<long int> connections(0), requests(0), samples(0);
+    std::chrono::steady_clock::time_point s_time = std::chrono::steady_clock::now();
+
+    if(!options.trace_path.empty()) Tracer::start();
+
+    ThreadPool pool(workers + 1);
+    pool.run(workers + 1, [&](int task){
+        if(task == 0) poll_connections(listen_fd, epoll_fd, hello, options.port != 0, queue, connections);
+        else serve_requests(model, options, epoll_fd, queue, scheduler, requests, samples);
+    });
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - s_time;
+    if(!options.trace_path.empty()){
+        Tracer::stop();
+        Tracer::save(options.trace_path);
+        std::printf("Saved %ld trace events to %s\n", Tracer::num_events(), options.trace_path.c_str());
+    }
+    std::printf("Served %ld requests, %ld samples, over %ld connections in %.1f s\n",
+        requests.load(), samples.load(), connections.load(), elapsed.count());
+    if(scheduler != nullptr){
+        scheduler->print_stats();
+        delete scheduler;
+    }
+
+    ::close(listen_fd);
+    ::close(epoll_fd);
+    ::close(stop_fd);
+    if(options.port == 0) ::unlink(options.socket_path.c_str());
+
+    return 0;
+}
@@ -15,6 +15,11 @@ int main(int argc, char *argv[]){
     PlainNN model;
     model.load(model_path);
 
+    // All the buffers used by the forward pass are allocated
+    // here, the loop below does not allocate
+    model.compile();
+    Tensor input_tensor({784});
+
 
     //size_t input_size = 784 * sizeof(double), output_size = 10 * sizeof(double);
     size_t output_count = 10;
@@ -24,12 +29,9 @@ int main(int argc, char *argv[]){
         // Read the input data
         size_t size = 0;
         std::cin.read(reinterpret_cast<char*>(&size), sizeof(size_t)); // Read vector size
-        std::vector<double> input_vector(784);
-        std::cin.read(reinterpret_cast<char*>(input_vector.data()), size * sizeof(double)); // Read vector data
-
-        Tensor input_tensor({784}, input_vector);
+        std::cin.read(reinterpret_cast<char*>(input_tensor.data()), size * sizeof(double)); // Read vector data
 
-        Tensor output = model.forward(input_tensor);
+        Tensor& output = model.predict(input_tensor);
 
         // Write the output data
         std::cout.write(reinterpret_cast<const char*>(&output_count), sizeof(size_t)); // Write vector size
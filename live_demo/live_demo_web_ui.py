@@ -1,21 +1,47 @@
 import subprocess
+import socket
 import struct
 import pathlib
+import time
 import gradio as gr
 import numpy as np
 
 this_file_path = pathlib.Path(__file__).parent
-# process link to the C++ application
+socket_path = "/tmp/plain_nn_live_demo.sock"
+# process link to the C++ inference server
 # add the argument to the model file to be loaded by the C++ application
 process = subprocess.Popen(
-    ['./bin/live_demo', 'mnist_fc128_relu_fc10_sigmoid'],
-    stdin=subprocess.PIPE,
-    stdout=subprocess.PIPE,
-    stderr=subprocess.PIPE,
+    ['./bin/inference_server', 'mnist_fc128_relu_fc10_sigmoid', '--socket', socket_path],
+    stdout=subprocess.DEVNULL,
     cwd=this_file_path
 )
 
 
+def read_exactly(connection, size):
+    data = b""
+    while len(data) < size:
+        chunk = connection.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("Inference server closed the connection")
+        data += chunk
+    return data
+
+
+# Wait for the server to listen, then read the input size,
+# output size and maximum batch size it sends on connect
+for _ in range(50):
+    try:
+        connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        connection.connect(socket_path)
+        break
+    except (FileNotFoundError, ConnectionRefusedError):
+        connection.close()
+        time.sleep(0.1)
+else:
+    raise RuntimeError("Inference server did not start")
+input_size, output_size, max_batch_size = struct.unpack('3Q', read_exactly(connection, struct.calcsize('3Q')))
+
+
 def run_inference(sketchpad_input):
     
     pil_image = sketchpad_input["composite"]
@@ -29,17 +55,15 @@ def run_inference(sketchpad_input):
     input_vector = input_vector / 255.0  # Normalize pixel values to 0-1
     input_vector = input_vector.flatten(order='C')  # Flatten the image (column-major order)
 
-    # Send the input vector to the C++ program, as <num_items>, <item1>, <item2>, ...
+    # Send the input vector to the inference server, as <num_items>, <item1>, <item2>, ...
     packed_size = struct.pack('Q', len(input_vector))
     packed_vector = struct.pack(f"{len(input_vector)}d", *input_vector)
-    process.stdin.write(packed_size)
-    process.stdin.write(packed_vector)
-    process.stdin.flush()
+    connection.sendall(packed_size + packed_vector)
     
     # Read the size and the result vector (array of doubles)
-    packed_size = process.stdout.read(struct.calcsize('Q'))
+    packed_size = read_exactly(connection, struct.calcsize('Q'))
     result_size = struct.unpack('Q', packed_size)[0]
-    packed_result = process.stdout.read(result_size * struct.calcsize('d'))
+    packed_result = read_exactly(connection, result_size * struct.calcsize('d'))
     result_vector = struct.unpack(f'{result_size}d', packed_result)
 
     return {str(label): conf for label, conf in enumerate(list(result_vector))}
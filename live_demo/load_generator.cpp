@@ -0,0 +1,185 @@
+#include "inference_protocol.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Command line options of the load generator
+ */
+struct LoadOptions{
+    std::string socket_path;        // @brief The Unix domain socket of the server, used when port is 0
+    int port;                       // @brief The TCP port of the server on localhost
+    int clients;                    // @brief The concurrent connections, each on its own thread
+    int requests;                   // @brief The requests sent by each client
+    int batch_size;                 // @brief The samples of each request
+};
+
+/**
+ * @brief The latencies measured by a client
+ */
+struct ClientResult{
+    std::vector<double> latencies;  // @brief The time from sending a request to reading its reply, in milliseconds
+    std::string error;              // @brief Empty unless the client failed
+};
+
+/**
+ * @brief Send the requests of one client, one at a time, waiting
+ * for each reply before sending the next request
+ */
+void run_client(LoadOptions& options, int client_idx, ClientResult& result){
+    typedef std::chrono::steady_clock Clock;
+
+    int fd;
+    try{
+        fd = connect_socket(options.socket_path, options.port);
+    } catch(std::runtime_error& e){
+        result.error = e.what();
+        return;
+    }
+
+    uint64_t hello[3];
+    if(!read_full(fd, hello, sizeof(hello))){
+        result.error = "Connection closed before the model shape was received";
+        ::close(fd);
+        return;
+    }
+    uint64_t input_size = hello[0], output_size = hello[1], max_batch_size = hello[2];
+    if(static_cast<uint64_t>(options.batch_size) > max_batch_size){
+        result.error = "The server accepts up to " + std::to_string(max_batch_size) + " samples per request";
+        ::close(fd);
+        return;
+    }
+
+    // Random samples in [0, 1], like normalized pixels
+    std::mt19937 generator(client_idx);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    uint64_t count = input_size * options.batch_size;
+    std::vector<double> input(count);
+    for(size_t i = 0; i < input.size(); i++) input[i] = distribution(generator);
+
+    uint64_t expected_count = output_size * options.batch_size;
+    std::vector<double> output(expected_count);
+
+    result.latencies.reserve(options.requests);
+    for(int request = 0; request < options.requests; request++){
+        Clock::time_point s_time = Clock::now();
+
+        uint64_t output_count = 0;
+        if(!write_full(fd, &count, sizeof(count)) || !write_full(fd, input.data(), count * sizeof(double))
+            || !read_full(fd, &output_count, sizeof(output_count))){
+            result.error = "Connection closed after " + std::to_string(request) + " requests";
+            break;
+        }
+        if(output_count != expected_count){
+            result.error = "Expected " + std::to_string(expected_count) + " outputs, got " + std::to_string(output_count);
+            break;
+        }
+        if(!read_full(fd, output.data(), output_count * sizeof(double))){
+            result.error = "Connection closed while reading a reply";
+            break;
+        }
+
+        std::chrono::duration<double, std::milli> latency = Clock::now() - s_time;
+        result.latencies.push_back(latency.count());
+    }
+
+    ::close(fd);
+}
+
+double percentile(std::vector<double>& sorted, double p){
+    if(sorted.empty()) return 0;
+    size_t idx = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+void print_usage(const char* program){
+    std::printf("Usage: %s [options]\n", program);
+    std::printf("  --socket <path>     The Unix domain socket of the server, default is %s\n", DEFAULT_SOCKET_PATH);
+    std::printf("  --port <n>          Connect on TCP to 127.0.0.1 instead\n");
+    std::printf("  --clients <n>       The concurrent connections, default is 8\n");
+    std::printf("  --requests <n>      The requests sent by each client, default is 1000\n");
+    std::printf("  --batch-size <n>    The samples of each request, default is 1\n");
+}
+
+int main(int argc, char* argv[]){
+
+    LoadOptions options;
+    options.socket_path = DEFAULT_SOCKET_PATH;
+    options.port = 0;
+    options.clients = 8;
+    options.requests = 1000;
+    options.batch_size = 1;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h"){
+            print_usage(argv[0]);
+            return 0;
+        }
+        if(i + 1 >= argc){
+            std::printf("Missing value for %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        if(arg == "--socket") options.socket_path = value;
+        else if(arg == "--port") options.port = std::atoi(value.c_str());
+        else if(arg == "--clients") options.clients = std::atoi(value.c_str());
+        else if(arg == "--requests") options.requests = std::atoi(value.c_str());
+        else if(arg == "--batch-size") options.batch_size = std::atoi(value.c_str());
+        else{
+            std::printf("Unknown option: %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.clients < 1 || options.requests < 1 || options.batch_size < 1){
+        std::printf("The clients, requests and batch size must be at least 1\n");
+        return 1;
+    }
+
+    std::vector<ClientResult> results(options.clients);
+    std::vector<std::thread> clients;
+
+    std::chrono::steady_clock::time_point s_time = std::chrono::steady_clock::now();
+    for(int i = 0; i < options.clients; i++){
+        clients.push_back(std::thread(run_client, std::ref(options), i, std::ref(results[i])));
+    }
+    for(size_t i = 0; i < clients.size(); i++) clients[i].join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - s_time;
+
+    std::vector<double> latencies;
+    int failed = 0;
+    for(size_t i = 0; i < results.size(); i++){
+        if(!results[i].error.empty()){
+            std::printf("Client %zu: %s\n", i, results[i].error.c_str());
+            failed++;
+        }
+        latencies.insert(latencies.end(), results[i].latencies.begin(), results[i].latencies.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    double requests_per_sec = latencies.size() / elapsed.count();
+
+    std::printf("_____________________________________________________________________________________\n");
+    std::printf("%d client%s - %d requests each - %d sample%s per request\n", options.clients, options.clients > 1 ? "s" : "",
+        options.requests, options.batch_size, options.batch_size > 1 ? "s" : "");
+    std::printf("%-10s %12s %12s %10s %10s %10s %10s\n", "Requests", "Requests/s", "Samples/s",
+        "p50 (ms)", "p90 (ms)", "p99 (ms)", "Max (ms)");
+    std::printf("=====================================================================================\n");
+    std::printf("%-10zu %12.0f %12.0f %10.3f %10.3f %10.3f %10.3f\n", latencies.size(), requests_per_sec,
+        requests_per_sec * options.batch_size, percentile(latencies, 50), percentile(latencies, 90),
+        percentile(latencies, 99), latencies.empty() ? 0 : latencies.back());
+    std::printf("_____________________________________________________________________________________\n");
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+#ifndef PLAIN_NN_ALIGNED_BUFFER_H
+#define PLAIN_NN_ALIGNED_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief Alignment in bytes of the aligned buffers, a cache line
+ * and the width of an AVX-512 register
+ */
+const size_t BUFFER_ALIGNMENT = 64;
+
+/**
+ * @brief Size in bytes of a huge page, buffers of at least this
+ * size are mapped on their own and aligned to it
+ */
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * @brief Enum to hold how the large buffers are backed
+ */
+enum HugePageMode{
+    HUGE_PAGES_OFF,             // @brief Regular pages only
+    HUGE_PAGES_TRANSPARENT,     // @brief Transparent huge pages requested with madvise, the default
+    HUGE_PAGES_EXPLICIT,        // @brief Pages from the reserved hugetlbfs pool, transparent ones when it is empty
+};
+
+const std::string HUGE_PAGE_MODE_NAMES[] = {
+    "Off",
+    "Transparent",
+    "Explicit",
+};
+
+/**
+ * @brief Set how the buffers of HUGE_PAGE_SIZE bytes or more
+ * allocated from now on are backed
+ * 
+ * @param mode The huge page mode
+ */
+void set_huge_page_mode(HugePageMode mode);
+
+/**
+ * @brief Get how the large buffers are backed
+ * 
+ * @return HugePageMode The huge page mode
+ */
+HugePageMode huge_page_mode();
+
+/**
+ * @brief Allocate memory aligned to BUFFER_ALIGNMENT
+ * 
+ * @param bytes The number of bytes
+ * @return void* The memory, a null pointer if bytes is 0
+ * 
+ * @note Buffers of HUGE_PAGE_SIZE bytes or more are mapped directly,
+ * aligned to HUGE_PAGE_SIZE and backed according to huge_page_mode(),
+ * their memory is zero initialized. Throws a std::bad_alloc if the
+ * memory can not be allocated.
+ */
+void* aligned_allocate(size_t bytes);
+
+/**
+ * @brief Free memory returned by aligned_allocate
+ * 
+ * @param ptr The memory, can be a null pointer
+ * @param bytes The number of bytes it was allocated with
+ */
+void aligned_free(void* ptr, size_t bytes);
+
+/**
+ * @brief Allocator for the standard containers that gets
+ * its memory from aligned_allocate
+ * 
+ * @tparam T The element type
+ */
+template<typename T>
+class BasicAlignedAllocator{
+    public:
+        typedef T value_type;
+
+        // Stateless, the memory of a vector can be moved to any other
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type is_always_equal;
+
+        BasicAlignedAllocator() noexcept {}
+
+        template<typename U>
+        BasicAlignedAllocator(__attribute_maybe_unused__ const BasicAlignedAllocator<U>& other) noexcept {}
+
+        T* allocate(size_t n){ return static_cast<T*>(aligned_allocate(n * sizeof(T))); }
+        void deallocate(T* ptr, size_t n) noexcept { aligned_free(ptr, n * sizeof(T)); }
+};
+
+template<typename T, typename U>
+bool operator==(const BasicAlignedAllocator<T>&, const BasicAlignedAllocator<U>&){ return true; }
+
+template<typename T, typename U>
+bool operator!=(const BasicAlignedAllocator<T>&, const BasicAlignedAllocator<U>&){ return false; }
+
+/**
+ * @brief Vector whose elements start on a BUFFER_ALIGNMENT boundary,
+ * the storage of the tensors
+ */
+template<typename T>
+using BasicAlignedVector = std::vector<T, BasicAlignedAllocator<T> >;
+
+typedef BasicAlignedVector<double> AlignedVector;
+typedef BasicAlignedVector<float> AlignedVectorF;
+
+/**
+ * @brief Zero initialized array aligned to BUFFER_ALIGNMENT, used
+ * for the large arenas that hold all the parameters of a model,
+ * see aligned_allocate for the backing of large arrays
+ * 
+ * @tparam T The element type, either float or double
+ */
+template<typename T>
+class BasicAlignedBuffer{
+    public:
+        BasicAlignedBuffer();
+        ~BasicAlignedBuffer();
+
+        BasicAlignedBuffer(const BasicAlignedBuffer&) = delete;
+        BasicAlignedBuffer& operator=(const BasicAlignedBuffer&) = delete;
+
+        BasicAlignedBuffer(BasicAlignedBuffer&& other) noexcept;
+        BasicAlignedBuffer& operator=(BasicAlignedBuffer&& other) noexcept;
+
+        /**
+         * @brief Allocate a new array of zeros, releasing the previous one
+         * 
+         * @param size The number of elements
+         * 
+         * @note Throws a std::runtime_error if the memory can not be allocated
+         */
+        void allocate(long int size);
+
+        /**
+         * @brief Release the array, does nothing if none is allocated
+         */
+        void release();
+
+        /**
+         * @brief Set all the elements to 0
+         */
+        void clear();
+
+        /**
+         * @brief Get the elements of the buffer
+         * 
+         * @return T* The first element, or a null pointer
+         * if nothing is allocated
+         */
+        T* data(){return m_data;}
+
+        /**
+         * @brief Get the number of elements of the buffer
+         * 
+         * @return long int The number of elements
+         */
+        long int size(){return m_size;}
+
+    private:
+        T* m_data;
+        long int m_size;
+};
+
+typedef BasicAlignedBuffer<double> AlignedBuffer;
+typedef BasicAlignedBuffer<float> AlignedBufferF;
+
+/**
+ * @brief Round a number of elements up so that the next element
+ * starts on a BUFFER_ALIGNMENT boundary
+ * 
+ * @param count The number of elements
+ * @return long int The padded number of elements
+ */
+template<typename T>
+long int align_count(long int count){
+    const long int elements = BUFFER_ALIGNMENT / sizeof(T);
+    return (count + elements - 1) / elements * elements;
+}
+
+#endif // PLAIN_NN_ALIGNED_BUFFER_H
@@ -0,0 +1,143 @@
+#ifndef PLAIN_NN_BATCH_SCHEDULER_H
+#define PLAIN_NN_BATCH_SCHEDULER_H
+
+#include "plain_nn.hpp"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <chrono>
+
+/**
+ * @brief Struct to hold the metrics of a batch scheduler since its
+ * construction or the last call to reset_stats
+ */
+struct BatchSchedulerStats{
+    long int requests;                  // @brief The number of requests run in a batch
+    long int batches;                   // @brief The number of batched forward passes
+    int queue_depth;                    // @brief The number of requests waiting for a batch
+    int max_queue_depth;                // @brief The largest number of requests that waited at the same time
+    std::vector<long int> batch_sizes;  // @brief The number of batches of each size, indexed by the size, up to the maximum batch size
+    double avg_batch_size;              // @brief The average number of requests per batch
+    double avg_queue_time;              // @brief The average time from submit to the start of the batch, in milliseconds
+    double max_queue_time;              // @brief The longest time from submit to the start of the batch, in milliseconds
+};
+
+/**
+ * @brief Queue in front of a model that coalesces the samples
+ * submitted concurrently by several threads into batches, so that
+ * each weight loaded by a forward pass is used for many samples.
+ *
+ * A batch starts as soon as max_batch_size samples are waiting or
+ * when the oldest one has waited max_wait_ms, whichever comes first.
+ * The output of each sample is handed back through a future.
+ *
+ * @note The model must outlive the scheduler and must not be trained
+ * or modified while the scheduler runs. The samples still waiting
+ * when the scheduler is destroyed are run before it returns.
+ */
+template<typename T>
+class BasicBatchScheduler{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * @brief Construct a new BatchScheduler object and start its threads
+         *
+         * @param model The model running the batches
+         * @param max_batch_size The largest number of samples of a batch, default is 32
+         * @param max_wait_ms The longest time a sample waits for others
+         * before its batch starts, in milliseconds, default is 1
+         * @param num_threads The number of threads running batches, each
+         * with its own inference plan, default is 1
+         */
+        BasicBatchScheduler(BasicPlainNN<T>& model, int max_batch_size = 32, double max_wait_ms = 1.0, int num_threads = 1);
+        ~BasicBatchScheduler();
+
+        BasicBatchScheduler(const BasicBatchScheduler&) = delete;
+        BasicBatchScheduler& operator=(const BasicBatchScheduler&) = delete;
+
+        /**
+         * @brief Queue a sample for the next batch
+         *
+         * @param sample A single sample of input_size features, copied
+         * before returning
+         * @return std::future<BasicTensor<T> > The output of the model for
+         * the sample, of shape (output_size). If the forward pass fails the
+         * future rethrows its exception
+         */
+        std::future<BasicTensor<T> > submit(BasicTensor<T>& sample);
+
+        /**
+         * @brief Get the metrics of the scheduler
+         *
+         * @return BatchSchedulerStats The metrics since the construction
+         * or the last call to reset_stats
+         */
+        BatchSchedulerStats stats();
+
+        /**
+         * @brief Clear the metrics, the queue depth is kept
+         */
+        void reset_stats();
+
+        /**
+         * @brief Prints the metrics to the console, followed by
+         * the histogram of the batch sizes
+         */
+        void print_stats();
+
+    private:
+
+        /**
+         * @brief A sample waiting for a batch
+         */
+        struct Request{
+            std::vector<T> input;                       // @brief The features of the sample
+            std::promise<BasicTensor<T> > output;       // @brief Fulfilled with the output of the sample
+            Clock::time_point submit_time;
+        };
+
+        BasicPlainNN<T>& m_model;
+        int m_input_size;
+        int m_output_size;
+        int m_max_batch_size;
+        Clock::duration m_max_wait;
+
+        std::deque<Request> m_queue;
+        bool m_stop;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<BasicInferencePlan<T> > m_plans;
+        std::vector<std::thread> m_threads;
+
+        // @brief The metrics, guarded by the mutex
+        BatchSchedulerStats m_stats;
+        double m_total_queue_time;
+
+        /**
+         * @brief Main loop of the threads running the batches
+         *
+         * @param thread_idx The index of the thread, also of its inference plan
+         */
+        void batch_loop(int thread_idx);
+
+        /**
+         * @brief Run a batched forward pass over the requests and hand
+         * each row of the output to its request
+         *
+         * @param requests The requests of the batch
+         * @param batch The buffer the samples are gathered into, of shape (max_batch_size, input_size)
+         * @param plan The inference plan of the thread
+         */
+        void run_batch(std::vector<Request>& requests, BasicTensor<T>& batch, BasicInferencePlan<T>& plan);
+};
+
+typedef BasicBatchScheduler<double> BatchScheduler;
+typedef BasicBatchScheduler<float> BatchSchedulerF;
+
+#endif // PLAIN_NN_BATCH_SCHEDULER_H
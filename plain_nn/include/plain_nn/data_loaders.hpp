@@ -2,62 +2,128 @@
 #define PLAIN_NN_DATA_LOADERS_H
 
 #include "tensor.hpp"
+#include "mapped_file.hpp"
 #include <vector>
 #include <memory>
 #include <string>
 #include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 /**
  * @brief Struct to hold a single item in a dataset
  */
-struct DatasetItem{
-    Tensor data;
+template<typename T>
+struct BasicDatasetItem{
+    BasicTensor<T> data;
     int target;
 };
 
 /**
- * @brief Struct to hold a batch of data
+ * @brief Struct to hold a batch of data, the samples and targets
+ * are stored row by row in contiguous buffers
+ *
+ * @note Batches are moved and swapped without copying their buffers,
+ * e.g. by BasicPrefetchDataLoader, the tensors only exchange their storage.
  */
-struct BatchData{
-    std::vector<Tensor> input_data;
-    std::vector<Tensor> targets_one_hot;
-    std::vector<int> targets_idx;
+template<typename T>
+struct BasicBatchData{
+    BasicTensor<T> input_data;          // @brief The samples, of shape (batch_size, features)
+    BasicTensor<T> targets_one_hot;     // @brief The one hot targets, of shape (batch_size, num_classes)
+    std::vector<int> targets_idx;       // @brief The class index of each sample
+
+    /**
+     * @brief Get the number of samples in the batch
+     * 
+     * @return int The number of samples, 0 if the dataset is exhausted
+     */
+    int size(){ return targets_idx.size(); }
+
+    /**
+     * @brief Resize the batch before it is filled, the buffers are
+     * only reallocated when their shape changes, or when they are views,
+     * so that a batch can be reused across steps. The one hot targets are cleared.
+     * 
+     * @param batch_size The number of samples
+     * @param features The number of features of each sample
+     * @param num_classes The number of classes
+     */
+    void resize(int batch_size, int features, int num_classes){
+        if(input_data.is_view() || input_data.ndim() != 2 || input_data.shape(0) != batch_size || input_data.shape(1) != features){
+            input_data.reshape({batch_size, features});
+        }
+        if(targets_one_hot.is_view() || targets_one_hot.ndim() != 2 || targets_one_hot.shape(0) != batch_size || targets_one_hot.shape(1) != num_classes){
+            targets_one_hot.reshape({batch_size, num_classes});
+        }
+        targets_one_hot.clear();
+        targets_idx.resize(batch_size);
+    }
 };
 
+typedef BasicDatasetItem<double> DatasetItem;
+typedef BasicDatasetItem<float> DatasetItemF;
+typedef BasicBatchData<double> BatchData;
+typedef BasicBatchData<float> BatchDataF;
+
 /**
  * @brief One hot encode a label
  * 
  * @param label_idx The index of the label
  * @param num_classes The number of classes
- * @return Tensor The one hot encoded label
+ * @return BasicTensor<T> The one hot encoded label
  * 
  * @note This function is useful for single label classification tasks.
  * For multi-label classification tasks, implement a different encoding scheme.
  */
-Tensor one_hot_encode(int label_idx, int num_classes);
+template<typename T = double>
+BasicTensor<T> one_hot_encode(int label_idx, int num_classes);
 
 /**
  * @brief Abstract class for data loaders. New data loaders
  * should inherit from this class and implement all of its methods.
+ * 
+ * @tparam T The element type of the produced tensors, either float or double
  */
-class DataLoader{
+template<typename T>
+class BasicDataLoader{
     public:
 
-        ~DataLoader(){};
+        ~BasicDataLoader(){};
 
         /**
          * @brief Load the data into memory
          */
         virtual void load() = 0;
 
+        /**
+         * @brief Fill a batch with the next samples of the dataset
+         * 
+         * @param batch_size The size of the batch
+         * @param batch The batch to fill, resized to the number of samples
+         * read, which is 0 once the dataset is exhausted
+         * 
+         * @note Implementations should gather the samples directly in the
+         * buffers of the batch, see BasicBatchData::resize, so that reusing
+         * the same batch across steps does not allocate.
+         */
+        virtual void fill_batch(int batch_size, BasicBatchData<T>& batch) = 0;
+
         /**
          * @brief Get a batch of data
          * 
          * @param batch_size The size of the batch
-         * @return BatchData The batch of data
+         * @return BasicBatchData<T> The batch of data
          * 
+         * @note A new batch is allocated on every call, use
+         * fill_batch to reuse the same one
          */
-        virtual BatchData get_batch(int batch_size) = 0;
+        BasicBatchData<T> get_batch(int batch_size){
+            BasicBatchData<T> batch;
+            fill_batch(batch_size, batch);
+            return batch;
+        }
         
         /**
          * @brief Start a new epoch. The data loader should
@@ -88,10 +154,19 @@ class DataLoader{
         virtual int steps_per_epoch(int batch_size) = 0;
 };
 
+typedef BasicDataLoader<double> DataLoader;
+typedef BasicDataLoader<float> DataLoaderF;
+
 /**
  * @brief MNIST data loader, can also be used for Fashion MNIST
+ * 
+ * @note The IDX files are memory mapped, the images stay in the
+ * file as raw bytes and are converted and normalized to [0, 1]
+ * only when they are copied in a batch. Loading is nearly instant
+ * and files larger than the available RAM can be used.
  */
-class MNISTDataLoader : public DataLoader{
+template<typename T>
+class BasicMNISTDataLoader : public BasicDataLoader<T>{
     public:
 
         /**
@@ -102,13 +177,13 @@ class MNISTDataLoader : public DataLoader{
          * @param shuffle Whether to shuffle the dataset
          * @param drop_last Whether to drop the last batch if it is smaller than the batch size
          */
-        MNISTDataLoader(
+        BasicMNISTDataLoader(
             std::string data_path, 
             std::string labels_path,
             bool shuffle = true,
             bool drop_last = true);
         
-        BatchData get_batch(int batch_size);
+        void fill_batch(int batch_size, BasicBatchData<T>& batch);
         void new_epoch();
         void load();
         int num_classes();
@@ -116,24 +191,177 @@ class MNISTDataLoader : public DataLoader{
 
         int steps_per_epoch(int batch_size);
     private:
-        std::vector<DatasetItem> m_dataset;
         std::string m_data_path;
         std::string m_labels_path;
 
+        MappedFile m_data_file;
+        MappedFile m_labels_file;
+        const unsigned char* m_images;  // @brief The pixels of the first image in the mapped file
+        const unsigned char* m_labels;  // @brief The first label in the mapped file
+        int m_num_images, m_num_labels;
+        int m_image_size;
+
+        // The samples are shuffled through a permutation of their
+        // indices, the mapped files are never modified
+        std::vector<int> m_indices;
+
         int m_offset;
         bool m_shuffle, m_drop_last;
 
         std::default_random_engine rng;
 
         /**
-         * @brief Load the images data into memory
+         * @brief Map the images file and validate its header
          */
         void load_data();
 
         /**
-         * @brief Load the labels data into memory
+         * @brief Map the labels file and validate its header
          */
         void load_labels();
 };
 
+typedef BasicMNISTDataLoader<double> MNISTDataLoader;
+typedef BasicMNISTDataLoader<float> MNISTDataLoaderF;
+
+/**
+ * @brief Data loader of random samples generated in memory, useful
+ * to benchmark and test training without any dataset on disk
+ *
+ * @note The samples are generated by load() from the seed, two loaders
+ * with the same arguments produce the same batches. Like the MNIST images
+ * the features are stored as bytes and normalized to [0, 1] when they are
+ * copied in a batch, so that batches cost the same as with MNISTDataLoader.
+ */
+template<typename T>
+class BasicSyntheticDataLoader : public BasicDataLoader<T>{
+    public:
+
+        /**
+         * @brief Construct a new SyntheticDataLoader object
+         *
+         * @param num_samples The number of samples in the dataset
+         * @param num_features The number of features of each sample, e.g. 784
+         * @param num_classes The number of classes, the labels are uniformly distributed
+         * @param seed The seed of the samples and of the shuffling, default is 42
+         * @param shuffle Whether to shuffle the dataset
+         * @param drop_last Whether to drop the last batch if it is smaller than the batch size
+         */
+        BasicSyntheticDataLoader(
+            int num_samples,
+            int num_features,
+            int num_classes,
+            unsigned int seed = 42,
+            bool shuffle = true,
+            bool drop_last = true);
+
+        void fill_batch(int batch_size, BasicBatchData<T>& batch);
+        void new_epoch();
+        void load();
+        int num_classes();
+        void shuffle();
+
+        int steps_per_epoch(int batch_size);
+    private:
+        int m_num_samples;
+        int m_num_features;
+        int m_num_classes;
+        unsigned int m_seed;
+
+        std::vector<unsigned char> m_features;  // @brief The features of the samples, row by row
+        std::vector<int> m_labels;
+        std::vector<int> m_indices;             // @brief The permutation of the samples of this epoch
+
+        int m_offset;
+        bool m_shuffle, m_drop_last;
+
+        std::default_random_engine rng;
+};
+
+typedef BasicSyntheticDataLoader<double> SyntheticDataLoader;
+typedef BasicSyntheticDataLoader<float> SyntheticDataLoaderF;
+
+/**
+ * @brief Data loader that wraps another one and assembles the next
+ * batches on a background thread while the model trains on the
+ * current one. The batches are kept in a bounded ring, the producer
+ * waits when it is full and the consumer only waits, i.e. stalls,
+ * when it is empty.
+ * 
+ * @note The wrapped data loader must outlive this one and must only
+ * be used through it. The batch size must not change within an epoch,
+ * a new batch size, like shuffle and new_epoch, discards the batches
+ * already prefetched and starts the epoch over.
+ */
+template<typename T>
+class BasicPrefetchDataLoader : public BasicDataLoader<T>{
+    public:
+
+        /**
+         * @brief Construct a new PrefetchDataLoader object
+         * 
+         * @param dataloader The data loader producing the batches
+         * @param depth The number of batches prefetched ahead, default is 2
+         */
+        BasicPrefetchDataLoader(BasicDataLoader<T>& dataloader, int depth = 2);
+        ~BasicPrefetchDataLoader();
+
+        BasicPrefetchDataLoader(const BasicPrefetchDataLoader&) = delete;
+        BasicPrefetchDataLoader& operator=(const BasicPrefetchDataLoader&) = delete;
+
+        void fill_batch(int batch_size, BasicBatchData<T>& batch);
+        void new_epoch();
+        void load();
+        int num_classes();
+        void shuffle();
+
+        int steps_per_epoch(int batch_size);
+
+        /**
+         * @brief Get the time spent waiting for a batch to be ready
+         * 
+         * @return double The time in seconds since the construction
+         */
+        double stall_time();
+
+    private:
+        BasicDataLoader<T>& m_dataloader;
+
+        std::vector<BasicBatchData<T> > m_ring;
+        int m_head;         // @brief The slot of the next batch to consume
+        int m_ready;        // @brief The number of batches ready to be consumed
+
+        int m_batch_size;   // @brief The batch size being prefetched, 0 before the first request
+        int m_remaining;    // @brief The number of batches left to produce in this epoch
+        bool m_filling;     // @brief Whether the producer is filling a slot
+        bool m_stop;
+
+        double m_stall_time;
+        std::exception_ptr m_error;
+
+        std::mutex m_mutex;
+        std::condition_variable m_ready_cv;
+        std::condition_variable m_free_cv;
+        std::thread m_producer;
+
+        /**
+         * @brief Main loop of the producer thread
+         */
+        void producer_loop();
+
+        /**
+         * @brief Wait for the producer to be idle and discard the
+         * prefetched batches, the lock must be held
+         */
+        void drain(std::unique_lock<std::mutex>& lock);
+
+        /**
+         * @brief Start prefetching the batches of an epoch, the lock must be held
+         */
+        void restart(int batch_size);
+};
+
+typedef BasicPrefetchDataLoader<double> PrefetchDataLoader;
+typedef BasicPrefetchDataLoader<float> PrefetchDataLoaderF;
+
 #endif // PLAIN_NN_DATA_LOADERS_H
\ No newline at end of file
@@ -0,0 +1,174 @@
+#ifndef PLAIN_NN_KERNELS_GEMM_H
+#define PLAIN_NN_KERNELS_GEMM_H
+
+/**
+ * @brief Whether an operand of a matrix product should
+ * be used as is or transposed
+ */
+enum GemmTranspose{
+    NO_TRANS,
+    TRANS
+};
+
+/**
+ * @brief Operations applied by gemm to the elements of C once they
+ * hold their final value, while they are still in cache
+ * 
+ * @tparam T The element type of C
+ */
+template<typename T>
+struct BasicGemmEpilogue{
+    const T* bias;                                                      // @brief Added to every row of C, skipped if null
+    void (*activation)(int n, const T* x, T* out);                      // @brief Applied in place to each element after the bias, skipped if null
+    void (*row_activation)(int rows, int cols, const T* x, T* out);     // @brief Applied in place to whole rows of C after the bias, skipped if null
+};
+
+typedef BasicGemmEpilogue<double> GemmEpilogue;
+typedef BasicGemmEpilogue<float> GemmEpilogueF;
+
+/**
+ * @brief General matrix-matrix product on row-major matrices
+ * 
+ * C = alpha * op(A) * op(B) + beta * C
+ * 
+ * where op(A) is a (m, k) matrix, op(B) is a (k, n) matrix and
+ * C is a (m, n) matrix.
+ * 
+ * @param trans_a Whether A is stored transposed, i.e. as a (k, m) matrix
+ * @param trans_b Whether B is stored transposed, i.e. as a (n, k) matrix
+ * @param m The number of rows of op(A) and C
+ * @param n The number of columns of op(B) and C
+ * @param k The number of columns of op(A) and rows of op(B)
+ * @param alpha The scaling factor of the product
+ * @param a The data of A
+ * @param lda The distance between two consecutive rows of A as stored
+ * @param b The data of B
+ * @param ldb The distance between two consecutive rows of B as stored
+ * @param beta The scaling factor of C, if 0 the content of C is ignored
+ * @param c The data of C
+ * @param ldc The distance between two consecutive rows of C
+ * 
+ * @note The product is cache blocked: panels of op(B) and blocks of
+ * op(A) are packed in contiguous buffers sized for the L2 and L1 caches
+ * and the result is computed by a register tiled micro-kernel.
+ */
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    double alpha,
+    const double* a, int lda,
+    const double* b, int ldb,
+    double beta,
+    double* c, int ldc
+);
+
+/**
+ * @brief Single precision overload of gemm
+ */
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    float alpha,
+    const float* a, int lda,
+    const float* b, int ldb,
+    float beta,
+    float* c, int ldc
+);
+
+/**
+ * @brief General matrix-matrix product followed by an epilogue
+ * 
+ * C = epilogue(alpha * op(A) * op(B) + beta * C)
+ * 
+ * @param epilogue The bias and activation applied to C, see gemm
+ * for the other parameters
+ * 
+ * @note The bias and element-wise activation are applied to each
+ * register tile right after its last update, the row activation
+ * to each block of rows once all of its columns are computed. This
+ * saves the separate passes over C that would otherwise follow.
+ */
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    double alpha,
+    const double* a, int lda,
+    const double* b, int ldb,
+    double beta,
+    double* c, int ldc,
+    const GemmEpilogue& epilogue
+);
+
+/**
+ * @brief Single precision overload of gemm with an epilogue
+ */
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    float alpha,
+    const float* a, int lda,
+    const float* b, int ldb,
+    float beta,
+    float* c, int ldc,
+    const GemmEpilogueF& epilogue
+);
+
+/**
+ * @brief General matrix-vector product on a row-major matrix
+ * 
+ * y = alpha * op(A) * x + beta * y
+ * 
+ * where A is stored as a (m, n) matrix.
+ * 
+ * @param trans_a If NO_TRANS, x has n elements and y has m elements,
+ * if TRANS, x has m elements and y has n elements
+ * @param m The number of rows of A as stored
+ * @param n The number of columns of A as stored
+ * @param alpha The scaling factor of the product
+ * @param a The data of A
+ * @param lda The distance between two consecutive rows of A
+ * @param x The input vector
+ * @param beta The scaling factor of y, if 0 the content of y is ignored
+ * @param y The output vector
+ */
+void gemv(
+    GemmTranspose trans_a,
+    int m, int n,
+    double alpha,
+    const double* a, int lda,
+    const double* x,
+    double beta,
+    double* y
+);
+
+/**
+ * @brief Single precision overload of gemv
+ */
+void gemv(
+    GemmTranspose trans_a,
+    int m, int n,
+    float alpha,
+    const float* a, int lda,
+    const float* x,
+    float beta,
+    float* y
+);
+
+/**
+ * @brief Scaled vector addition
+ * 
+ * y = alpha * x + y
+ * 
+ * @param n The number of elements
+ * @param alpha The scaling factor of x
+ * @param x The input vector
+ * @param y The output vector
+ */
+void axpy(int n, double alpha, const double* x, double* y);
+
+/**
+ * @brief Single precision overload of axpy
+ */
+void axpy(int n, float alpha, const float* x, float* y);
+
+#endif // PLAIN_NN_KERNELS_GEMM_H
@@ -0,0 +1,180 @@
+#ifndef PLAIN_NN_KERNELS_KERNELS_H
+#define PLAIN_NN_KERNELS_KERNELS_H
+
+/**
+ * @brief Enum to hold the instruction set used by the kernels
+ */
+enum IsaLevel{
+    ISA_SCALAR,
+    ISA_AVX2,
+    ISA_AVX512
+};
+
+/**
+ * @brief Array of instruction set names, these are also the
+ * values accepted by the `PLAIN_NN_ISA` environment variable
+ * 
+ * @note Defined once in kernels.cpp, so that the translation units
+ * built with the SIMD flags hold no code run before the dispatch
+ */
+extern const char* const ISA_LEVEL_NAMES[];
+
+/**
+ * @brief Hyper parameters of a fused optimizer update, see the
+ * update kernels of BasicKernelTable. The gradients g are the
+ * accumulated error signals, i.e. minus the gradient of the loss.
+ */
+template<typename T>
+struct BasicUpdateParams{
+    T lr;                   // @brief The learning rate
+    T scale;                // @brief Applied to the gradients first, e.g. 1 / batch_size
+    T beta1;                // @brief The momentum, or the decay rate of the first moment
+    T beta2;                // @brief The decay rate of the second moment
+    T eps;                  // @brief Added to the square root of the second moment
+    T weight_decay;         // @brief The decoupled weight decay, 0 for Adam
+    T bias_correction1;     // @brief 1 - beta1^t at the step t
+    T bias_correction2;     // @brief 1 - beta2^t at the step t
+};
+
+typedef BasicUpdateParams<double> UpdateParams;
+typedef BasicUpdateParams<float> UpdateParamsF;
+
+/**
+ * @brief Table of the compute kernels for a single instruction set
+ * and element type. All the matrices are row-major and all the kernels 
+ * work on contiguous arrays of n elements unless stated otherwise.
+ * The activation kernels, their derivatives and backward passes can
+ * run in place, with out pointing to the same array as x, y or dy.
+ */
+template<typename T>
+struct BasicKernelTable{
+    IsaLevel isa;
+
+    // Register tile computed by gemm_micro_kernel, the packed
+    // slivers of op(A) and op(B) are gemm_mr and gemm_nr wide
+    int gemm_mr;
+    int gemm_nr;
+
+    // C[mr, nr] = alpha * A_packed * B_packed + beta * C, only the
+    // top-left (mr, nr) part of the (gemm_mr, gemm_nr) tile is stored
+    void (*gemm_micro_kernel)(int kc, T alpha, const T* a, const T* b, T beta, T* c, int ldc, int mr, int nr);
+
+    // y[m] = alpha * A[m, n] * x + beta * y
+    void (*gemv_n)(int m, int n, T alpha, const T* a, int lda, const T* x, T beta, T* y);
+    // y[n] = alpha * A[m, n]^T * x + beta * y
+    void (*gemv_t)(int m, int n, T alpha, const T* a, int lda, const T* x, T beta, T* y);
+    // y = alpha * x + y
+    void (*axpy)(int n, T alpha, const T* x, T* y);
+    // out[r, :] += bias for each of the rows of out
+    void (*bias_add)(int rows, int cols, const T* bias, T* out);
+    // out = scale * x, converting unsigned 8 bit integers
+    void (*scale_u8)(int n, const unsigned char* x, T scale, T* out);
+
+    // out = max(0, x)
+    void (*relu)(int n, const T* x, T* out);
+    // out = y > 0 ? 1 : 0
+    void (*relu_derivative)(int n, const T* y, T* out);
+    // out = dy * (y > 0 ? 1 : 0)
+    void (*relu_backward)(int n, const T* y, const T* dy, T* out);
+    // out = 1 / (1 + exp(-x))
+    void (*sigmoid)(int n, const T* x, T* out);
+    // out = y * (1 - y)
+    void (*sigmoid_derivative)(int n, const T* y, T* out);
+    // out = dy * y * (1 - y)
+    void (*sigmoid_backward)(int n, const T* y, const T* dy, T* out);
+    // out = tanh(x)
+    void (*tanh)(int n, const T* x, T* out);
+    // out = 1 - y^2
+    void (*tanh_derivative)(int n, const T* y, T* out);
+    // out = dy * (1 - y^2)
+    void (*tanh_backward)(int n, const T* y, const T* dy, T* out);
+    // out[r, :] = exp(x[r, :]) / sum(exp(x[r, :])) for each of the rows
+    void (*softmax)(int rows, int cols, const T* x, T* out);
+    // out[r, :] = y[r, :] * (dy[r, :] - dot(dy[r, :], y[r, :])) for each of the rows,
+    // i.e. dy times the jacobian of the softmax
+    void (*softmax_backward)(int rows, int cols, const T* y, const T* dy, T* out);
+
+    // The optimizer updates read the gradients g once, update the
+    // parameters w and the optimizer state and clear g in the same pass
+    // w += lr * scale * g
+    void (*sgd_update)(int n, const BasicUpdateParams<T>& p, T* w, T* g);
+    // v = beta1 * v + scale * g, w += lr * v
+    void (*momentum_update)(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v);
+    // v = beta1 * v + scale * g, w += lr * (scale * g + beta1 * v)
+    void (*nesterov_update)(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v);
+    // m = beta1 * m + (1 - beta1) * scale * g, v = beta2 * v + (1 - beta2) * (scale * g)^2,
+    // w = (1 - lr * weight_decay) * w + lr * (m / bias_correction1) / (sqrt(v / bias_correction2) + eps)
+    void (*adam_update)(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* m, T* v);
+};
+
+typedef BasicKernelTable<double> KernelTable;
+typedef BasicKernelTable<float> KernelTableF;
+
+/**
+ * @brief Get the kernels for the instruction set in use
+ * 
+ * @return const BasicKernelTable<T>& The kernel table
+ * 
+ * @note On the first call the best instruction set supported by
+ * the CPU is selected, unless the `PLAIN_NN_ISA` environment variable
+ * forces a specific one, e.g. `PLAIN_NN_ISA=avx2`.
+ */
+template<typename T = double>
+const BasicKernelTable<T>& get_kernels();
+
+/**
+ * @brief Detect the best instruction set supported by the CPU
+ * 
+ * @return IsaLevel The best supported instruction set
+ */
+IsaLevel detect_isa_level();
+
+/**
+ * @brief Get the instruction set used by the kernels
+ * 
+ * @return IsaLevel The instruction set in use
+ */
+IsaLevel get_isa_level();
+
+/**
+ * @brief Force the kernels to use a specific instruction set,
+ * useful to compare the instruction sets on the same machine
+ * 
+ * @param isa The instruction set to use
+ * 
+ * @note Throws a runtime error if the instruction set is not
+ * supported by the CPU or was not compiled in. This should be
+ * called before any model is used.
+ */
+void set_isa_level(IsaLevel isa);
+
+/**
+ * @brief Get the kernel table for a specific instruction set
+ */
+template<typename T = double>
+const BasicKernelTable<T>& scalar_kernels();
+template<typename T = double>
+const BasicKernelTable<T>& avx2_kernels();
+template<typename T = double>
+const BasicKernelTable<T>& avx512_kernels();
+
+/**
+ * @brief Optimizer updates of parameters and state shared by threads
+ * that update them concurrently without a lock, e.g. with
+ * TrainingStrategy::HOGWILD. Same math as the update kernels of
+ * BasicKernelTable, but each value of w and of the state is loaded and
+ * stored with relaxed atomics, so that concurrent updates can overwrite
+ * each other but are never torn. The gradients g are private to the
+ * calling thread and accessed normally. The same kernels are used
+ * whatever the instruction set, atomic accesses are not vectorized.
+ */
+template<typename T>
+void sgd_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g);
+template<typename T>
+void momentum_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v);
+template<typename T>
+void nesterov_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v);
+template<typename T>
+void adam_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* m, T* v);
+
+#endif // PLAIN_NN_KERNELS_KERNELS_H
@@ -2,6 +2,7 @@
 #define PLAIN_NN_LAYERS_ACTIVATION_FNCS_H
 
 #include "tensor.hpp"
+#include "gemm.hpp"
 #include <cmath>
 #include <string>
 
@@ -21,14 +22,41 @@ const std::string ACTIVATION_NAMES[] = {
     "Softmax",
 };
 
+/**
+ * @brief Floating point operations per element of the forward pass of
+ * each activation function, an exponential or a division counts as one
+ */
+const int ACTIVATION_FORWARD_FLOPS[] = {
+    0,  // None
+    1,  // ReLU, max(0, x)
+    4,  // Sigmoid, 1 / (1 + exp(-x))
+    1,  // Tanh
+    5,  // Softmax, max, x - max, exp, sum and division
+};
+
+/**
+ * @brief Floating point operations per element of the backward pass
+ * of each activation function, multiplication by the gradients included
+ */
+const int ACTIVATION_BACKWARD_FLOPS[] = {
+    0,  // None
+    1,  // ReLU
+    3,  // Sigmoid, g * y * (1 - y)
+    3,  // Tanh, g * (1 - y^2)
+    4,  // Softmax, y * (g - sum(g * y))
+};
+
 /**
  * @brief Abstract class for activation functions, new
  * activation functions should inherit from this class
  * and implement all of its methods
+ * 
+ * @tparam T The element type of the tensors, either float or double
  */
-class ActivationFn{
+template<typename T>
+class BasicActivationFn{
     public:
-        ~ActivationFn(){};
+        ~BasicActivationFn(){};
 
         ActivationType fn_type;
 
@@ -36,17 +64,44 @@ class ActivationFn{
          * @brief Forward pass of the activation function
          * 
          * @param input The input to the activation function
-         * @return double The output of the activation function
+         * @return BasicTensor<T> The output of the activation function
          */
-        virtual Tensor forward(Tensor& input) = 0;
+        virtual BasicTensor<T> forward(BasicTensor<T>& input) = 0;
+
+        /**
+         * @brief Forward pass of the activation function, overwriting
+         * the input with the output without allocating
+         * 
+         * @param tensor The input to the activation function, replaced
+         * by the output
+         */
+        virtual void forward_inplace(BasicTensor<T>& tensor) = 0;
 
         /**
          * @brief Backward pass of the activation function
          * 
          * @param input The input to the activation function
-         * @return double The gradient of the activation function
+         * @return BasicTensor<T> The gradient of the activation function
+         */
+        virtual BasicTensor<T> backward(BasicTensor<T>& input) = 0;
+
+        /**
+         * @brief Backward pass of the activation function fused with the
+         * chain rule, the gradients are multiplied in place by the derivative
+         * 
+         * @param output The output of the forward pass of the activation function
+         * @param grads The gradients with respect to the output, replaced by
+         * the gradients with respect to the input
+         */
+        virtual void backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads) = 0;
+
+        /**
+         * @brief Set the activation of a matrix product epilogue, so that
+         * the activation is applied while the product is computed
+         * 
+         * @param epilogue The epilogue to set the activation of
          */
-        virtual Tensor backward(Tensor& input) = 0;
+        virtual void fill_epilogue(BasicGemmEpilogue<T>& epilogue) = 0;
 
         /**
          * @brief Get the name of the activation function
@@ -62,13 +117,18 @@ class ActivationFn{
          */
         ActivationType type(){return fn_type;}
 };
+
+typedef BasicActivationFn<double> ActivationFn;
+typedef BasicActivationFn<float> ActivationFnF;
+
 /**
  * @brief Get the activation function object from the name
  * 
  * @param name The name of the activation function
- * @return ActivationFn* The activation function object
+ * @return BasicActivationFn<T>* The activation function object
  */
-ActivationFn* get_activation_fn_from_name(std::string name);
+template<typename T = double>
+BasicActivationFn<T>* get_activation_fn_from_name(std::string name);
 
 
 /**
@@ -78,13 +138,20 @@ ActivationFn* get_activation_fn_from_name(std::string name);
  * 
  * f'(x) = 1 if x > 0, 0 otherwise
  */
-class ReLU : public ActivationFn{
+template<typename T>
+class BasicReLU : public BasicActivationFn<T>{
     public:
-        ReLU();
+        BasicReLU();
+
+        BasicTensor<T> forward(BasicTensor<T>& input);
 
-        Tensor forward(Tensor& input);
+        void forward_inplace(BasicTensor<T>& tensor);
 
-        Tensor backward(Tensor& input);
+        BasicTensor<T> backward(BasicTensor<T>& input);
+
+        void backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads);
+
+        void fill_epilogue(BasicGemmEpilogue<T>& epilogue);
 };
 
 /**
@@ -94,14 +161,21 @@ class ReLU : public ActivationFn{
  * 
  * f'(x) = f(x) * (1 - f(x))
  */
-class Sigmoid : public ActivationFn{
+template<typename T>
+class BasicSigmoid : public BasicActivationFn<T>{
     public:
         
-        Sigmoid();
+        BasicSigmoid();
+
+        BasicTensor<T> forward(BasicTensor<T>& input);
 
-        Tensor forward(Tensor& input);
+        void forward_inplace(BasicTensor<T>& tensor);
 
-        Tensor backward(Tensor& input);
+        BasicTensor<T> backward(BasicTensor<T>& input);
+
+        void backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads);
+
+        void fill_epilogue(BasicGemmEpilogue<T>& epilogue);
 };
 
 /**
@@ -110,15 +184,25 @@ class Sigmoid : public ActivationFn{
  * f(x) = tanh(x)
  * 
  * f'(x) = 1 - f(x)^2
+ * 
+ * @note As for the other activations, the derivative is
+ * evaluated on the output of the forward pass
  */
-class Tanh : public ActivationFn{
+template<typename T>
+class BasicTanh : public BasicActivationFn<T>{
     public:
         
-        Tanh();
+        BasicTanh();
+
+        BasicTensor<T> forward(BasicTensor<T>& input);
+
+        void forward_inplace(BasicTensor<T>& tensor);
 
-        Tensor forward(Tensor& input);
+        BasicTensor<T> backward(BasicTensor<T>& input);
 
-        Tensor backward(Tensor& input);
+        void backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads);
+
+        void fill_epilogue(BasicGemmEpilogue<T>& epilogue);
 };
 
 /**
@@ -126,18 +210,30 @@ class Tanh : public ActivationFn{
  * 
  * f(x) = exp(x) / sum(exp(x))
  * 
- * f'(x) = f(x) * (1 - f(x))
+ * df(x)_i/dx_j = f(x)_i * (delta_ij - f(x)_j)
+ * 
+ * @note backward returns the diagonal of the jacobian, f(x) * (1 - f(x)),
+ * while backward_inplace applies the whole jacobian. Paired with the
+ * CrossEntropy loss the derivative is not evaluated at all.
  */
-class Softmax : public ActivationFn{
+template<typename T>
+class BasicSoftmax : public BasicActivationFn<T>{
     public:
-        Softmax();
+        BasicSoftmax();
+
+        BasicTensor<T> forward(BasicTensor<T>& input);
+
+        void forward_inplace(BasicTensor<T>& tensor);
 
-        Tensor forward(Tensor& input);
+        BasicTensor<T> backward(BasicTensor<T>& input);
 
-        Tensor backward(Tensor& input);
+        void backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads);
+
+        void fill_epilogue(BasicGemmEpilogue<T>& epilogue);
 };
 
-class None : public ActivationFn{
+template<typename T>
+class BasicNone : public BasicActivationFn<T>{
     public:
         /**
          * @brief No activation function
@@ -146,11 +242,28 @@ class None : public ActivationFn{
          * 
          * f'(x) = 1
          */
-        None();
+        BasicNone();
+
+        BasicTensor<T> forward(BasicTensor<T>& input);
+
+        void forward_inplace(BasicTensor<T>& tensor);
 
-        Tensor forward(Tensor& input);
+        BasicTensor<T> backward(BasicTensor<T>& input);
 
-        Tensor backward(Tensor& input);
+        void backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads);
+
+        void fill_epilogue(BasicGemmEpilogue<T>& epilogue);
 };
 
+typedef BasicReLU<double> ReLU;
+typedef BasicReLU<float> ReLUF;
+typedef BasicSigmoid<double> Sigmoid;
+typedef BasicSigmoid<float> SigmoidF;
+typedef BasicTanh<double> Tanh;
+typedef BasicTanh<float> TanhF;
+typedef BasicSoftmax<double> Softmax;
+typedef BasicSoftmax<float> SoftmaxF;
+typedef BasicNone<double> None;
+typedef BasicNone<float> NoneF;
+
 #endif // PLAIN_NN_LAYERS_ACTIVATION_FNCS_H
\ No newline at end of file
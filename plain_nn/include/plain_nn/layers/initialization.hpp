@@ -26,8 +26,9 @@ class GolorotInitialization{
          * @param tensor The tensor to initialize
          * @param dim_sum The sum of the dimensions of the tensor
          */        
+        template<typename T, typename Alloc>
         static void initialize(
-            std::vector<double>& tensor,
+            std::vector<T, Alloc>& tensor,
             double dim_sum
         );
 };
@@ -5,6 +5,7 @@
 
 #include "tensor.hpp"
 #include "activation_fncs.hpp"
+#include "optimizers.hpp"
 
 /**
  * @brief Enum to hold the type of the layer
@@ -30,33 +31,78 @@ struct LayerSummary{
     std::string layer_name;
     std::string activation_fn;
     int param_count;
-    long int param_size;
+    long int param_size;    // @brief The size in bytes of each parameter
+    DType dtype;            // @brief The element type of the parameters
     std::vector<int> layer_shape;
 };
 
+/**
+ * @brief Struct to hold the compute and memory cost of a layer
+ * during training, see BasicLayer::get_cost
+ */
+struct LayerCost{
+    bool trainable;             // @brief Whether the parameters are updated, i.e. the layer is not frozen
+    long int param_count;       // @brief The number of parameters
+    long int forward_flops;     // @brief The floating point operations of the forward pass of a sample
+    long int backward_flops;    // @brief The floating point operations of the backward pass of a sample, 0 when frozen
+    long int activation_bytes;  // @brief The output of a sample kept for the backward pass, and its gradients when trainable
+    long int gradient_bytes;    // @brief The gradients of the parameters, 0 when frozen
+    long int optimizer_bytes;   // @brief The state of the optimizer for the parameters, 0 when frozen
+    double bytes_per_sample;    // @brief The estimated bytes read and written per sample by a training step
+};
+
+/**
+ * @brief Per-thread state of a layer, i.e. everything a layer writes
+ * during a forward and backward pass. Using a workspace per worker
+ * lets several threads run the same layer on different samples
+ * while sharing its parameters.
+ */
+template<typename T>
+struct BasicLayerWorkspace{
+    BasicTensor<T> output;      // @brief The output of the last forward pass
+    BasicTensor<T> d_weights;   // @brief The accumulated gradients of the weights
+    BasicTensor<T> d_biases;    // @brief The accumulated gradients of the biases
+    BasicTensor<T> grads;       // @brief The gradient of the last backward pass, reused across passes
+};
+
+typedef BasicLayerWorkspace<double> LayerWorkspace;
+typedef BasicLayerWorkspace<float> LayerWorkspaceF;
+
 /**
  * @brief Abstract class for a layer in a neural network.
  * New layers should inherit from this class and implement
  * all of its methods.
+ * 
+ * @tparam T The element type of the tensors, either float or double
  */
-class Layer{
+template<typename T>
+class BasicLayer{
     public:
 
         bool is_initialized = false;
-        Tensor output;
+        BasicTensor<T> output;
         LayerType layer_type;
 
         bool is_frozen = false;
 
-        ~Layer(){};
+        // @brief Whether the gradient given to the layer when it is the output
+        // layer is with respect to the input of its activation, set when the
+        // loss is fused with the activation
+        bool fused_output_grad = false;
+
+        ~BasicLayer(){};
 
         /**
          * @brief Forward pass of the layer
          * 
          * @param input The input to the layer
-         * @return Tensor The output of the layer
+         * @return BasicTensor<T> The output of the layer
+         * 
+         * @note The input can either be a single sample or a batch
+         * of samples stacked along the first dimension, e.g. (batch_size, 784).
+         * The output has the same leading batch dimension as the input.
          */
-        virtual Tensor& forward(Tensor& input) = 0;
+        virtual BasicTensor<T>& forward(BasicTensor<T>& input) = 0;
         
         /**
          * @brief Backward pass of the layer
@@ -65,14 +111,76 @@ class Layer{
          * @param next_weights The weights of the next layer
          * @param next_grad The gradient of the next layer
          * 
-         * @return Tensor The gradient of the layer
+         * @return BasicTensor<T>& The gradient of the layer, owned by the
+         * layer and overwritten by the next backward pass
          * 
          * @note If the layer is frozen this function will
          * never be called. If the layer is an output layer
          * next_weights will be a null pointer and next_grad 
-         * will be the gradient of the loss function.
+         * will be the error signal of the loss function, see
+         * BasicLoss::compute and fused_output_grad. When the forward
+         * pass was done on a batch, prev_output, next_grad and the returned
+         * gradient all have the batch as their first dimension and the
+         * gradients of the parameters are accumulated over the whole batch.
+         */
+        virtual BasicTensor<T>& backward(BasicTensor<T>* prev_output, BasicTensor<T>* next_weights, BasicTensor<T>* next_grad) = 0;
+
+        /**
+         * @brief Forward pass of the layer writing to a workspace
+         * instead of the layer's own state
+         * 
+         * @param input The input to the layer
+         * @param workspace The workspace to store the output in
+         * @return BasicTensor<T> The output of the layer, i.e. workspace.output
+         * 
+         * @note The parameters of the layer are only read, so different
+         * threads can call this function at the same time as long as each
+         * of them uses its own workspace.
+         */
+        virtual BasicTensor<T>& forward(BasicTensor<T>& input, BasicLayerWorkspace<T>& workspace) = 0;
+
+        /**
+         * @brief Backward pass of the layer accumulating the
+         * gradients in a workspace instead of the layer's own state
+         * 
+         * @param prev_output The output of the previous layer
+         * @param next_weights The weights of the next layer
+         * @param next_grad The gradient of the next layer
+         * @param workspace The workspace used by the forward pass
+         * 
+         * @return BasicTensor<T>& The gradient of the layer, i.e. workspace.grads
+         */
+        virtual BasicTensor<T>& backward(BasicTensor<T>* prev_output, BasicTensor<T>* next_weights, BasicTensor<T>* next_grad, BasicLayerWorkspace<T>& workspace) = 0;
+
+        /**
+         * @brief Allocate the gradient buffers of a workspace
+         * with the shape of the parameters of the layer
+         * 
+         * @param workspace The workspace to initialize
+         * @param grads If not a null pointer, the gradients of the workspace
+         * are views of this memory, laid out like the parameters of bind_params
+         */
+        virtual void init_workspace(BasicLayerWorkspace<T>& workspace, T* grads = nullptr) = 0;
+
+        /**
+         * @brief Move the parameters and the gradients of the layer into
+         * memory owned by someone else, e.g. the arenas of a model. The
+         * current values are copied and the tensors of the layer become
+         * views of the memory.
+         * 
+         * @param params The memory for get_summary().param_count parameters
+         * @param grads The memory for as many gradients
+         */
+        virtual void bind_params(__attribute_maybe_unused__ T* params, __attribute_maybe_unused__ T* grads){};
+
+        /**
+         * @brief Add the gradients accumulated in a workspace to the
+         * gradients of the layer, so that the next call to step applies
+         * them. The gradients of the workspace are cleared.
+         * 
+         * @param workspace The workspace to add
          */
-        virtual Tensor backward(Tensor*  prev_output, Tensor* next_weights, Tensor* next_grad) = 0;
+        virtual void accumulate_workspace(BasicLayerWorkspace<T>& workspace) = 0;
         
         /**
          * @brief Update the weights of the layer,
@@ -82,17 +190,61 @@ class Layer{
          * @param batch_size The batch size
          */
         virtual void step(double learning_rate, int batch_size) = 0;
+
+        /**
+         * @brief Update the weights of the layer with the gradients
+         * accumulated in a workspace, which are then cleared
+         * 
+         * @param learning_rate The learning rate
+         * @param batch_size The batch size
+         * @param workspace The workspace holding the gradients
+         * 
+         * @note No lock is taken, so the update can race with
+         * the forward and backward passes of other threads. This
+         * is intended for lock-free (Hogwild!) training, the weights
+         * are updated with relaxed atomics, see BasicOptimizer::update_relaxed.
+         */
+        virtual void step(double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace) = 0;
+
+        /**
+         * @brief Update the weights of the layer with an optimizer,
+         * the gradients are cleared in the same pass
+         * 
+         * @param optimizer The optimizer
+         * @param state_offset The offset of the first parameter of the
+         * layer in the state of the optimizer
+         * @param learning_rate The learning rate
+         * @param batch_size The batch size
+         */
+        virtual void step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size) = 0;
+
+        /**
+         * @brief Update the weights of the layer with an optimizer and
+         * the gradients accumulated in a workspace, which are then cleared
+         * 
+         * @param optimizer The optimizer
+         * @param state_offset The offset of the first parameter of the
+         * layer in the state of the optimizer
+         * @param learning_rate The learning rate
+         * @param batch_size The batch size
+         * @param workspace The workspace holding the gradients
+         * 
+         * @note Like step without an optimizer, no lock is taken and
+         * the state of the optimizer is shared by the threads, the weights
+         * and the state are updated with BasicOptimizer::update_relaxed.
+         */
+        virtual void step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace) = 0;
         
         /**
          * @brief Get the saveable parameters of the layer
          * 
-         * @return std::vector<double> The saveable parameters
+         * @return std::vector<T> The saveable parameters
          * 
          * @note This is used to save the model to a file. Each 
          * implementation should flatten the layer's parameters into
          * single a one dimensional vector.
          */
-        virtual std::vector<double> get_saveable_params() = 0;
+        virtual std::vector<T> get_saveable_params() = 0;
 
         /**
          * @brief Load the parameters of the layer
@@ -104,18 +256,18 @@ class Layer{
          * dimensional vector and load them according to the internal
          * parameter layout.
          */
-        virtual void load_params(std::vector<double>& params) = 0;
+        virtual void load_params(std::vector<T>& params) = 0;
 
         /**
          * @brief Get the parameters of the layer
          * 
-         * @return Tensor* The parameters of the layer
+         * @return BasicTensor<T>* The parameters of the layer
          * 
          * @note This is used during backpropagation to get
          * the parameters to pass to the layer in order to 
          * calculate the gradients. 
          */
-        virtual Tensor* get_params(){return new Tensor();};
+        virtual BasicTensor<T>* get_params(){return new BasicTensor<T>();};
 
         /**
          * @brief Initialize the layer
@@ -138,6 +290,31 @@ class Layer{
          */
         virtual LayerSummary get_summary() = 0;
 
+        /**
+         * @brief Get the compute and memory cost of the layer during training
+         * 
+         * @param batch_size The number of samples of a step, the parameters
+         * are read once per step and their traffic is shared by the samples
+         * @param input_grads Whether the gradients with respect to the input
+         * are needed, i.e. a trainable layer comes before this one
+         * @return LayerCost The cost of the layer
+         * 
+         * @note The bytes moved are estimated as if every value were read from
+         * memory once, the caches are ignored. The optimizer_bytes and the
+         * traffic of the update are left to 0 and filled by the model, which
+         * owns the optimizer. Layers without parameters nor computation can
+         * keep this default.
+         */
+        virtual LayerCost get_cost(int batch_size, bool input_grads);
+
+        /**
+         * @brief Get the type of the activation function of the layer
+         * 
+         * @return ActivationType The type of the activation function,
+         * ActivationType::NONE for layers without one
+         */
+        virtual ActivationType activation_type(){return ActivationType::NONE;}
+
         /**
          * @brief Freeze the layer
          * 
@@ -156,6 +333,10 @@ class Layer{
          */
         std::string name();
 };
+
+typedef BasicLayer<double> Layer;
+typedef BasicLayer<float> LayerF;
+
 /**
  * @brief Build a layer from the name
  * 
@@ -163,24 +344,33 @@ class Layer{
  * @param layer_shape The shape of the layer
  * @param activation_fn The activation function of the layer
  * 
- * @return Layer* The layer object
+ * @return BasicLayer<T>* The layer object
  */
-Layer* build_layer_from_name(std::string name, std::vector<int> layer_shape, ActivationFn* activation_fn);
+template<typename T>
+BasicLayer<T>* build_layer_from_name(std::string name, std::vector<int> layer_shape, BasicActivationFn<T>* activation_fn);
 
 /**
  * @brief Input layer, this layer has no parameters
  * and is only used to pass the input to the other layers.
  */
-class Input : public Layer{
+template<typename T>
+class BasicInput : public BasicLayer<T>{
     public:
-        Input(std::vector<int> shape, bool frozen = false);
-        Input(std::initializer_list<int> shape, bool frozen = false);
+        BasicInput(std::vector<int> shape, bool frozen = false);
+        BasicInput(std::initializer_list<int> shape, bool frozen = false);
 
-        Tensor& forward( Tensor& input);
-        Tensor backward( Tensor* prev_output,  Tensor* next_weights,  Tensor* next_grad);
+        BasicTensor<T>& forward( BasicTensor<T>& input);
+        BasicTensor<T>& backward( BasicTensor<T>* prev_output,  BasicTensor<T>* next_weights,  BasicTensor<T>* next_grad);
+        BasicTensor<T>& forward( BasicTensor<T>& input, BasicLayerWorkspace<T>& workspace);
+        BasicTensor<T>& backward( BasicTensor<T>* prev_output,  BasicTensor<T>* next_weights,  BasicTensor<T>* next_grad, BasicLayerWorkspace<T>& workspace);
+        void init_workspace(BasicLayerWorkspace<T>& workspace, T* grads = nullptr);
+        void accumulate_workspace(BasicLayerWorkspace<T>& workspace);
         void step(double learning_rate, int batch_size);
-        std::vector<double> get_saveable_params();
-        void load_params( std::vector<double>& params);
+        void step(double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace);
+        void step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size);
+        void step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace);
+        std::vector<T> get_saveable_params();
+        void load_params( std::vector<T>& params);
 
         void initialize(std::vector<int> input_shape);
 
@@ -192,28 +382,59 @@ class Input : public Layer{
  * with an activation function. It has two parameters
  * weights and biases. 
  */
-class Dense : public Layer{
+template<typename T>
+class BasicDense : public BasicLayer<T>{
     public:
-        Dense(int output_size, ActivationFn* activation_fn, bool frozen = false);
-        Dense(int input_size, int output_size, ActivationFn* activation_fn, bool frozen = false);
+        BasicDense(int output_size, BasicActivationFn<T>* activation_fn, bool frozen = false);
+        BasicDense(int input_size, int output_size, BasicActivationFn<T>* activation_fn, bool frozen = false);
 
         void initialize(std::vector<int> input_shape);
-        Tensor* get_params() override;
-        Tensor& forward(Tensor& input);
-        Tensor backward(Tensor* prev_output, Tensor* next_weights, Tensor* next_grad);
+        BasicTensor<T>* get_params() override;
+        BasicTensor<T>& forward(BasicTensor<T>& input);
+        BasicTensor<T>& backward(BasicTensor<T>* prev_output, BasicTensor<T>* next_weights, BasicTensor<T>* next_grad);
+        BasicTensor<T>& forward(BasicTensor<T>& input, BasicLayerWorkspace<T>& workspace);
+        BasicTensor<T>& backward(BasicTensor<T>* prev_output, BasicTensor<T>* next_weights, BasicTensor<T>* next_grad, BasicLayerWorkspace<T>& workspace);
+        void init_workspace(BasicLayerWorkspace<T>& workspace, T* grads = nullptr);
+        void accumulate_workspace(BasicLayerWorkspace<T>& workspace);
         void step(double learning_rate, int batch_size);
-        std::vector<double> get_saveable_params();
-        void load_params( std::vector<double>& params);
+        void step(double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace);
+        void step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size);
+        void step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace);
+        std::vector<T> get_saveable_params();
+        void load_params( std::vector<T>& params);
+        void bind_params(T* params, T* grads) override;
 
         LayerSummary get_summary();
+        LayerCost get_cost(int batch_size, bool input_grads) override;
+        ActivationType activation_type() override;
 
     private:
+        /**
+         * @brief Forward pass writing the result to output
+         */
+        BasicTensor<T>& compute_forward(BasicTensor<T>& input, BasicTensor<T>& output);
+
+        /**
+         * @brief Backward pass reading the result of the forward pass from
+         * output, accumulating the gradients in d_weights and d_biases and
+         * writing the gradient of the layer to grads
+         */
+        BasicTensor<T>& compute_backward(
+            BasicTensor<T>* prev_output, BasicTensor<T>* next_weights, BasicTensor<T>* next_grad,
+            BasicTensor<T>& output, BasicTensor<T>& d_weights, BasicTensor<T>& d_biases, BasicTensor<T>& grads);
+
         int input_size, output_size; 
-        Tensor weights;
-        Tensor d_weights;
-        Tensor biases;
-        Tensor d_biases;
-        ActivationFn* activation_fn;
+        BasicTensor<T> grads;
+        BasicTensor<T> weights;
+        BasicTensor<T> d_weights;
+        BasicTensor<T> biases;
+        BasicTensor<T> d_biases;
+        BasicActivationFn<T>* activation_fn;
 };
 
+typedef BasicInput<double> Input;
+typedef BasicInput<float> InputF;
+typedef BasicDense<double> Dense;
+typedef BasicDense<float> DenseF;
+
 #endif // PLAIN_NN_LAYERS_LAYERS_H
\ No newline at end of file
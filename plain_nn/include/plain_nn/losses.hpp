@@ -0,0 +1,156 @@
+#ifndef PLAIN_NN_LOSSES_H
+#define PLAIN_NN_LOSSES_H
+
+#include "activation_fncs.hpp"
+#include <string>
+
+enum LossType{
+    MSE,
+    CROSS_ENTROPY,
+    BINARY_CROSS_ENTROPY,
+};
+
+const std::string LOSS_NAMES[] = {
+    "MSE",
+    "CrossEntropy",
+    "BinaryCrossEntropy",
+};
+
+/**
+ * @brief Abstract class for loss functions, new loss functions
+ * should inherit from this class and implement all of its methods
+ *
+ * @tparam T The element type of the tensors, either float or double
+ *
+ * @note The gradients follow the convention of the layers, they are
+ * the error signal that is added to the parameters, i.e. minus the
+ * gradient of the loss.
+ */
+template<typename T>
+class BasicLoss{
+    public:
+        virtual ~BasicLoss(){};
+
+        LossType loss_type;
+
+        /**
+         * @brief Compute the loss of a batch and, in the same pass, the
+         * error signal of the output layer
+         *
+         * @param rows The number of samples
+         * @param cols The number of outputs of each sample
+         * @param activation The activation of the output layer
+         * @param output The output of the model, of shape (rows, cols)
+         * @param targets The targets, of shape (rows, cols)
+         * @param grads Set to minus the gradient of the loss with respect to the
+         * output or, when fuses_with(activation), with respect to the input of
+         * the activation. Can be a null pointer when only the loss is needed
+         * and can point to the same array as targets.
+         * @param loss_per_class If not a null pointer, the loss of each of the
+         * cols outputs is added to it
+         *
+         * @return double The sum of the loss over the samples
+         */
+        virtual double compute(
+            int rows, int cols, ActivationType activation,
+            const T* output, const T* targets, T* grads, double* loss_per_class) = 0;
+
+        /**
+         * @brief Whether the gradient with respect to the input of the
+         * activation has a closed form that skips the derivative of the
+         * activation, e.g. y - t for the softmax and the cross entropy
+         *
+         * @param activation The activation of the output layer
+         * @return bool True if compute returns the gradient with respect
+         * to the input of the activation
+         */
+        virtual bool fuses_with(ActivationType activation) = 0;
+
+        /**
+         * @brief Get the name of the loss function
+         *
+         * @return std::string The name of the loss function
+         */
+        std::string name(){return LOSS_NAMES[loss_type];}
+
+        /**
+         * @brief Get the type of the loss function
+         *
+         * @return LossType The type of the loss function
+         */
+        LossType type(){return loss_type;}
+};
+
+typedef BasicLoss<double> Loss;
+typedef BasicLoss<float> LossF;
+
+/**
+ * @brief Mean squared error, the default loss of the models
+ *
+ * L = 0.5 * sum((y - t)^2)
+ *
+ * -dL/dy = t - y
+ */
+template<typename T>
+class BasicMSE : public BasicLoss<T>{
+    public:
+        BasicMSE();
+
+        double compute(
+            int rows, int cols, ActivationType activation,
+            const T* output, const T* targets, T* grads, double* loss_per_class);
+
+        bool fuses_with(ActivationType activation);
+};
+
+/**
+ * @brief Categorical cross entropy, for one hot targets
+ *
+ * L = -sum(t * log(y))
+ *
+ * -dL/dy = t / y
+ *
+ * @note Fused with a softmax output, -dL/dx = t - y
+ */
+template<typename T>
+class BasicCrossEntropy : public BasicLoss<T>{
+    public:
+        BasicCrossEntropy();
+
+        double compute(
+            int rows, int cols, ActivationType activation,
+            const T* output, const T* targets, T* grads, double* loss_per_class);
+
+        bool fuses_with(ActivationType activation);
+};
+
+/**
+ * @brief Binary cross entropy, each output is an independent
+ * probability, e.g. for multi label classification
+ *
+ * L = -sum(t * log(y) + (1 - t) * log(1 - y))
+ *
+ * -dL/dy = (t - y) / (y * (1 - y))
+ *
+ * @note Fused with a sigmoid output, -dL/dx = t - y
+ */
+template<typename T>
+class BasicBinaryCrossEntropy : public BasicLoss<T>{
+    public:
+        BasicBinaryCrossEntropy();
+
+        double compute(
+            int rows, int cols, ActivationType activation,
+            const T* output, const T* targets, T* grads, double* loss_per_class);
+
+        bool fuses_with(ActivationType activation);
+};
+
+typedef BasicMSE<double> MSELoss;
+typedef BasicMSE<float> MSELossF;
+typedef BasicCrossEntropy<double> CrossEntropy;
+typedef BasicCrossEntropy<float> CrossEntropyF;
+typedef BasicBinaryCrossEntropy<double> BinaryCrossEntropy;
+typedef BasicBinaryCrossEntropy<float> BinaryCrossEntropyF;
+
+#endif // PLAIN_NN_LOSSES_H
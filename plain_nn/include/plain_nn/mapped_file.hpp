@@ -0,0 +1,55 @@
+#ifndef PLAIN_NN_MAPPED_FILE_H
+#define PLAIN_NN_MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief Read-only memory mapping of a whole file. The pages are
+ * loaded by the operating system when first accessed and can be
+ * evicted under memory pressure, so files larger than the available
+ * RAM can be mapped.
+ */
+class MappedFile{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * @brief Map a file, unmapping the previous one if any
+         * 
+         * @param path The path of the file
+         * 
+         * @note Throws a std::runtime_error if the file can not be opened or mapped
+         */
+        void open(std::string path);
+
+        /**
+         * @brief Unmap the file, does nothing if no file is mapped
+         */
+        void close();
+
+        /**
+         * @brief Get the content of the file
+         * 
+         * @return const unsigned char* The first byte of the file, or
+         * a null pointer if no file is mapped
+         */
+        const unsigned char* data();
+
+        /**
+         * @brief Get the size of the file
+         * 
+         * @return size_t The size of the file in bytes
+         */
+        size_t size();
+
+    private:
+        unsigned char* m_data;
+        size_t m_size;
+};
+
+#endif // PLAIN_NN_MAPPED_FILE_H
@@ -10,6 +10,14 @@
 const std::string MODEL_ARCH_FILE_EXT = ".json";
 const std::string MODEL_WEIGHTS_FILE_EXT = ".weights";
 
+/**
+ * @brief Header of the weights file, followed by the format version
+ * and the DType of the stored parameters as 32 bit unsigned integers.
+ * Files without the header are read as raw float64 parameters.
+ */
+const char MODEL_WEIGHTS_MAGIC[4] = {'P', 'N', 'N', 'W'};
+const unsigned int MODEL_WEIGHTS_VERSION = 1;
+
 /**
  * @brief Class to handle the storage of a model
  * object to disk. This class is used to save and load
@@ -39,12 +47,14 @@ class ModelStorage{
          * @param file_name The name of the file to save the model to, without the extension
          * @param weights The weights of the model
          * 
-         * @note The model weights are saved in a binary format. The
+         * @note The model weights are saved in a binary format, prefixed by
+         * a header that records the element type of the parameters. The
          * final file will have the extension `.weights`.
          */
+        template<typename T>
         static void save_model_weights(
             std::string file_name,
-            std::vector<std::vector<double> > weights
+            std::vector<std::vector<T> > weights
         );
 
         /**
@@ -54,11 +64,14 @@ class ModelStorage{
          * @param model The model to load the architecture into
          * 
          * @note The model architecture is loaded from a JSON file.
-         * The `.json` extension is added to the file name.
+         * The `.json` extension is added to the file name. The layers
+         * are built with the element type of the model, regardless of the
+         * dtype they were saved with.
          */
+        template<typename T>
         static void load_model_arch(
             std::string file_name,
-            PlainNN& model
+            BasicPlainNN<T>& model
         );
 
         /**
@@ -68,12 +81,15 @@ class ModelStorage{
          * @param layer_count The number of layers in the model
          * 
          * @note The model weights are loaded from a binary file.
-         * The `.weights` extension is added to the file name.
+         * The `.weights` extension is added to the file name. If the
+         * file was saved with a different dtype than the one of the
+         * model, the parameters are converted while loading.
          */
+        template<typename T>
         static void load_model_weights(
             std::string file_name,
             int layer_count,
-            PlainNN& model
+            BasicPlainNN<T>& model
         );
 
 };
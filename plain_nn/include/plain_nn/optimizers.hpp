@@ -0,0 +1,252 @@
+#ifndef PLAIN_NN_OPTIMIZERS_H
+#define PLAIN_NN_OPTIMIZERS_H
+
+#include <vector>
+#include <string>
+#include <atomic>
+
+template<typename T>
+struct BasicUpdateParams;
+
+enum OptimizerType{
+    SGD,
+    MOMENTUM,
+    NESTEROV,
+    ADAM,
+    ADAMW,
+};
+
+const std::string OPTIMIZER_NAMES[] = {
+    "SGD",
+    "Momentum",
+    "Nesterov",
+    "Adam",
+    "AdamW",
+};
+
+/**
+ * @brief Abstract class for optimizers, new optimizers should
+ * inherit from this class and implement all of its methods.
+ *
+ * The state of the optimizer, e.g. the moments, is stored for all the
+ * parameters of the model in one array, each layer updates its
+ * parameters at its own offset in it.
+ *
+ * @tparam T The element type of the parameters, either float or double
+ */
+template<typename T>
+class BasicOptimizer{
+    public:
+        virtual ~BasicOptimizer(){};
+
+        OptimizerType optimizer_type;
+
+        /**
+         * @brief Allocate the state for the parameters of a model
+         *
+         * @param num_params The number of parameters of the model
+         *
+         * @note The state is kept if the number of parameters did not
+         * change, so that successive calls to train resume from it.
+         */
+        virtual void init(long int num_params) = 0;
+
+        /**
+         * @brief Start a new update, called once per mini-batch before
+         * the parameters of the layers are updated
+         */
+        virtual void begin_step(){};
+
+        /**
+         * @brief Get the number of values of state kept per parameter
+         *
+         * @return int The values per parameter, e.g. 2 for the moments of Adam
+         */
+        virtual int state_size(){return 0;};
+
+        /**
+         * @brief Update a buffer of parameters and clear its gradients
+         * in the same pass
+         *
+         * @param state_offset The offset of the first parameter in the state
+         * @param n The number of parameters
+         * @param params The parameters
+         * @param grads The accumulated error signals of the parameters,
+         * i.e. minus the gradients of the loss, set to 0
+         * @param learning_rate The learning rate
+         * @param scale The factor applied to the gradients, e.g. 1 / batch_size
+         */
+        virtual void update(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale) = 0;
+
+        /**
+         * @brief Same as update, for parameters and state that other
+         * threads update at the same time without a lock, e.g. with
+         * TrainingStrategy::HOGWILD
+         *
+         * @param state_offset The offset of the first parameter in the state
+         * @param n The number of parameters
+         * @param params The parameters, shared with the other threads
+         * @param grads The accumulated error signals of the parameters,
+         * private to the calling thread, set to 0
+         * @param learning_rate The learning rate
+         * @param scale The factor applied to the gradients, e.g. 1 / batch_size
+         *
+         * @note Each parameter and state value is loaded and stored with
+         * relaxed atomics, concurrent updates of the same value can be lost
+         * but never leave it half written.
+         */
+        virtual void update_relaxed(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale) = 0;
+
+        /**
+         * @brief Get the name of the optimizer
+         *
+         * @return std::string The name of the optimizer
+         */
+        std::string name(){return OPTIMIZER_NAMES[optimizer_type];}
+
+        /**
+         * @brief Get the type of the optimizer
+         *
+         * @return OptimizerType The type of the optimizer
+         */
+        OptimizerType type(){return optimizer_type;}
+};
+
+typedef BasicOptimizer<double> Optimizer;
+typedef BasicOptimizer<float> OptimizerF;
+
+/**
+ * @brief Stochastic gradient descent, the default optimizer
+ *
+ * w = w - lr * dw
+ */
+template<typename T>
+class BasicSGD : public BasicOptimizer<T>{
+    public:
+        BasicSGD();
+
+        void init(long int num_params);
+        void update(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale);
+        void update_relaxed(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale);
+};
+
+/**
+ * @brief Stochastic gradient descent with momentum
+ *
+ * v = momentum * v - dw
+ *
+ * w = w + lr * v
+ *
+ * @note With nesterov the update looks ahead along the velocity,
+ * w = w + lr * (momentum * v - dw)
+ */
+template<typename T>
+class BasicMomentum : public BasicOptimizer<T>{
+    public:
+        /**
+         * @brief Construct a new Momentum object
+         *
+         * @param momentum The decay rate of the velocity, default is 0.9
+         * @param nesterov Whether to use the Nesterov accelerated gradient
+         */
+        BasicMomentum(double momentum = 0.9, bool nesterov = false);
+
+        void init(long int num_params);
+        int state_size();
+        void update(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale);
+        void update_relaxed(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale);
+
+    private:
+        double m_momentum;
+        std::vector<T> m_velocity;
+};
+
+/**
+ * @brief Stochastic gradient descent with Nesterov momentum
+ */
+template<typename T>
+class BasicNesterov : public BasicMomentum<T>{
+    public:
+        /**
+         * @brief Construct a new Nesterov object
+         *
+         * @param momentum The decay rate of the velocity, default is 0.9
+         */
+        BasicNesterov(double momentum = 0.9);
+};
+
+/**
+ * @brief Adam, and AdamW when the weight decay is not 0
+ *
+ * m = beta1 * m + (1 - beta1) * dw
+ *
+ * v = beta2 * v + (1 - beta2) * dw^2
+ *
+ * w = w - lr * weight_decay * w - lr * m_hat / (sqrt(v_hat) + eps)
+ *
+ * @note The weight decay is decoupled from the gradients and
+ * applies to all the parameters, biases included
+ */
+template<typename T>
+class BasicAdam : public BasicOptimizer<T>{
+    public:
+        /**
+         * @brief Construct a new Adam object
+         *
+         * @param beta1 The decay rate of the first moment, default is 0.9
+         * @param beta2 The decay rate of the second moment, default is 0.999
+         * @param eps Added to the denominator for numerical stability, default is 1e-8
+         * @param weight_decay The decoupled weight decay, default is 0
+         */
+        BasicAdam(double beta1 = 0.9, double beta2 = 0.999, double eps = 1e-8, double weight_decay = 0);
+
+        void init(long int num_params);
+        void begin_step();
+        int state_size();
+        void update(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale);
+        void update_relaxed(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale);
+
+    private:
+        double m_beta1, m_beta2, m_eps, m_weight_decay;
+
+        // Incremented concurrently by the threads with TrainingStrategy::HOGWILD
+        std::atomic<long int> m_step;
+
+        std::vector<T> m_first_moment;
+        std::vector<T> m_second_moment;
+
+        /**
+         * @brief Get the hyper parameters of an update at the current step
+         */
+        BasicUpdateParams<T> update_params(double learning_rate, double scale);
+};
+
+/**
+ * @brief Adam with decoupled weight decay
+ */
+template<typename T>
+class BasicAdamW : public BasicAdam<T>{
+    public:
+        /**
+         * @brief Construct a new AdamW object
+         *
+         * @param weight_decay The decoupled weight decay, default is 0.01
+         * @param beta1 The decay rate of the first moment, default is 0.9
+         * @param beta2 The decay rate of the second moment, default is 0.999
+         * @param eps Added to the denominator for numerical stability, default is 1e-8
+         */
+        BasicAdamW(double weight_decay = 0.01, double beta1 = 0.9, double beta2 = 0.999, double eps = 1e-8);
+};
+
+typedef BasicSGD<double> SGDOptimizer;
+typedef BasicSGD<float> SGDOptimizerF;
+typedef BasicMomentum<double> Momentum;
+typedef BasicMomentum<float> MomentumF;
+typedef BasicNesterov<double> Nesterov;
+typedef BasicNesterov<float> NesterovF;
+typedef BasicAdam<double> Adam;
+typedef BasicAdam<float> AdamF;
+typedef BasicAdamW<double> AdamW;
+typedef BasicAdamW<float> AdamWF;
+
+#endif // PLAIN_NN_OPTIMIZERS_H
@@ -3,7 +3,13 @@
 
 #include "layers.hpp"
 #include "lr_scheduler.hpp"
+#include "losses.hpp"
+#include "optimizers.hpp"
 #include "data_loaders.hpp"
+#include "thread_pool.hpp"
+#include "aligned_buffer.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
 #include <vector>
 #include <chrono>
 
@@ -19,14 +25,108 @@ struct EvaluationResult{
     std::vector<double> avg_loss_per_class; // @brief The average loss per class
 };
 
+/**
+ * @brief Enum to hold the way the threads cooperate during training
+ */
+enum TrainingStrategy{
+    SYNCHRONOUS,    // @brief Each mini-batch is split among the threads and the gradients are reduced before a single update
+    HOGWILD         // @brief Each thread trains on its own mini-batches and updates the shared weights without locks
+};
+
+/**
+ * @brief Array of training strategy names
+ */
+const std::string TRAINING_STRATEGY_NAMES[] = {
+    "synchronous",
+    "hogwild"
+};
+
+/**
+ * @brief Struct to hold the throughput of a training run
+ */
+struct TrainingStats{
+    int num_threads;        // @brief The number of threads used for training
+    long int samples;       // @brief The number of samples processed
+    double train_time;      // @brief The time spent in training steps in seconds, validation excluded
+    double loader_time;     // @brief The part of train_time spent waiting for the dataloader to fill a batch
+    double samples_per_sec; // @brief The number of samples processed per second
+};
+
+/**
+ * @brief The output buffers of every layer used by the forward passes
+ * of one thread, see BasicPlainNN::create_inference_plan
+ */
+template<typename T>
+struct BasicInferencePlan{
+    std::vector<BasicLayerWorkspace<T> > workspaces;   // @brief One workspace per layer, only the outputs are allocated
+    int max_batch_size;                                 // @brief The largest batch the plan was built for
+};
+
+typedef BasicInferencePlan<double> InferencePlan;
+typedef BasicInferencePlan<float> InferencePlanF;
+
 
 /**
  * @brief Class that represent a neural network model
+ * 
+ * @tparam T The element type of the model parameters and
+ * activations, either float or double
  */
-class PlainNN{
+template<typename T>
+class BasicPlainNN{
     public:
-        PlainNN();
-        ~PlainNN(){};
+        /**
+         * @brief Construct a new model
+         * 
+         * @param num_threads The number of threads used for training, default is 1
+         */
+        BasicPlainNN(int num_threads = 1);
+        ~BasicPlainNN();
+
+        BasicPlainNN(const BasicPlainNN&) = delete;
+        BasicPlainNN& operator=(const BasicPlainNN&) = delete;
+
+        /**
+         * @brief Set the number of threads used for training
+         * 
+         * @param num_threads The number of threads, including the calling one
+         * 
+         * @note The threads are created once and reused for every
+         * training step. Each mini-batch is split among the threads,
+         * each accumulating the gradients of its samples in its own
+         * buffers, which are then summed with a tree reduction.
+         */
+        void set_num_threads(int num_threads);
+
+        /**
+         * @brief Get the number of threads used for training
+         * 
+         * @return int The number of threads
+         */
+        int num_threads();
+
+        /**
+         * @brief Set the strategy used to train with multiple threads,
+         * default is TrainingStrategy::SYNCHRONOUS
+         * 
+         * @param strategy The training strategy
+         * 
+         * @note With TrainingStrategy::HOGWILD each thread draws whole
+         * mini-batches from the dataloader and applies its update to the
+         * shared weights as soon as its backward pass is done, without any
+         * lock or reduction (Hogwild!). Updates from different threads can
+         * overwrite each other and the forward passes can see partially
+         * updated weights, so the results are not reproducible, but no
+         * thread ever waits for the others.
+         */
+        void set_training_strategy(TrainingStrategy strategy);
+
+        /**
+         * @brief Get the strategy used to train with multiple threads
+         * 
+         * @return TrainingStrategy The training strategy
+         */
+        TrainingStrategy training_strategy();
 
         /**
          * @brief Set the learning rate scheduler
@@ -35,6 +135,44 @@ class PlainNN{
          */
         void set_lr_scheduler(LRScheduler* scheduler);
 
+        /**
+         * @brief Set the loss function minimized during training and
+         * reported by evaluate, MSELoss by default
+         * 
+         * @param loss The loss function, the model takes ownership of it
+         * 
+         * @note When the loss is fused with the activation of the output
+         * layer, e.g. CrossEntropy with Softmax or BinaryCrossEntropy with
+         * Sigmoid, the gradient with respect to the input of the activation
+         * is computed directly and the derivative of the activation is skipped.
+         */
+        void set_loss(BasicLoss<T>* loss);
+
+        /**
+         * @brief Get the loss function of the model
+         * 
+         * @return BasicLoss<T>* The loss function
+         */
+        BasicLoss<T>* loss();
+
+        /**
+         * @brief Set the optimizer that updates the parameters
+         * during training, SGDOptimizer by default
+         * 
+         * @param optimizer The optimizer, the model takes ownership of it
+         * 
+         * @note The state of the optimizer is kept between calls to
+         * train as long as the number of parameters does not change.
+         */
+        void set_optimizer(BasicOptimizer<T>* optimizer);
+
+        /**
+         * @brief Get the optimizer of the model
+         * 
+         * @return BasicOptimizer<T>* The optimizer
+         */
+        BasicOptimizer<T>* optimizer();
+
         /**
          * @brief Add a layer to the model
          * 
@@ -44,7 +182,7 @@ class PlainNN{
          * should be executed in the forward pass. The first layer
          * must be an input layer.
          */
-        void add_layer(Layer* layer);
+        void add_layer(BasicLayer<T>* layer);
 
         /**
          * @brief Start training the model
@@ -61,9 +199,11 @@ class PlainNN{
          * on the data provided by the train_dataloader. If save_checkpoint is true, the
          * model will be saved to the checkpoint_path after each epoch according to the
          * format `checkpoint_path_epoch_i.weights` and `checkpoint_path_epoch_i.json`.
+         * 
+         * @return TrainingStats The throughput of the training run
          */
-        void train(
-            DataLoader& train_dataloader,
+        TrainingStats train(
+            BasicDataLoader<T>& train_dataloader,
             double learning_rate,
             int epochs,
             int batch_size,
@@ -88,10 +228,12 @@ class PlainNN{
          * on the data provided by the train_dataloader. If save_checkpoint is true, the
          * model will be saved to the checkpoint_path after each epoch according to the
          * format `checkpoint_path_epoch_i.weights` and `checkpoint_path_epoch_i.json`.
+         * 
+         * @return TrainingStats The throughput of the training run
          */
-        void train(
-            DataLoader& train_dataloader,
-            DataLoader& test_dataloader,
+        TrainingStats train(
+            BasicDataLoader<T>& train_dataloader,
+            BasicDataLoader<T>& test_dataloader,
             double learning_rate,
             int epochs,
             int batch_size,
@@ -108,15 +250,106 @@ class PlainNN{
          * 
          * @return EvaluationResult The result of the evaluation
          */
-        EvaluationResult evaluate(DataLoader& dataloader, bool show_output = true, bool indent = false);
+        EvaluationResult evaluate(BasicDataLoader<T>& dataloader, bool show_output = true, bool indent = false);
+
+        /**
+         * @brief Evaluate the model on the data provided by the dataloader,
+         * batch_size samples at a time
+         * 
+         * @param dataloader The dataloader to get the data from
+         * @param batch_size The number of samples of each forward pass
+         * @param show_output Whether to show the output of the model
+         * @param indent Whether to indent the output, false by default. (Callers should not set this)
+         * 
+         * @return EvaluationResult The result of the evaluation
+         * 
+         * @note When the model uses several threads each batch is split among
+         * them, every thread accumulates the results of its samples and they
+         * are merged at the end. If the dataloader drops the last incomplete
+         * batch those samples are not evaluated.
+         */
+        EvaluationResult evaluate(BasicDataLoader<T>& dataloader, int batch_size, bool show_output = true, bool indent = false);
 
         /**
          * @brief Forward pass of the model
          * 
          * @param input The input to the model
-         * @return Tensor The output of the model
+         * @return BasicTensor<T> The output of the model
+         */
+        BasicTensor<T> forward(BasicTensor<T>& input);
+
+        /**
+         * @brief Build the inference plan of the model, allocating once the
+         * output buffers of every layer for batches of up to max_batch_size
+         * samples
+         * 
+         * @param max_batch_size The largest batch passed to predict, a
+         * value of 1 plans for single samples of shape (input_size)
+         * 
+         * @note The plan is discarded when a layer is added, compile must
+         * be called again after the model is modified or loaded.
+         */
+        void compile(int max_batch_size = 1);
+
+        /**
+         * @brief Forward pass of the model through the inference plan
+         * 
+         * @param input A single sample or a batch of at most max_batch_size
+         * samples, as given to compile
+         * @return BasicTensor<T>& The output of the model, which is owned by
+         * the plan and overwritten by the next call
+         * 
+         * @note Each layer writes its output in its own preallocated buffer
+         * and the activations run in place, so that as long as the shape of
+         * the input does not change between calls no memory is allocated.
+         * The buffers are shared, predict must not be called concurrently,
+         * use a plan per thread instead, see create_inference_plan.
+         */
+        BasicTensor<T>& predict(BasicTensor<T>& input);
+
+        /**
+         * @brief Build an inference plan owned by the caller, allocating the
+         * output buffers of every layer for batches of up to max_batch_size
+         * samples
+         * 
+         * @param max_batch_size The largest batch passed to predict with
+         * this plan, a value of 1 plans for single samples of shape (input_size)
+         * @return BasicInferencePlan<T> The plan
+         * 
+         * @note Each thread running forward passes at the same time needs
+         * its own plan. The plan is no longer valid once a layer is added.
+         */
+        BasicInferencePlan<T> create_inference_plan(int max_batch_size = 1);
+
+        /**
+         * @brief Forward pass of the model through an inference plan
+         * owned by the caller
+         * 
+         * @param input A single sample or a batch of at most
+         * plan.max_batch_size samples
+         * @param plan The plan, see create_inference_plan
+         * @return BasicTensor<T>& The output of the model, which is owned by
+         * the plan and overwritten by the next call with the same plan
+         * 
+         * @note The parameters are only read, so that several threads can
+         * call predict at the same time, each with its own plan, as long as
+         * the model is not trained or modified meanwhile.
+         */
+        BasicTensor<T>& predict(BasicTensor<T>& input, BasicInferencePlan<T>& plan);
+
+        /**
+         * @brief Get the number of features of a sample
+         * 
+         * @return int The size of the input layer
          */
-        Tensor forward(Tensor& input);
+        int input_size();
+
+        /**
+         * @brief Get the number of outputs of a sample
+         * 
+         * @return int The size of the last layer
+         */
+        int output_size();
 
         /**
          * @brief Prints a summary of the model to the console
@@ -125,19 +358,68 @@ class PlainNN{
          * - Layer Type
          * - Output Shape
          * - Number of Parameters
+         * - Forward and backward FLOPs per sample
+         * - Activation memory per sample
+         * 
+         * Also prints the total, trainable and frozen parameters and the
+         * cost of a training step, see layer_costs
+         * 
+         * @param batch_size The batch size the bytes moved per sample are
+         * estimated for, default is 1
+         */
+        void summary(int batch_size = 1);
+
+        /**
+         * @brief Get the compute and memory cost of each layer during
+         * training with the current loss and optimizer
+         * 
+         * @param batch_size The number of samples of a step, default is 1
+         * @return std::vector<LayerCost> The cost of each layer, input layer included
+         * 
+         * @note Frozen layers have no backward pass, gradients nor optimizer
+         * state. The bytes moved per sample include the update of the
+         * parameters, shared by the samples of the batch.
+         */
+        std::vector<LayerCost> layer_costs(int batch_size = 1);
+
+        /**
+         * @brief Enable or disable the profiling of the training steps
+         * 
+         * @param enable Whether to enable the profiler, default is true
+         * 
+         * @note While enabled, train records the time of the forward pass,
+         * the backward pass and the update of each layer, the wait for the
+         * dataloader and the reduction of the gradients, and prints them
+         * with print_profile at the end of each epoch. The layers are then
+         * updated one at a time instead of in a single sweep of the arena.
+         */
+        void enable_profiling(bool enable = true);
+
+        /**
+         * @brief Get the profiler of the model
          * 
-         * Also prints the total number of parameters and their size
+         * @return Profiler* The profiler, with the epochs of the last
+         * training run, or a null pointer if profiling is disabled
          */
-        void summary();
+        Profiler* profiler();
+
+        /**
+         * @brief Prints the time of the training steps per layer in a
+         * table formatted like the summary, see Profiler::print
+         * 
+         * @param epoch The epoch of the last training run to print,
+         * default is -1 for the sum of all of them
+         */
+        void print_profile(int epoch = -1);
 
         /**
          * @brief Get a layer from the model
          * 
          * @param index The index of the layer
          * 
-         * @return Layer* The layer at the specified index
+         * @return BasicLayer<T>* The layer at the specified index
          */
-        Layer* get_layer(int index);
+        BasicLayer<T>* get_layer(int index);
 
         /**
          * @brief Freeze or unfreeze a layer
@@ -147,6 +429,28 @@ class PlainNN{
          */
         void freeze_layer(int index, bool freeze = true);
 
+        /**
+         * @brief Get all the parameters of the model as a single tensor
+         * 
+         * @return BasicTensor<T> A view of the parameters, valid until the
+         * next layer is added to the model
+         * 
+         * @note The parameters of all the layers live in one aligned arena,
+         * each layer starts on a 64 byte boundary and holds its weights followed
+         * by its biases. Copying the view is a full checkpoint of the model,
+         * copying it back restores it.
+         */
+        BasicTensor<T> parameters();
+
+        /**
+         * @brief Get all the accumulated gradients of the model as a single
+         * tensor, laid out like the parameters
+         * 
+         * @return BasicTensor<T> A view of the gradients, valid until the
+         * next layer is added to the model
+         */
+        BasicTensor<T> gradients();
+
         /**
          * @brief Saves the model to disk. The model is saved in two parts:
          * - The architecture of the model is saved in a JSON file with the extension `.json`
@@ -172,11 +476,101 @@ class PlainNN{
         void load(std::string file_name, bool weights_only = false);
 
     private:
-        std::vector<Layer*> m_layers;
+        std::vector<BasicLayer<T>*> m_layers;
+
+        // @brief The parameters and the gradients of all the layers, the
+        // tensors of the layers are views of these arenas
+        BasicAlignedBuffer<T> m_params;
+        BasicAlignedBuffer<T> m_grads;
 
-        void _train(
-            DataLoader* train_dataloader,
-            DataLoader* test_dataloader,
+        // @brief The offset of each layer in the arenas and in the state of the optimizer
+        std::vector<long int> m_param_offsets;
+
+        /**
+         * @brief Allocate the arenas for the current layers and
+         * move the parameters and the gradients of the layers into them
+         */
+        void bind_params();
+
+        /**
+         * @brief State owned by each training thread
+         */
+        struct WorkerState{
+            int index;                                          // @brief The index of the worker, also its slot in the profiler
+            std::vector<BasicLayerWorkspace<T> > workspaces;   // @brief One workspace per layer
+            BasicTensor<T> input;                               // @brief The samples of the batch assigned to the worker
+            BasicTensor<T> targets;                             // @brief The one hot targets of the samples
+            std::vector<int> targets_idx;                       // @brief The class index of the samples
+            BasicBatchData<T> batch;                            // @brief The batch read by the worker when it reads its own batches
+            double error;                                       // @brief The error over the samples
+            int correct;                                        // @brief The number of correct predictions
+            std::vector<double> loss_per_class;                 // @brief The error per class, accumulated over a whole evaluation
+            BasicAlignedBuffer<T> grads;                        // @brief The gradients of the workspaces, laid out like the parameters
+        };
+
+        ThreadPool* m_thread_pool;
+        std::vector<WorkerState> m_workers;
+        TrainingStrategy m_training_strategy;
+
+        BasicInferencePlan<T> m_inference_plan;
+
+        /**
+         * @brief Allocate the state of each training thread
+         */
+        void init_workers();
+
+        /**
+         * @brief Forward and backward pass of the samples assigned to a worker,
+         * the gradients are accumulated in the workspaces of the worker
+         * 
+         * @param worker The worker state
+         */
+        void train_worker(WorkerState& worker);
+
+        /**
+         * @brief Forward pass of the samples assigned to a worker during an
+         * evaluation, the error, correct predictions and error per class are
+         * added to the ones of the worker
+         * 
+         * @param worker The worker state
+         * @param input The samples, of shape (rows, features)
+         * @param targets The one hot targets of the samples, row major
+         * @param targets_idx The class index of the samples
+         */
+        void evaluate_worker(WorkerState& worker, BasicTensor<T>& input, const T* targets, const int* targets_idx);
+
+        /**
+         * @brief Sum the gradients of the workers in the layers with
+         * a parallel tree reduction, in log2(num_workers) rounds
+         * 
+         * @param num_workers The number of workers that took part in the step
+         */
+        void reduce_gradients(int num_workers);
+
+        /**
+         * @brief Train one epoch with TrainingStrategy::HOGWILD, every
+         * worker pulls mini-batches until steps_per_epoch are done
+         * 
+         * @param train_dataloader The dataloader for the training data
+         * @param learning_rate The learning rate
+         * @param batch_size The size of the batches
+         * @param steps_per_epoch The number of mini-batches in the epoch
+         * @param loader_time Incremented by the time the workers waited
+         * for a batch, averaged over the workers
+         * 
+         * @return long int The number of samples processed
+         */
+        long int train_epoch_hogwild(
+            BasicDataLoader<T>* train_dataloader,
+            double learning_rate,
+            int batch_size,
+            int steps_per_epoch,
+            double& loader_time
+        );
+
+        TrainingStats _train(
+            BasicDataLoader<T>* train_dataloader,
+            BasicDataLoader<T>* test_dataloader,
             double learning_rate,
             int epochs,
             int batch_size,
@@ -185,6 +579,22 @@ class PlainNN{
         );
 
         LRScheduler *m_lr_scheduler;
+        BasicLoss<T>* m_loss;
+        BasicOptimizer<T>* m_optimizer;
+        Profiler* m_profiler;
+
+        // @brief The names of the events of the layers in the traces, e.g. dense_1.forward,
+        // NUM_LAYER_SECTIONS per layer in the order of ProfileSection
+        std::vector<const char*> m_trace_names;
+
+        /**
+         * @brief Get the names of the layers as shown by the summary,
+         * e.g. dense, dense_1, and their types, e.g. (Dense)
+         * 
+         * @param names Filled with the name of each layer
+         * @param types Filled with the type of each layer
+         */
+        void layer_names(std::vector<std::string>& names, std::vector<std::string>& types);
 
         /**
          * @brief Converts a count to a size in a human readable format
@@ -201,6 +611,17 @@ class PlainNN{
          */
         void count_to_size(int count, char* buff, size_t buff_size, size_t size = 0);
 
+        /**
+         * @brief Converts a count to a human readable format with a metric
+         * suffix, e.g. 1.23 M, or a binary one for bytes, e.g. 1.20 MB
+         * 
+         * @param count The count to convert
+         * @param buff The buffer to write the result to
+         * @param buff_size The size of the buffer
+         * @param bytes Whether the count is a number of bytes
+         */
+        void count_to_readable(double count, char* buff, size_t buff_size, bool bytes = false);
+
         /**
          * @brief Prints a progress bar to the console formatted as follows:
          * {curr_progress}/{max_progress} [{bar}] {trailing_message}
@@ -211,7 +632,7 @@ class PlainNN{
          * @param width The width of the progress bar
          * @param indent Whether to indent the progress bar
          */
-        void print_progress(int curr_progress, int max_progress, std::string trailing_message = "", int width = 50, bool indent = true);
+        void print_progress(int curr_progress, int max_progress, const char* trailing_message = "", int width = 50, bool indent = true);
 
         /**
          * @brief Converts a duration to a human readable format
@@ -222,4 +643,7 @@ class PlainNN{
         void make_duration_readable(const std::chrono::duration<double>& duration, char* buff, size_t buff_size);
 };
 
+typedef BasicPlainNN<double> PlainNN;
+typedef BasicPlainNN<float> PlainNNF;
+
 #endif // PLAIN_NN_PLAIN_NN
\ No newline at end of file
@@ -0,0 +1,147 @@
+#ifndef PLAIN_NN_PROFILER_H
+#define PLAIN_NN_PROFILER_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+/**
+ * @brief Enum to hold the sections of a training step timed by the profiler
+ */
+enum ProfileSection{
+    PROFILE_FORWARD,        // @brief Forward pass of a layer
+    PROFILE_BACKWARD,       // @brief Backward pass of a layer
+    PROFILE_UPDATE,         // @brief Update of the parameters of a layer by the optimizer
+    PROFILE_LOADER,         // @brief Wait for the dataloader to fill a batch
+    PROFILE_REDUCE,         // @brief Sum of the gradients of the threads
+};
+
+const std::string PROFILE_SECTION_NAMES[] = {
+    "Forward",
+    "Backward",
+    "Update",
+    "Loader",
+    "Reduce",
+};
+
+/**
+ * @brief Number of sections timed for each layer, the first ones of ProfileSection
+ */
+const int NUM_LAYER_SECTIONS = 3;
+
+/**
+ * @brief Number of sections of ProfileSection
+ */
+const int NUM_PROFILE_SECTIONS = 5;
+
+/**
+ * @brief Struct to hold the times of an epoch, in seconds
+ * summed over the threads that recorded them
+ */
+struct EpochProfile{
+    int epoch;                                  // @brief The index of the epoch
+    long int steps;                             // @brief The number of training steps
+    int num_threads;                            // @brief The number of threads that recorded times
+    double wall_time;                           // @brief The duration of the epoch, validation excluded
+    std::vector<double> section_time;           // @brief The time spent in each section, over all the layers
+    std::vector<std::vector<double> > layer_time; // @brief The time of each layer in each of the first NUM_LAYER_SECTIONS sections
+};
+
+/**
+ * @brief Records where the time of the training steps goes, per
+ * layer and per section, and aggregates it per epoch.
+ *
+ * Each thread records in its own slot, without synchronization, the
+ * slots are merged at the end of each epoch.
+ */
+class Profiler{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        Profiler();
+
+        /**
+         * @brief Start a training run, the epochs of the previous run are discarded
+         *
+         * @param num_layers The number of layers of the model
+         * @param num_threads The number of threads that record times
+         */
+        void start(int num_layers, int num_threads);
+
+        /**
+         * @brief Add time to a section of a layer
+         *
+         * @param thread_idx The index of the recording thread
+         * @param layer_idx The index of the layer
+         * @param section One of the first NUM_LAYER_SECTIONS sections
+         * @param start The start of the section, the end is now
+         */
+        void record(int thread_idx, int layer_idx, ProfileSection section, Clock::time_point start);
+
+        /**
+         * @brief Add time to a section that does not belong to a layer
+         *
+         * @param thread_idx The index of the recording thread
+         * @param section The section
+         * @param start The start of the section, the end is now
+         */
+        void record(int thread_idx, ProfileSection section, Clock::time_point start);
+
+        /**
+         * @brief Count a training step of the current epoch
+         *
+         * @param thread_idx The index of the thread that completed the step
+         */
+        void count_step(int thread_idx);
+
+        /**
+         * @brief Merge the times recorded by the threads in a new
+         * EpochProfile and clear them for the next epoch
+         *
+         * @param epoch The index of the epoch
+         * @param wall_time The duration of the epoch in seconds
+         */
+        void end_epoch(int epoch, double wall_time);
+
+        /**
+         * @brief Get the profiles of the epochs of the last training run
+         *
+         * @return std::vector<EpochProfile>& The profile of each completed epoch
+         */
+        std::vector<EpochProfile>& epochs(){return m_epochs;}
+
+        /**
+         * @brief Sum the profiles of all the epochs of the last training run
+         *
+         * @return EpochProfile The total, with epoch set to -1
+         */
+        EpochProfile total();
+
+        /**
+         * @brief Prints a profile in a table formatted as follows:
+         * - Layer Name
+         * - Layer Type
+         * - Forward, Backward and Update time in milliseconds per step
+         * - Share of the recorded time
+         *
+         * followed by the sections that do not belong to a layer
+         *
+         * @param profile The profile to print
+         * @param layer_names The name of each layer
+         * @param layer_types The type of each layer
+         */
+        static void print(EpochProfile& profile, std::vector<std::string>& layer_names, std::vector<std::string>& layer_types);
+
+    private:
+        int m_num_layers;
+
+        // @brief The slot of each thread, the time of the NUM_PROFILE_SECTIONS
+        // sections, the number of steps and the NUM_LAYER_SECTIONS times of each
+        // layer. The slots are allocated separately and padded to a cache
+        // line, so that the threads do not write to the same lines
+        std::vector<std::vector<double> > m_slots;
+
+        std::vector<EpochProfile> m_epochs;
+};
+
+#endif // PLAIN_NN_PROFILER_H
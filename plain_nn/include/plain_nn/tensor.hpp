@@ -5,13 +5,60 @@
 #include <initializer_list>
 #include <string>
 
+#include "aligned_buffer.hpp"
+
+/**
+ * @brief Enum to hold the element type of a tensor
+ */
+enum DType{
+    FLOAT32,
+    FLOAT64
+};
+
+/**
+ * @brief Array of element type names
+ */
+const std::string DTYPE_NAMES[] = {
+    "float32",
+    "float64"
+};
+
+/**
+ * @brief Size in bytes of each element type
+ */
+const size_t DTYPE_SIZES[] = {
+    sizeof(float),
+    sizeof(double)
+};
+
+/**
+ * @brief Maps a scalar type to its DType, only
+ * float and double are supported
+ */
+template<typename T> struct DTypeOf;
+template<> struct DTypeOf<float>{ static const DType value = FLOAT32; };
+template<> struct DTypeOf<double>{ static const DType value = FLOAT64; };
+
 /**
  * @brief Class to represent a tensor
+ * 
+ * @tparam T The element type, either float or double
  */
-struct Tensor{
+template<typename T>
+struct BasicTensor{
     public:
 
-        Tensor();
+        BasicTensor();
+
+        BasicTensor(const BasicTensor& other) = default;
+        BasicTensor& operator=(const BasicTensor& other) = default;
+
+        /**
+         * @brief Move constructor, the elements of an owning tensor are
+         * taken over without copying them
+         */
+        BasicTensor(BasicTensor&& other) noexcept = default;
+        BasicTensor& operator=(BasicTensor&& other) noexcept = default;
 
         /**
          * @brief Construct a new Tensor object
@@ -20,7 +67,7 @@ struct Tensor{
          * @param random_init If true, the tensor will be initialized using the Goolorot initialization
          * @param fill_value The value to fill the tensor with, ignored if random_init is true
          */
-        Tensor(std::vector<int> dims, bool random_init = false, double fill_value = 0 );
+        BasicTensor(std::vector<int> dims, bool random_init = false, T fill_value = 0 );
         
         /**
          * @brief Construct a new Tensor object
@@ -29,7 +76,7 @@ struct Tensor{
          * @param random_init If true, the tensor will be initialized using the Goolorot initialization
          * @param fill_value The value to fill the tensor with, ignored if random_init is true
          */
-        Tensor(std::initializer_list<int> dims, bool random_init = false, double fill_value = 0 );
+        BasicTensor(std::initializer_list<int> dims, bool random_init = false, T fill_value = 0 );
 
         /**
          * @brief Construct a new Tensor object with the specified data
@@ -37,7 +84,7 @@ struct Tensor{
          * @param dims The dimensions of the tensor
          * @param data The data to fill the tensor with
          */
-        Tensor(std::initializer_list<int> dims, std::vector<double>& data);
+        BasicTensor(std::initializer_list<int> dims, std::vector<T>& data);
 
         /**
          * @brief Construct a new Tensor object with the specified data
@@ -45,7 +92,54 @@ struct Tensor{
          * @param dims The dimensions of the tensor
          * @param data The data to fill the tensor with
          */
-        Tensor(std::vector<int> dims, std::vector<double>& data);
+        BasicTensor(std::vector<int> dims, std::vector<T>& data);
+
+        /**
+         * @brief Construct a new Tensor object taking over the specified data
+         * 
+         * @param dims The dimensions of the tensor in the form of an initializer list, e.g. {2, 3, 4}
+         * @param data The data of the tensor, moved into the tensor without copying it
+         */
+        BasicTensor(std::initializer_list<int> dims, BasicAlignedVector<T>&& data);
+
+        /**
+         * @brief Construct a new Tensor object taking over the specified data
+         * 
+         * @param dims The dimensions of the tensor
+         * @param data The data of the tensor, moved into the tensor without copying it
+         */
+        BasicTensor(std::vector<int> dims, BasicAlignedVector<T>&& data);
+
+        /**
+         * @brief Construct a Tensor object that views memory it does not own
+         * 
+         * @param dims The dimensions of the tensor
+         * @param data The elements of the tensor, must outlive the
+         * tensor and hold at least the product of dims elements
+         * 
+         * @note Copies of a view are views of the same memory. Reshaping
+         * a view allocates new memory owned by the tensor.
+         */
+        BasicTensor(std::vector<int> dims, T* data);
+
+        /**
+         * @brief Construct a Tensor object that views memory it does not own
+         * 
+         * @param dims The dimensions of the tensor in the form of an initializer list, e.g. {2, 3, 4}
+         * @param data The elements of the tensor, must outlive the
+         * tensor and hold at least the product of dims elements
+         */
+        BasicTensor(std::initializer_list<int> dims, T* data);
+
+        /**
+         * @brief Construct a Tensor object that views strided memory it does not own
+         * 
+         * @param dims The dimensions of the tensor
+         * @param strides The distance in elements between two consecutive
+         * indices of each dimension
+         * @param data The first element of the tensor, must outlive the tensor
+         */
+        BasicTensor(std::vector<int> dims, std::vector<int> strides, T* data);
 
         /**
          * @brief Clears the contents of the tensor
@@ -56,9 +150,10 @@ struct Tensor{
         /**
          * @brief Get the shape of the tensor as a vector
          * 
-         * @return std::vector<int> The shape of the tensor
+         * @return const std::vector<int>& The shape of the tensor, valid
+         * until the tensor is reshaped
          */
-        std::vector<int> shape();
+        const std::vector<int>& shape();
 
         /**
          * @brief Get the shape of the tensor at a specific index
@@ -68,14 +163,45 @@ struct Tensor{
          */
         int shape(int index);
 
+        /**
+         * @brief Get the stride of a dimension, i.e. the distance in
+         * elements between two consecutive indices of the dimension
+         * 
+         * @param index The index of the dimension
+         * @return int The stride of the dimension
+         */
+        int stride(int index);
+
+        /**
+         * @brief Get the strides of all the dimensions
+         * 
+         * @return const std::vector<int>& The strides, valid until the tensor is reshaped
+         */
+        const std::vector<int>& strides();
+
+        /**
+         * @brief Whether the elements are laid out in row-major
+         * order without gaps, always true for owning tensors
+         * 
+         * @return bool True if the tensor is contiguous
+         */
+        bool is_contiguous();
+
+        /**
+         * @brief Get the number of dimensions of the tensor
+         * 
+         * @return int The number of dimensions
+         */
+        int ndim();
+
         /**
          * @brief Get the data of the tensor
          * 
-         * @return double* The data of the tensor
+         * @return T* The data of the tensor
          * 
          * @note It is the caller's responsibility to know how to interpret the data
          */
-        double* data();
+        T* data();
 
         /**
          * @brief Get the size of the tensor, i.e. the number of elements
@@ -88,12 +214,54 @@ struct Tensor{
          * @brief Get the value at the specified index
          * 
          * @param index The index to get the value from
-         * @return double& The value at the index
+         * @return T& The value at the index
          * 
          * @note If fast access is required, e.g. in a loop, prefer
-         * the data() method and access the data directly
+         * the data() method and access the data directly. The index
+         * is an offset from data(), which for a non contiguous view
+         * is not the position in row-major order.
          */
-        double& operator[](int index);
+        T& operator[](int index);
+
+        /**
+         * @brief Get a view of the whole tensor
+         * 
+         * @return BasicTensor<T> A view of the elements of the tensor,
+         * valid as long as the elements are not reallocated
+         */
+        BasicTensor<T> view();
+
+        /**
+         * @brief Get a view of the tensor with a different shape
+         * 
+         * @param dims The new dimensions, with the same number of elements
+         * @return BasicTensor<T> A view of the elements of the tensor
+         * 
+         * @note Throws a std::runtime_error if the tensor is not contiguous
+         * or if the number of elements differs
+         */
+        BasicTensor<T> view(std::vector<int> dims);
+
+        /**
+         * @brief Get a view of the indices [start, end) of a dimension,
+         * nothing is copied
+         * 
+         * @param start The first index
+         * @param end The index after the last one
+         * @param dim The dimension to slice, default is 0, i.e. the batch
+         * dimension, which keeps the view contiguous
+         * @return BasicTensor<T> A view of the slice
+         * 
+         * @note Throws a std::runtime_error if the range is out of bounds
+         */
+        BasicTensor<T> slice(int start, int end, int dim = 0);
+
+        /**
+         * @brief Get a contiguous copy of the tensor
+         * 
+         * @return BasicTensor<T> A tensor owning a row-major copy of the elements
+         */
+        BasicTensor<T> contiguous();
         
         /**
          * @brief Reshape the tensor
@@ -104,7 +272,18 @@ struct Tensor{
          * 
          * @note The contents of the tensor will be lost after reshaping
          */
-        void reshape(std::initializer_list<int> dims, bool random_init = false, double fill_value = 0);
+        void reshape(std::initializer_list<int> dims, bool random_init = false, T fill_value = 0);
+
+        /**
+         * @brief Reshape the tensor
+         * 
+         * @param dims The new dimensions of the tensor
+         * @param random_init If true, the tensor will be initialized using the Goolorot initialization
+         * @param fill_value The value to fill the tensor with, ignored if random_init is true
+         * 
+         * @note The contents of the tensor will be lost after reshaping
+         */
+        void reshape(std::vector<int> dims, bool random_init = false, T fill_value = 0);
 
         /**
          * @brief Get a string representation of the shape
@@ -113,9 +292,51 @@ struct Tensor{
          */
         std::string shape_str();
 
+        /**
+         * @brief Get the element type of the tensor
+         * 
+         * @return DType The element type
+         */
+        DType dtype(){return DTypeOf<T>::value;}
+
+        /**
+         * @brief Whether the tensor views memory it does not own
+         * 
+         * @return bool True if the tensor is a view
+         */
+        bool is_view(){return m_view != nullptr;}
+
     private:
         std::vector<int> m_shape;
-        std::vector<double> m_data;
+        std::vector<int> m_strides;
+        // @brief The owned elements, aligned to BUFFER_ALIGNMENT
+        BasicAlignedVector<T> m_data;
+
+        // @brief The viewed memory, a null pointer when the tensor owns m_data
+        T* m_view = nullptr;
+        int m_view_size = 0;
+
+        /**
+         * @brief Set the shape and the row-major strides of the tensor
+         * 
+         * @param dims The dimensions of the tensor
+         * @return int The number of elements
+         */
+        int set_shape(std::vector<int> dims);
 };
 
+typedef BasicTensor<double> Tensor;
+typedef BasicTensor<float> TensorF;
+
+/**
+ * @brief Stack a list of tensors with the same shape along
+ * a new leading dimension, e.g. N tensors of shape (784) become
+ * a single tensor of shape (N, 784)
+ * 
+ * @param tensors The tensors to stack
+ * @return BasicTensor<T> The stacked tensor
+ */
+template<typename T>
+BasicTensor<T> stack(std::vector<BasicTensor<T> >& tensors);
+
 #endif // PLAIN_NN_TENSOR_H
\ No newline at end of file
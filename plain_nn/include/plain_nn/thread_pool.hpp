@@ -0,0 +1,79 @@
+#ifndef PLAIN_NN_THREAD_POOL_H
+#define PLAIN_NN_THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+/**
+ * @brief Pool of persistent worker threads. The threads are
+ * created once and wait on a condition variable between jobs,
+ * so that dispatching work on every training step does not pay
+ * for thread creation.
+ */
+class ThreadPool{
+    public:
+
+        /**
+         * @brief Construct a new ThreadPool object
+         *
+         * @param num_threads The number of threads that execute the tasks,
+         * including the calling thread. A pool of size 1 runs everything
+         * on the calling thread and never starts a worker.
+         */
+        ThreadPool(int num_threads);
+        ~ThreadPool();
+
+        /**
+         * @brief Get the number of threads that execute the tasks,
+         * including the calling thread
+         *
+         * @return int The number of threads
+         */
+        int size();
+
+        /**
+         * @brief Run task(i) for each i in [0, num_tasks) and wait
+         * for all of them to complete
+         *
+         * @param num_tasks The number of tasks
+         * @param task The function to run, called with the task index
+         *
+         * @note Tasks are distributed dynamically among the worker threads
+         * and the calling thread, which also takes part in the work. The
+         * order of execution is unspecified. Calls must not be nested.
+         */
+        void run(int num_tasks, const std::function<void(int)>& task);
+
+    private:
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_start_cv;
+        std::condition_variable m_done_cv;
+
+        const std::function<void(int)>* m_task;
+        int m_num_tasks;
+        std::atomic<int> m_next_task;
+
+        long int m_generation;
+        int m_active_workers;
+        bool m_stop;
+
+        /**
+         * @brief Main loop of the worker threads
+         * 
+         * @param worker_idx The index of the worker thread, used to name it in the traces
+         */
+        void worker_loop(int worker_idx);
+
+        /**
+         * @brief Execute tasks until none are left for the current job
+         */
+        void execute_tasks();
+};
+
+#endif // PLAIN_NN_THREAD_POOL_H
@@ -0,0 +1,142 @@
+#ifndef PLAIN_NN_TRACE_H
+#define PLAIN_NN_TRACE_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+
+/**
+ * @brief Process wide recorder of timeline events, saved in the
+ * Chrome trace event format that about:tracing and Perfetto open.
+ *
+ * Each thread appends the events of its TraceScope objects to its own
+ * buffer, under a lock of that buffer that is only contended while the
+ * trace is saved or restarted. While tracing is stopped a scope only
+ * checks a flag.
+ */
+class Tracer{
+    public:
+        /**
+         * @brief Start recording, the events of a previous recording are discarded
+         *
+         * @param max_events_per_thread The number of events kept per thread,
+         * the following ones are dropped and counted, default is 1M
+         *
+         * @note The events of the scopes still open are recorded when they
+         * close, even after stop, and may land in the saved file or in the
+         * next recording
+         */
+        static void start(long int max_events_per_thread = 1 << 20);
+
+        /**
+         * @brief Stop recording, the recorded events are kept until the next start
+         */
+        static void stop();
+
+        /**
+         * @brief Whether events are being recorded
+         *
+         * @return bool True between start and stop
+         */
+        static bool enabled(){return s_enabled.load(std::memory_order_relaxed);}
+
+        /**
+         * @brief Save the recorded events as a Chrome trace JSON file
+         *
+         * @param file_name The path of the file, e.g. trace.json
+         *
+         * @note Throws a std::runtime_error if the file can not be written
+         */
+        static void save(std::string file_name);
+
+        /**
+         * @brief Get the number of recorded events, over all the threads
+         *
+         * @return long int The number of events
+         */
+        static long int num_events();
+
+        /**
+         * @brief Get the number of events dropped because the buffer
+         * of their thread was full
+         *
+         * @return long int The number of dropped events
+         */
+        static long int num_dropped();
+
+        /**
+         * @brief Name the calling thread in the timeline
+         *
+         * @param name The name of the thread, e.g. "prefetch"
+         *
+         * @note The thread is listed in the saved trace from then on,
+         * even if it records no event
+         */
+        static void set_thread_name(std::string name);
+
+        /**
+         * @brief Get a copy of a name that lives until the end of the
+         * process, for the names of the events built at runtime
+         *
+         * @param name The name
+         * @return const char* The stored copy, the same for equal names
+         */
+        static const char* intern(std::string name);
+
+        /**
+         * @brief Get the current time of the trace clock
+         *
+         * @return long int The time in nanoseconds
+         */
+        static long int now(){
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        /**
+         * @brief Record a complete event on the calling thread
+         *
+         * @param name The name of the event, must outlive the trace
+         * @param category The category of the event, must outlive the trace
+         * @param start The start of the event, from now()
+         * @param end The end of the event, from now()
+         */
+        static void record(const char* name, const char* category, long int start, long int end);
+
+    private:
+        static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief Records the lifetime of the scope as an event of the
+ * calling thread when tracing is enabled
+ */
+class TraceScope{
+    public:
+        /**
+         * @brief Construct a new TraceScope object
+         *
+         * @param name The name of the event, must outlive the trace,
+         * e.g. a string literal or the result of Tracer::intern
+         * @param category The category of the event, default is "plain_nn"
+         */
+        TraceScope(const char* name, const char* category = "plain_nn"){
+            m_name = Tracer::enabled() ? name : nullptr;
+            m_category = category;
+            m_start = m_name != nullptr ? Tracer::now() : 0;
+        }
+
+        ~TraceScope(){
+            if(m_name != nullptr) Tracer::record(m_name, m_category, m_start, Tracer::now());
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        const char* m_name;
+        const char* m_category;
+        long int m_start;
+};
+
+#endif // PLAIN_NN_TRACE_H
@@ -0,0 +1,133 @@
+#include "aligned_buffer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <new>
+#include <atomic>
+#include <sys/mman.h>
+
+static std::atomic<int> current_huge_page_mode(HUGE_PAGES_TRANSPARENT);
+
+void set_huge_page_mode(HugePageMode mode){
+    current_huge_page_mode.store(mode);
+}
+
+HugePageMode huge_page_mode(){
+    return static_cast<HugePageMode>(current_huge_page_mode.load());
+}
+
+// The length of the mapping of a large buffer, whole huge pages
+static size_t mapped_length(size_t bytes){
+    return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+void* aligned_allocate(size_t bytes){
+    if(bytes == 0) return nullptr;
+
+    if(bytes < HUGE_PAGE_SIZE){
+        void* memory = nullptr;
+        if(posix_memalign(&memory, BUFFER_ALIGNMENT, bytes) != 0) throw std::bad_alloc();
+        return memory;
+    }
+
+    size_t length = mapped_length(bytes);
+    HugePageMode mode = huge_page_mode();
+
+    if(mode == HUGE_PAGES_EXPLICIT){
+        void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(memory != MAP_FAILED) return memory;
+        // No huge page is reserved, fall back to transparent ones
+    }
+
+    // A transparent huge page can only back an aligned range of
+    // HUGE_PAGE_SIZE bytes, one more page is mapped and the
+    // unaligned head and tail are unmapped
+    void* region = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED) throw std::bad_alloc();
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(region);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    uintptr_t end = start + length + HUGE_PAGE_SIZE;
+    if(aligned > start) munmap(region, aligned - start);
+    if(end > aligned + length) munmap(reinterpret_cast<void*>(aligned + length), end - aligned - length);
+
+    void* memory = reinterpret_cast<void*>(aligned);
+    if(mode != HUGE_PAGES_OFF){
+        // Only a hint, ignored when transparent huge pages are disabled
+        madvise(memory, length, MADV_HUGEPAGE);
+    }
+    return memory;
+}
+
+void aligned_free(void* ptr, size_t bytes){
+    if(ptr == nullptr) return;
+
+    // Both kinds of mappings of a large buffer span whole huge pages
+    if(bytes < HUGE_PAGE_SIZE) std::free(ptr);
+    else munmap(ptr, mapped_length(bytes));
+}
+
+template<typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer() : m_data(nullptr), m_size(0){}
+
+template<typename T>
+BasicAlignedBuffer<T>::~BasicAlignedBuffer(){
+    release();
+}
+
+template<typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer(BasicAlignedBuffer&& other) noexcept : m_data(other.m_data), m_size(other.m_size){
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+template<typename T>
+BasicAlignedBuffer<T>& BasicAlignedBuffer<T>::operator=(BasicAlignedBuffer&& other) noexcept{
+    if(this != &other){
+        release();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+template<typename T>
+void BasicAlignedBuffer<T>::allocate(long int size){
+    release();
+    if(size <= 0) return;
+
+    void* memory = nullptr;
+    size_t bytes = align_count<T>(size) * sizeof(T);
+    try{
+        memory = aligned_allocate(bytes);
+    } catch(const std::bad_alloc&){
+        throw std::runtime_error("Failed to allocate " + std::to_string(bytes) + " bytes");
+    }
+
+    // Large buffers are fresh mappings, already zeroed and not yet
+    // touched, so that their pages are only faulted in when used
+    if(bytes < HUGE_PAGE_SIZE) std::memset(memory, 0, bytes);
+
+    m_data = static_cast<T*>(memory);
+    m_size = size;
+}
+
+template<typename T>
+void BasicAlignedBuffer<T>::release(){
+    aligned_free(m_data, align_count<T>(m_size) * sizeof(T));
+    m_data = nullptr;
+    m_size = 0;
+}
+
+template<typename T>
+void BasicAlignedBuffer<T>::clear(){
+    if(m_data != nullptr) std::memset(m_data, 0, m_size * sizeof(T));
+}
+
+template class BasicAlignedBuffer<float>;
+template class BasicAlignedBuffer<double>;
@@ -0,0 +1,207 @@
+#include "batch_scheduler.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+template<typename T>
+BasicBatchScheduler<T>::BasicBatchScheduler(
+    BasicPlainNN<T>& model,
+    int max_batch_size,
+    double max_wait_ms,
+    int num_threads
+) : m_model(model){
+    if(max_batch_size < 1){
+        throw std::runtime_error("Maximum batch size must be at least 1, got " + std::to_string(max_batch_size));
+    }
+    if(max_wait_ms < 0){
+        throw std::runtime_error("Maximum wait must not be negative, got " + std::to_string(max_wait_ms));
+    }
+    if(num_threads < 1){
+        throw std::runtime_error("Batch scheduler needs at least one thread, got " + std::to_string(num_threads));
+    }
+
+    m_input_size = model.input_size();
+    m_output_size = model.output_size();
+    m_max_batch_size = max_batch_size;
+    m_max_wait = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(max_wait_ms));
+    m_stop = false;
+
+    // The plans are built here so that an invalid model
+    // throws to the caller instead of in a thread
+    for(int i = 0; i < num_threads; i++){
+        m_plans.push_back(model.create_inference_plan(max_batch_size));
+    }
+
+    m_stats.queue_depth = 0;
+    reset_stats();
+
+    for(int i = 0; i < num_threads; i++){
+        m_threads.push_back(std::thread(&BasicBatchScheduler<T>::batch_loop, this, i));
+    }
+}
+
+template<typename T>
+BasicBatchScheduler<T>::~BasicBatchScheduler(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for(size_t i = 0; i < m_threads.size(); i++){
+        m_threads[i].join();
+    }
+}
+
+template<typename T>
+std::future<BasicTensor<T> > BasicBatchScheduler<T>::submit(BasicTensor<T>& sample){
+    if(sample.size() != m_input_size){
+        throw std::runtime_error("Sample of " + std::to_string(sample.size()) + " features submitted to a model with input size " + std::to_string(m_input_size));
+    }
+
+    Request request;
+    request.input.assign(sample.data(), sample.data() + m_input_size);
+    std::future<BasicTensor<T> > output = request.output.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_stop){
+            throw std::runtime_error("Sample submitted to a batch scheduler that is stopping");
+        }
+        request.submit_time = Clock::now();
+        m_queue.push_back(std::move(request));
+
+        m_stats.queue_depth = m_queue.size();
+        m_stats.max_queue_depth = std::max(m_stats.max_queue_depth, m_stats.queue_depth);
+    }
+
+    // A thread may be waiting for the batch to fill up
+    m_cv.notify_all();
+    return output;
+}
+
+template<typename T>
+void BasicBatchScheduler<T>::batch_loop(int thread_idx){
+    Tracer::set_thread_name("batch scheduler " + std::to_string(thread_idx));
+
+    BasicInferencePlan<T>& plan = m_plans[thread_idx];
+    BasicTensor<T> batch({m_max_batch_size, m_input_size});
+    std::vector<Request> requests;
+    requests.reserve(m_max_batch_size);
+
+    // A first pass grows the packing buffers of the
+    // matrix products on this thread to their final size
+    m_model.predict(plan.workspaces[0].output, plan);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true){
+        m_cv.wait(lock, [this]{ return m_stop || !m_queue.empty(); });
+        if(m_queue.empty()) return;
+
+        // Wait for more samples until the batch is full or the oldest sample
+        // has waited long enough. Another thread can take the samples meanwhile,
+        // the deadline always follows the oldest one still waiting
+        while(!m_stop && !m_queue.empty() && static_cast<int>(m_queue.size()) < m_max_batch_size){
+            Clock::time_point deadline = m_queue.front().submit_time + m_max_wait;
+            if(Clock::now() >= deadline) break;
+            m_cv.wait_until(lock, deadline);
+        }
+        if(m_queue.empty()) continue;
+
+        Clock::time_point s_time = Clock::now();
+        int batch_size = std::min(static_cast<int>(m_queue.size()), m_max_batch_size);
+        for(int i = 0; i < batch_size; i++){
+            std::chrono::duration<double, std::milli> queue_time = s_time - m_queue.front().submit_time;
+            m_total_queue_time += queue_time.count();
+            m_stats.max_queue_time = std::max(m_stats.max_queue_time, queue_time.count());
+
+            requests.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+
+        m_stats.requests += batch_size;
+        m_stats.batches++;
+        m_stats.batch_sizes[batch_size]++;
+        m_stats.queue_depth = m_queue.size();
+        lock.unlock();
+
+        run_batch(requests, batch, plan);
+        requests.clear();
+
+        lock.lock();
+    }
+}
+
+template<typename T>
+void BasicBatchScheduler<T>::run_batch(std::vector<Request>& requests, BasicTensor<T>& batch, BasicInferencePlan<T>& plan){
+    TraceScope scope("batch", "inference");
+
+    int batch_size = requests.size();
+    T* _batch = batch.data();
+    for(int i = 0; i < batch_size; i++){
+        std::memcpy(_batch + static_cast<size_t>(i) * m_input_size, requests[i].input.data(), m_input_size * sizeof(T));
+    }
+
+    try{
+        // The samples are the first rows of the buffer
+        BasicTensor<T> input({batch_size, m_input_size}, _batch);
+        BasicTensor<T>& output = m_model.predict(input, plan);
+
+        const T* _output = output.data();
+        for(int i = 0; i < batch_size; i++){
+            BasicTensor<T> sample_output({m_output_size});
+            std::memcpy(sample_output.data(), _output + static_cast<size_t>(i) * m_output_size, m_output_size * sizeof(T));
+            requests[i].output.set_value(std::move(sample_output));
+        }
+    } catch(...){
+        for(int i = 0; i < batch_size; i++){
+            requests[i].output.set_exception(std::current_exception());
+        }
+    }
+}
+
+template<typename T>
+BatchSchedulerStats BasicBatchScheduler<T>::stats(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    BatchSchedulerStats stats = m_stats;
+    stats.avg_batch_size = stats.batches > 0 ? static_cast<double>(stats.requests) / stats.batches : 0;
+    stats.avg_queue_time = stats.requests > 0 ? m_total_queue_time / stats.requests : 0;
+    return stats;
+}
+
+template<typename T>
+void BasicBatchScheduler<T>::reset_stats(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_stats.requests = 0;
+    m_stats.batches = 0;
+    m_stats.max_queue_depth = m_stats.queue_depth;
+    m_stats.batch_sizes.assign(m_max_batch_size + 1, 0);
+    m_stats.avg_batch_size = 0;
+    m_stats.avg_queue_time = 0;
+    m_stats.max_queue_time = 0;
+    m_total_queue_time = 0;
+}
+
+template<typename T>
+void BasicBatchScheduler<T>::print_stats(){
+    BatchSchedulerStats stats = this->stats();
+
+    std::printf("Batches: %ld, requests: %ld, average batch size: %.2f\n", stats.batches, stats.requests, stats.avg_batch_size);
+    std::printf("Queue depth: %d, max queue depth: %d\n", stats.queue_depth, stats.max_queue_depth);
+    std::printf("Queue time: %.3f ms on average, %.3f ms at most\n", stats.avg_queue_time, stats.max_queue_time);
+
+    // Only the sizes that occurred, each bar relative to the most frequent one
+    long int max_count = *std::max_element(stats.batch_sizes.begin(), stats.batch_sizes.end());
+    for(size_t size = 1; size < stats.batch_sizes.size(); size++){
+        if(stats.batch_sizes[size] == 0) continue;
+        int width = static_cast<int>(40.0 * stats.batch_sizes[size] / max_count + 0.5);
+        std::printf("%6zu | %-40s %ld\n", size, std::string(std::max(width, 1), '#').c_str(), stats.batch_sizes[size]);
+    }
+}
+
+template class BasicBatchScheduler<float>;
+template class BasicBatchScheduler<double>;
@@ -1,22 +1,41 @@
 #include "data_loaders.hpp"
+#include "kernels.hpp"
 
 #include <iostream>
-#include <fstream>
 #include <algorithm>
+#include <stdexcept>
 #include <random>
 #include <memory>
+#include <climits>
+
+// Magic numbers of the IDX files of unsigned bytes, with
+// three dimensions for the images and one for the labels
+static const int IDX_IMAGES_MAGIC = 0x00000803;
+static const int IDX_LABELS_MAGIC = 0x00000801;
+
+/**
+ * @brief Read a big endian 32 bit integer of an IDX header
+ */
+static int read_idx_int(const unsigned char* data){
+    int value;
+    std::copy(data, data + sizeof(value), reinterpret_cast<unsigned char*>(&value));
+    return __builtin_bswap32(value);
+}
 
-Tensor one_hot_encode(int label_idx, int num_classes){
-    Tensor one_hot({num_classes});
+template<typename T>
+BasicTensor<T> one_hot_encode(int label_idx, int num_classes){
+    BasicTensor<T> one_hot({num_classes});
     one_hot[label_idx] = 1;
     return one_hot;
 }
 
-int MNISTDataLoader::num_classes(){
+template<typename T>
+int BasicMNISTDataLoader<T>::num_classes(){
     return 10;
 }
 
-MNISTDataLoader::MNISTDataLoader(
+template<typename T>
+BasicMNISTDataLoader<T>::BasicMNISTDataLoader(
     std::string data_path, 
     std::string labels_path,
     bool shuffle,
@@ -27,12 +46,19 @@ MNISTDataLoader::MNISTDataLoader(
     this->m_shuffle = shuffle;
     this->m_drop_last = drop_last;
 
+    this->m_images = nullptr;
+    this->m_labels = nullptr;
+    this->m_num_images = 0;
+    this->m_num_labels = 0;
+    this->m_image_size = 0;
+
     this->m_offset = 0;
 
     this->rng = std::default_random_engine();
 }
 
-int MNISTDataLoader::steps_per_epoch(int batch_size){
+template<typename T>
+int BasicMNISTDataLoader<T>::steps_per_epoch(int batch_size){
 
     if(batch_size <= 0){
         std::cerr << "Batch size must be greater than 0" << std::endl;
@@ -40,108 +66,132 @@ int MNISTDataLoader::steps_per_epoch(int batch_size){
     }
 
     if(m_drop_last)
-        return m_dataset.size() / batch_size;
+        return m_indices.size() / batch_size;
     else
-        return (m_dataset.size() + batch_size - 1) / batch_size;
+        return (m_indices.size() + batch_size - 1) / batch_size;
 }
 
-BatchData MNISTDataLoader::get_batch(int batch_size){
-    if(static_cast<size_t>(m_offset + batch_size) > m_dataset.size() && m_drop_last){
+template<typename T>
+void BasicMNISTDataLoader<T>::fill_batch(int batch_size, BasicBatchData<T>& batch){
+    if(static_cast<size_t>(m_offset + batch_size) > m_indices.size() && m_drop_last){
         new_epoch();
-        return BatchData();
+        batch.targets_idx.clear();
+        return;
     }
 
-    BatchData batch;
+    int end = std::min(m_offset + batch_size, static_cast<int>(m_indices.size()));
+    int count = std::max(end - m_offset, 0);
+
+    batch.resize(count, m_image_size, num_classes());
 
-    for(int i = m_offset, count = 0; i < m_offset + batch_size; i++, count++){
-        
-        batch.input_data.emplace_back(m_dataset[i].data);
+    T* _input_data = batch.input_data.data();
+    T* _targets_one_hot = batch.targets_one_hot.data();
 
-        batch.targets_idx.emplace_back(m_dataset[i].target);
-        batch.targets_one_hot.emplace_back(
-            one_hot_encode(m_dataset[i].target, 10)
-        );
+    const BasicKernelTable<T>& kernels = get_kernels<T>();
+    for(int i = 0; i < count; i++){
+        int item_idx = m_indices[m_offset + i];
+
+        // The raw pixels are gathered and converted straight from
+        // the mapped file into the row of the batch
+        kernels.scale_u8(m_image_size, m_images + static_cast<size_t>(item_idx) * m_image_size,
+            static_cast<T>(1 / 255.0), _input_data + i * m_image_size);
+
+        batch.targets_idx[i] = m_labels[item_idx];
+        _targets_one_hot[i * num_classes() + m_labels[item_idx]] = 1;
     }
 
     m_offset += batch_size;
-    
-    return batch;
 }
 
-void MNISTDataLoader::new_epoch(){
+template<typename T>
+void BasicMNISTDataLoader<T>::new_epoch(){
     m_offset = 0;
     if(m_shuffle)
         shuffle();
 }
 
-void MNISTDataLoader::load(){
+template<typename T>
+void BasicMNISTDataLoader<T>::load(){
     load_data();
     load_labels();
+
+    if(m_num_images != m_num_labels){
+        throw std::runtime_error("The number of images (" + std::to_string(m_num_images) +
+            ") and labels (" + std::to_string(m_num_labels) + ") do not match");
+    }
+
+    m_indices.resize(m_num_images);
+    for(int i = 0; i < m_num_images; i++){
+        m_indices[i] = i;
+    }
+    m_offset = 0;
 }
 
-void MNISTDataLoader::shuffle(){
-    std::shuffle(m_dataset.begin(), m_dataset.end(), rng);
+template<typename T>
+void BasicMNISTDataLoader<T>::shuffle(){
+    std::shuffle(m_indices.begin(), m_indices.end(), rng);
 }
 
-void MNISTDataLoader::load_data(){
-    std::ifstream data_file(m_data_path, std::ios::binary);
-    if(!data_file.is_open()){
-        throw std::runtime_error("Error opening file: " + m_data_path);
+template<typename T>
+void BasicMNISTDataLoader<T>::load_data(){
+    m_data_file.open(m_data_path);
+
+    // header: magic number, number of images, rows, cols
+    const size_t header_size = 4 * sizeof(int);
+    if(m_data_file.size() < header_size || read_idx_int(m_data_file.data()) != IDX_IMAGES_MAGIC){
+        throw std::runtime_error("Not an IDX images file: " + m_data_path);
     }
 
-    int magic_number = 0;
-    int number_of_images = 0;
-    int rows = 0;
-    int cols = 0;
-
-    // read file metadata
-    data_file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
-    magic_number = __builtin_bswap32(magic_number);
-    data_file.read(reinterpret_cast<char*>(&number_of_images), sizeof(number_of_images));
-    number_of_images = __builtin_bswap32(number_of_images);
-    data_file.read(reinterpret_cast<char*>(&rows), sizeof(rows));
-    rows = __builtin_bswap32(rows);
-    data_file.read(reinterpret_cast<char*>(&cols), sizeof(cols));
-    cols = __builtin_bswap32(cols);
-
-    if(m_dataset.size() != static_cast<size_t>(number_of_images))
-        m_dataset.resize(number_of_images);
-
-    for(int i=0; i<number_of_images; i++){
-        m_dataset[i].data = Tensor({rows*cols});
-        for(int j=0; j<rows*cols; j++){
-            unsigned char pixel = 0;
-            data_file.read(reinterpret_cast<char*>(&pixel), sizeof(pixel));
-            m_dataset[i].data[j] = (static_cast<double>(pixel) / 255.0);
-        }
+    const unsigned char* header = m_data_file.data();
+    m_num_images = read_idx_int(header + 4);
+    int rows = read_idx_int(header + 8);
+    int cols = read_idx_int(header + 12);
+
+    // The sizes are checked before they are used to bound the mapped file
+    if(m_num_images <= 0 || rows <= 0 || cols <= 0 || static_cast<long int>(rows) * cols > INT_MAX){
+        throw std::runtime_error("Invalid IDX images header, " + std::to_string(m_num_images) + " images of " +
+            std::to_string(rows) + "x" + std::to_string(cols) + " pixels: " + m_data_path);
+    }
+    m_image_size = rows * cols;
+
+    if(m_data_file.size() < header_size + static_cast<size_t>(m_num_images) * m_image_size){
+        throw std::runtime_error("Truncated IDX images file: " + m_data_path);
     }
 
-    data_file.close();
+    m_images = m_data_file.data() + header_size;
 }
 
-void MNISTDataLoader::load_labels(){
-    std::ifstream labels_file(m_labels_path, std::ios::binary);
-    if(!labels_file.is_open()){
-        throw std::runtime_error("Error opening file: " + m_labels_path);
+template<typename T>
+void BasicMNISTDataLoader<T>::load_labels(){
+    m_labels_file.open(m_labels_path);
+
+    // header: magic number, number of labels
+    const size_t header_size = 2 * sizeof(int);
+    if(m_labels_file.size() < header_size || read_idx_int(m_labels_file.data()) != IDX_LABELS_MAGIC){
+        throw std::runtime_error("Not an IDX labels file: " + m_labels_path);
+    }
+
+    m_num_labels = read_idx_int(m_labels_file.data() + 4);
+    if(m_num_labels <= 0){
+        throw std::runtime_error("Invalid IDX labels header, " + std::to_string(m_num_labels) + " labels: " + m_labels_path);
     }
 
-    int magic_number = 0;
-    int number_of_labels = 0;
-
-    // read file metadata
-    labels_file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
-    magic_number = __builtin_bswap32(magic_number);
-    labels_file.read(reinterpret_cast<char*>(&number_of_labels), sizeof(number_of_labels));
-    number_of_labels = __builtin_bswap32(number_of_labels);
-
-    if(m_dataset.size() != static_cast<size_t>(number_of_labels))
-        m_dataset.resize(number_of_labels);
-    
-    for(int i=0; i<number_of_labels; i++){
-        unsigned char label = 0;
-        labels_file.read(reinterpret_cast<char*>(&label), sizeof(label));
-        m_dataset[i].target = label;
+    if(m_labels_file.size() < header_size + static_cast<size_t>(m_num_labels)){
+        throw std::runtime_error("Truncated IDX labels file: " + m_labels_path);
     }
 
-    labels_file.close();
-}
\ No newline at end of file
+    m_labels = m_labels_file.data() + header_size;
+
+    // The labels index the columns of the one-hot targets
+    for(int i = 0; i < m_num_labels; i++){
+        if(m_labels[i] >= num_classes()){
+            throw std::runtime_error("Label " + std::to_string(m_labels[i]) + " of item " + std::to_string(i) +
+                " is not below " + std::to_string(num_classes()) + ": " + m_labels_path);
+        }
+    }
+}
+
+template BasicTensor<float> one_hot_encode<float>(int label_idx, int num_classes);
+template BasicTensor<double> one_hot_encode<double>(int label_idx, int num_classes);
+template class BasicMNISTDataLoader<float>;
+template class BasicMNISTDataLoader<double>;
@@ -0,0 +1,183 @@
+#include "data_loaders.hpp"
+#include "trace.hpp"
+
+#include <stdexcept>
+#include <chrono>
+
+template<typename T>
+BasicPrefetchDataLoader<T>::BasicPrefetchDataLoader(
+    BasicDataLoader<T>& dataloader,
+    int depth
+) : m_dataloader(dataloader){
+    if(depth < 1){
+        throw std::runtime_error("Prefetch depth must be at least 1, got " + std::to_string(depth));
+    }
+
+    m_ring.resize(depth);
+    m_head = 0;
+    m_ready = 0;
+    m_batch_size = 0;
+    m_remaining = 0;
+    m_filling = false;
+    m_stop = false;
+    m_stall_time = 0;
+    m_error = nullptr;
+
+    m_producer = std::thread(&BasicPrefetchDataLoader<T>::producer_loop, this);
+}
+
+template<typename T>
+BasicPrefetchDataLoader<T>::~BasicPrefetchDataLoader(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_free_cv.notify_all();
+    m_producer.join();
+}
+
+template<typename T>
+void BasicPrefetchDataLoader<T>::producer_loop(){
+    Tracer::set_thread_name("prefetch");
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while(true){
+        m_free_cv.wait(lock, [this]{
+            return m_stop || (m_remaining > 0 && m_ready < static_cast<int>(m_ring.size()));
+        });
+        if(m_stop) return;
+
+        // The slot is not visible to the consumer until it is
+        // marked as ready, so it is filled without the lock
+        int slot = (m_head + m_ready) % m_ring.size();
+        int batch_size = m_batch_size;
+        m_remaining--;
+        m_filling = true;
+        lock.unlock();
+
+        std::exception_ptr error = nullptr;
+        try{
+            TraceScope scope("prefetch_batch", "loader");
+            m_dataloader.fill_batch(batch_size, m_ring[slot]);
+        } catch(...){
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        m_filling = false;
+        if(error){
+            m_error = error;
+            m_remaining = 0;
+        } else{
+            m_ready++;
+        }
+        m_ready_cv.notify_all();
+    }
+}
+
+template<typename T>
+void BasicPrefetchDataLoader<T>::drain(std::unique_lock<std::mutex>& lock){
+    m_remaining = 0;
+    m_ready_cv.wait(lock, [this]{ return !m_filling; });
+    m_head = 0;
+    m_ready = 0;
+}
+
+template<typename T>
+void BasicPrefetchDataLoader<T>::restart(int batch_size){
+    m_batch_size = batch_size;
+    m_remaining = m_dataloader.steps_per_epoch(batch_size);
+    m_free_cv.notify_one();
+}
+
+template<typename T>
+void BasicPrefetchDataLoader<T>::fill_batch(int batch_size, BasicBatchData<T>& batch){
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if(batch_size != m_batch_size){
+        // The batches prefetched with the previous size are discarded,
+        // the wrapped loader has already moved past them
+        if(m_batch_size != 0){
+            drain(lock);
+            m_dataloader.new_epoch();
+        }
+        restart(batch_size);
+    }
+
+    auto wait_s_time = std::chrono::system_clock::now();
+    {
+        TraceScope scope("wait_batch", "loader");
+        m_ready_cv.wait(lock, [this]{
+            return m_ready > 0 || m_error || (m_remaining == 0 && !m_filling);
+        });
+    }
+    std::chrono::duration<double> wait_duration = std::chrono::system_clock::now() - wait_s_time;
+    m_stall_time += wait_duration.count();
+
+    if(m_error){
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+
+    if(m_ready == 0){
+        // Every batch of the epoch has been consumed
+        batch.targets_idx.clear();
+        return;
+    }
+
+    // The buffers of the caller go back to the ring and are
+    // refilled by the producer, nothing is copied or allocated
+    std::swap(batch, m_ring[m_head]);
+    m_head = (m_head + 1) % m_ring.size();
+    m_ready--;
+    lock.unlock();
+    m_free_cv.notify_one();
+}
+
+template<typename T>
+void BasicPrefetchDataLoader<T>::new_epoch(){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    drain(lock);
+    m_dataloader.new_epoch();
+    if(m_batch_size != 0) restart(m_batch_size);
+}
+
+template<typename T>
+void BasicPrefetchDataLoader<T>::load(){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    drain(lock);
+    m_dataloader.load();
+    if(m_batch_size != 0) restart(m_batch_size);
+}
+
+template<typename T>
+void BasicPrefetchDataLoader<T>::shuffle(){
+    // The prefetched batches follow the previous order,
+    // shuffling starts the epoch over
+    std::unique_lock<std::mutex> lock(m_mutex);
+    drain(lock);
+    m_dataloader.shuffle();
+    m_dataloader.new_epoch();
+    if(m_batch_size != 0) restart(m_batch_size);
+}
+
+template<typename T>
+int BasicPrefetchDataLoader<T>::num_classes(){
+    return m_dataloader.num_classes();
+}
+
+template<typename T>
+int BasicPrefetchDataLoader<T>::steps_per_epoch(int batch_size){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dataloader.steps_per_epoch(batch_size);
+}
+
+template<typename T>
+double BasicPrefetchDataLoader<T>::stall_time(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stall_time;
+}
+
+template class BasicPrefetchDataLoader<float>;
+template class BasicPrefetchDataLoader<double>;
@@ -0,0 +1,123 @@
+#include "data_loaders.hpp"
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <random>
+
+template<typename T>
+BasicSyntheticDataLoader<T>::BasicSyntheticDataLoader(
+    int num_samples,
+    int num_features,
+    int num_classes,
+    unsigned int seed,
+    bool shuffle,
+    bool drop_last
+){
+    if(num_samples < 1 || num_features < 1 || num_classes < 1){
+        throw std::runtime_error("Synthetic dataset needs at least one sample, feature and class, got " +
+            std::to_string(num_samples) + " samples, " + std::to_string(num_features) + " features and " +
+            std::to_string(num_classes) + " classes");
+    }
+
+    this->m_num_samples = num_samples;
+    this->m_num_features = num_features;
+    this->m_num_classes = num_classes;
+    this->m_seed = seed;
+    this->m_shuffle = shuffle;
+    this->m_drop_last = drop_last;
+
+    this->m_offset = 0;
+
+    this->rng = std::default_random_engine(seed);
+}
+
+template<typename T>
+int BasicSyntheticDataLoader<T>::num_classes(){
+    return m_num_classes;
+}
+
+template<typename T>
+int BasicSyntheticDataLoader<T>::steps_per_epoch(int batch_size){
+    if(batch_size <= 0){
+        throw std::runtime_error("Batch size must be greater than 0, got " + std::to_string(batch_size));
+    }
+
+    if(m_drop_last)
+        return m_num_samples / batch_size;
+    else
+        return (m_num_samples + batch_size - 1) / batch_size;
+}
+
+template<typename T>
+void BasicSyntheticDataLoader<T>::fill_batch(int batch_size, BasicBatchData<T>& batch){
+    // Bounded by the indices rather than the number of samples, so
+    // that a loader not loaded yet fills an empty batch
+    if(static_cast<size_t>(m_offset + batch_size) > m_indices.size() && m_drop_last){
+        new_epoch();
+        batch.targets_idx.clear();
+        return;
+    }
+
+    int end = std::min(m_offset + batch_size, static_cast<int>(m_indices.size()));
+    int count = std::max(end - m_offset, 0);
+
+    batch.resize(count, m_num_features, m_num_classes);
+
+    T* _input_data = batch.input_data.data();
+    T* _targets_one_hot = batch.targets_one_hot.data();
+
+    const BasicKernelTable<T>& kernels = get_kernels<T>();
+    for(int i = 0; i < count; i++){
+        int item_idx = m_indices[m_offset + i];
+
+        kernels.scale_u8(m_num_features, m_features.data() + static_cast<size_t>(item_idx) * m_num_features,
+            static_cast<T>(1 / 255.0), _input_data + static_cast<size_t>(i) * m_num_features);
+
+        batch.targets_idx[i] = m_labels[item_idx];
+        _targets_one_hot[i * m_num_classes + m_labels[item_idx]] = 1;
+    }
+
+    m_offset += batch_size;
+}
+
+template<typename T>
+void BasicSyntheticDataLoader<T>::new_epoch(){
+    m_offset = 0;
+    if(m_shuffle)
+        shuffle();
+}
+
+template<typename T>
+void BasicSyntheticDataLoader<T>::load(){
+
+    // The samples only depend on the seed, the
+    // shuffling uses its own generator
+    std::mt19937 generator(m_seed);
+    std::uniform_int_distribution<int> feature_dist(0, 255);
+    std::uniform_int_distribution<int> label_dist(0, m_num_classes - 1);
+
+    m_features.resize(static_cast<size_t>(m_num_samples) * m_num_features);
+    for(size_t i = 0; i < m_features.size(); i++){
+        m_features[i] = static_cast<unsigned char>(feature_dist(generator));
+    }
+
+    m_labels.resize(m_num_samples);
+    for(int i = 0; i < m_num_samples; i++){
+        m_labels[i] = label_dist(generator);
+    }
+
+    m_indices.resize(m_num_samples);
+    for(int i = 0; i < m_num_samples; i++){
+        m_indices[i] = i;
+    }
+    m_offset = 0;
+}
+
+template<typename T>
+void BasicSyntheticDataLoader<T>::shuffle(){
+    std::shuffle(m_indices.begin(), m_indices.end(), rng);
+}
+
+template class BasicSyntheticDataLoader<float>;
+template class BasicSyntheticDataLoader<double>;
@@ -0,0 +1,278 @@
+#include "gemm.hpp"
+#include "kernels.hpp"
+
+#include <vector>
+#include <algorithm>
+
+// Cache blocking sizes, a (KC, NR) sliver of op(B) stays in L1,
+// a (MC, KC) block of op(A) stays in L2 and a (KC, NC) panel of
+// op(B) is reused across all the blocks of op(A). MC is a multiple
+// of the register tile height of all the micro-kernels.
+static const int MC = 96;
+static const int KC = 256;
+static const int NC = 2048;
+
+/**
+ * @brief Pack a (mc, kc) block of op(A) in slivers of mr_tile rows,
+ * each sliver is stored column by column so that the micro-kernel
+ * reads it sequentially. Rows past mc are padded with zeros.
+ */
+template<typename T>
+static void pack_a(
+    GemmTranspose trans_a, int mc, int kc,
+    const T* a, int lda, T* packed, int mr_tile
+){
+    for(int ir = 0; ir < mc; ir += mr_tile){
+        int mr = std::min(mr_tile, mc - ir);
+        for(int p = 0; p < kc; p++){
+            for(int r = 0; r < mr; r++){
+                packed[p * mr_tile + r] = (trans_a == NO_TRANS) 
+                    ? a[(ir + r) * lda + p] 
+                    : a[p * lda + ir + r];
+            }
+            for(int r = mr; r < mr_tile; r++){
+                packed[p * mr_tile + r] = 0;
+            }
+        }
+        packed += kc * mr_tile;
+    }
+}
+
+/**
+ * @brief Pack a (kc, nc) panel of op(B) in slivers of nr_tile columns,
+ * each sliver is stored row by row so that the micro-kernel reads
+ * it sequentially. Columns past nc are padded with zeros.
+ */
+template<typename T>
+static void pack_b(
+    GemmTranspose trans_b, int kc, int nc,
+    const T* b, int ldb, T* packed, int nr_tile
+){
+    for(int jr = 0; jr < nc; jr += nr_tile){
+        int nr = std::min(nr_tile, nc - jr);
+        for(int p = 0; p < kc; p++){
+            if(trans_b == NO_TRANS){
+                const T* _b = b + p * ldb + jr;
+                for(int c = 0; c < nr; c++) packed[p * nr_tile + c] = _b[c];
+            } else{
+                for(int c = 0; c < nr; c++) packed[p * nr_tile + c] = b[(jr + c) * ldb + p];
+            }
+            for(int c = nr; c < nr_tile; c++){
+                packed[p * nr_tile + c] = 0;
+            }
+        }
+        packed += kc * nr_tile;
+    }
+}
+
+template<typename T>
+static void gemv_impl(
+    GemmTranspose trans_a,
+    int m, int n,
+    T alpha,
+    const T* a, int lda,
+    const T* x,
+    T beta,
+    T* y
+){
+    if(trans_a == NO_TRANS){
+        // y = alpha * A * x + beta * y, each element of y is the dot
+        // product of a contiguous row of A with x
+        get_kernels<T>().gemv_n(m, n, alpha, a, lda, x, beta, y);
+    } else{
+        // y = alpha * A^T * x + beta * y, accumulated one contiguous
+        // row of A at a time to avoid strided accesses
+        get_kernels<T>().gemv_t(m, n, alpha, a, lda, x, beta, y);
+    }
+}
+
+/**
+ * @brief Apply the bias and the element-wise activation of an
+ * epilogue to a (rows, cols) block of C, bias pointing to the
+ * bias of the first column of the block
+ */
+template<typename T>
+static void apply_epilogue(const BasicGemmEpilogue<T>& epilogue, const T* bias, int rows, int cols, T* c, int ldc){
+    for(int r = 0; r < rows; r++){
+        T* _c = c + r * ldc;
+        if(bias != nullptr) get_kernels<T>().bias_add(1, cols, bias, _c);
+        if(epilogue.activation != nullptr) epilogue.activation(cols, _c, _c);
+    }
+}
+
+/**
+ * @brief Apply the row activation of an epilogue to rows of C
+ */
+template<typename T>
+static void apply_row_epilogue(const BasicGemmEpilogue<T>& epilogue, int rows, int cols, T* c, int ldc){
+    if(epilogue.row_activation == nullptr) return;
+    for(int r = 0; r < rows; r++){
+        epilogue.row_activation(1, cols, c + r * ldc, c + r * ldc);
+    }
+}
+
+/**
+ * @brief Packing buffers, kept per thread and reused across 
+ * calls so that steady state products do not allocate
+ */
+template<typename T>
+static std::vector<T>& packing_buffer(int index){
+    static thread_local std::vector<T> buffers[2];
+    return buffers[index];
+}
+
+template<typename T>
+static void gemm_impl(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    T alpha,
+    const T* a, int lda,
+    const T* b, int ldb,
+    T beta,
+    T* c, int ldc,
+    const BasicGemmEpilogue<T>* epilogue
+){
+    if(m <= 0 || n <= 0) return;
+
+    if(k <= 0 || alpha == 0){
+        for(int i = 0; i < m; i++){
+            T* _c = c + i * ldc;
+            for(int j = 0; j < n; j++) _c[j] = (beta == 0) ? 0 : beta * _c[j];
+        }
+        if(epilogue != nullptr){
+            apply_epilogue(*epilogue, epilogue->bias, m, n, c, ldc);
+            apply_row_epilogue(*epilogue, m, n, c, ldc);
+        }
+        return;
+    }
+
+    // A single row of op(A) does not amortize the packing of op(B),
+    // use a matrix-vector product instead
+    if(m == 1 && trans_a == NO_TRANS){
+        gemv_impl(trans_b == NO_TRANS ? TRANS : NO_TRANS,
+            trans_b == NO_TRANS ? k : n,
+            trans_b == NO_TRANS ? n : k,
+            alpha, b, ldb, a, beta, c);
+        if(epilogue != nullptr){
+            apply_epilogue(*epilogue, epilogue->bias, 1, n, c, ldc);
+            apply_row_epilogue(*epilogue, 1, n, c, ldc);
+        }
+        return;
+    }
+
+    // The micro-kernel and its register tile depend on
+    // the instruction set selected at runtime
+    const BasicKernelTable<T>& kernels = get_kernels<T>();
+    const int mr_tile = kernels.gemm_mr;
+    const int nr_tile = kernels.gemm_nr;
+
+    size_t packed_a_size = static_cast<size_t>(std::min(MC, m) + mr_tile) * KC;
+    size_t packed_b_size = static_cast<size_t>(std::min(NC, n) + nr_tile) * KC;
+    std::vector<T>& packed_a_buff = packing_buffer<T>(0);
+    std::vector<T>& packed_b_buff = packing_buffer<T>(1);
+    if(packed_a_buff.size() < packed_a_size) packed_a_buff.resize(packed_a_size);
+    if(packed_b_buff.size() < packed_b_size) packed_b_buff.resize(packed_b_size);
+    T* packed_a = packed_a_buff.data();
+    T* packed_b = packed_b_buff.data();
+
+    for(int jc = 0; jc < n; jc += NC){
+        int nc = std::min(NC, n - jc);
+
+        for(int pc = 0; pc < k; pc += KC){
+            int kc = std::min(KC, k - pc);
+
+            // C is scaled by beta only once, the following
+            // blocks of k accumulate on the partial result
+            T _beta = (pc == 0) ? beta : 1;
+
+            // The tiles of C are final after the last block of k
+            bool last_k_block = pc + kc == k;
+
+            const T* _b = (trans_b == NO_TRANS) ? b + pc * ldb + jc : b + jc * ldb + pc;
+            pack_b(trans_b, kc, nc, _b, ldb, packed_b, nr_tile);
+
+            for(int ic = 0; ic < m; ic += MC){
+                int mc = std::min(MC, m - ic);
+
+                const T* _a = (trans_a == NO_TRANS) ? a + ic * lda + pc : a + pc * lda + ic;
+                pack_a(trans_a, mc, kc, _a, lda, packed_a, mr_tile);
+
+                for(int jr = 0; jr < nc; jr += nr_tile){
+                    int nr = std::min(nr_tile, nc - jr);
+                    const T* _packed_b = packed_b + (jr / nr_tile) * kc * nr_tile;
+
+                    for(int ir = 0; ir < mc; ir += mr_tile){
+                        int mr = std::min(mr_tile, mc - ir);
+                        const T* _packed_a = packed_a + (ir / mr_tile) * kc * mr_tile;
+
+                        T* _c = c + (ic + ir) * ldc + jc + jr;
+                        kernels.gemm_micro_kernel(kc, alpha, _packed_a, _packed_b, _beta, _c, ldc, mr, nr);
+
+                        if(epilogue != nullptr && last_k_block){
+                            apply_epilogue(*epilogue, epilogue->bias == nullptr ? nullptr : epilogue->bias + jc + jr, mr, nr, _c, ldc);
+                        }
+                    }
+                }
+
+                // Whole rows are complete only after the last panel of columns
+                if(epilogue != nullptr && last_k_block && jc + nc == n){
+                    apply_row_epilogue(*epilogue, mc, n, c + ic * ldc, ldc);
+                }
+            }
+        }
+    }
+}
+
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    double alpha, const double* a, int lda, const double* b, int ldb,
+    double beta, double* c, int ldc
+){
+    gemm_impl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, (const GemmEpilogue*) nullptr);
+}
+
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    double alpha, const double* a, int lda, const double* b, int ldb,
+    double beta, double* c, int ldc,
+    const GemmEpilogue& epilogue
+){
+    gemm_impl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, &epilogue);
+}
+
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    float alpha, const float* a, int lda, const float* b, int ldb,
+    float beta, float* c, int ldc
+){
+    gemm_impl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, (const GemmEpilogueF*) nullptr);
+}
+
+void gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k,
+    float alpha, const float* a, int lda, const float* b, int ldb,
+    float beta, float* c, int ldc,
+    const GemmEpilogueF& epilogue
+){
+    gemm_impl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, &epilogue);
+}
+
+void gemv(GemmTranspose trans_a, int m, int n, double alpha, const double* a, int lda, const double* x, double beta, double* y){
+    gemv_impl(trans_a, m, n, alpha, a, lda, x, beta, y);
+}
+
+void gemv(GemmTranspose trans_a, int m, int n, float alpha, const float* a, int lda, const float* x, float beta, float* y){
+    gemv_impl(trans_a, m, n, alpha, a, lda, x, beta, y);
+}
+
+void axpy(int n, double alpha, const double* x, double* y){
+    get_kernels<double>().axpy(n, alpha, x, y);
+}
+
+void axpy(int n, float alpha, const float* x, float* y){
+    get_kernels<float>().axpy(n, alpha, x, y);
+}
@@ -0,0 +1,97 @@
+#include "kernels.hpp"
+#include "utils.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#ifndef PLAIN_NN_X86_KERNELS
+// The SIMD kernels are only compiled for x86, on other architectures
+// their tables fall back to the scalar kernels
+template<typename T>
+const BasicKernelTable<T>& avx2_kernels(){ return scalar_kernels<T>(); }
+template<typename T>
+const BasicKernelTable<T>& avx512_kernels(){ return scalar_kernels<T>(); }
+
+template const BasicKernelTable<float>& avx2_kernels<float>();
+template const BasicKernelTable<double>& avx2_kernels<double>();
+template const BasicKernelTable<float>& avx512_kernels<float>();
+template const BasicKernelTable<double>& avx512_kernels<double>();
+#endif
+
+const char* const ISA_LEVEL_NAMES[] = {
+    "scalar",
+    "avx2",
+    "avx512"
+};
+
+IsaLevel detect_isa_level(){
+#ifdef PLAIN_NN_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")){
+        return ISA_AVX512;
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        return ISA_AVX2;
+    }
+#endif
+    return ISA_SCALAR;
+}
+
+static IsaLevel select_isa_level(){
+    IsaLevel isa = detect_isa_level();
+
+    const char* forced_isa = std::getenv("PLAIN_NN_ISA");
+    if(forced_isa != nullptr){
+        std::string isa_name = string_to_lower(forced_isa);
+        bool found = false;
+        for(int level = ISA_SCALAR; level <= ISA_AVX512; level++){
+            if(isa_name.compare(ISA_LEVEL_NAMES[level]) == 0){
+                found = true;
+                if(level > isa){
+                    std::fprintf(stderr, "PLAIN_NN_ISA=%s is not supported by this CPU, using %s\n", forced_isa, ISA_LEVEL_NAMES[isa]);
+                } else{
+                    isa = static_cast<IsaLevel>(level);
+                }
+            }
+        }
+        if(!found){
+            std::fprintf(stderr, "Unknown PLAIN_NN_ISA=%s, using %s\n", forced_isa, ISA_LEVEL_NAMES[isa]);
+        }
+    }
+
+    return isa;
+}
+
+/**
+ * @brief The instruction set in use, selected on first
+ * access with a thread safe one time initialization
+ */
+static IsaLevel& active_isa_level(){
+    static IsaLevel isa = select_isa_level();
+    return isa;
+}
+
+template<typename T>
+const BasicKernelTable<T>& get_kernels(){
+    switch(active_isa_level()){
+        case ISA_AVX512: return avx512_kernels<T>();
+        case ISA_AVX2: return avx2_kernels<T>();
+        default: return scalar_kernels<T>();
+    }
+}
+
+template const BasicKernelTable<float>& get_kernels<float>();
+template const BasicKernelTable<double>& get_kernels<double>();
+
+IsaLevel get_isa_level(){
+    return active_isa_level();
+}
+
+void set_isa_level(IsaLevel isa){
+    if(isa > detect_isa_level()){
+        throw std::runtime_error("Instruction set " + std::string(ISA_LEVEL_NAMES[isa]) + " is not supported by this CPU");
+    }
+    active_isa_level() = isa;
+}
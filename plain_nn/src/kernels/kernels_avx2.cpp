@@ -0,0 +1,120 @@
+#include "kernels.hpp"
+
+// AVX2 + FMA kernels, this translation unit is compiled with
+// -mavx2 -mfma and must only be called after checking that the
+// CPU supports them. Keep the includes to a minimum so that no
+// inline function shared with the rest of the library is emitted
+// with AVX2 instructions.
+#include <immintrin.h>
+#include "simd_kernels.hpp"
+
+struct Avx2Double{
+    typedef double scalar;
+    typedef __m256d reg;
+    static const int width = 4;
+    static const int gemm_mr = 6;
+    static const int exp_degree = 11;
+    static constexpr double exp_min = -708.0;
+    static constexpr double exp_max = 708.0;
+
+    static inline reg load(const double* p){ return _mm256_loadu_pd(p); }
+    static inline void store(double* p, reg v){ _mm256_storeu_pd(p, v); }
+    static inline reg load_u8(const unsigned char* p){
+        int bytes;
+        __builtin_memcpy(&bytes, p, sizeof(bytes));
+        return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+    }
+    static inline reg set1(double v){ return _mm256_set1_pd(v); }
+    static inline reg zero(){ return _mm256_setzero_pd(); }
+    static inline reg add(reg a, reg b){ return _mm256_add_pd(a, b); }
+    static inline reg sub(reg a, reg b){ return _mm256_sub_pd(a, b); }
+    static inline reg mul(reg a, reg b){ return _mm256_mul_pd(a, b); }
+    static inline reg div(reg a, reg b){ return _mm256_div_pd(a, b); }
+    static inline reg sqrt(reg x){ return _mm256_sqrt_pd(x); }
+    static inline reg min(reg a, reg b){ return _mm256_min_pd(a, b); }
+    static inline reg max(reg a, reg b){ return _mm256_max_pd(a, b); }
+    static inline reg fmadd(reg a, reg b, reg c){ return _mm256_fmadd_pd(a, b, c); }
+    static inline reg fnmadd(reg a, reg b, reg c){ return _mm256_fnmadd_pd(a, b, c); }
+    static inline reg round(reg x){ return _mm256_round_pd(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static inline reg abs(reg x){ return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x); }
+    static inline reg copysign(reg x, reg s){ return _mm256_or_pd(abs(x), _mm256_and_pd(s, _mm256_set1_pd(-0.0))); }
+    static inline reg step(reg x){ return _mm256_and_pd(_mm256_cmp_pd(x, zero(), _CMP_GT_OQ), set1(1.0)); }
+
+    static inline reg scale2n(reg x, reg n){
+        // Adding 1.5*2^52 leaves the integer n in the low bits of the
+        // mantissa, which is then moved to the exponent bits of 2^n
+        const reg magic = _mm256_set1_pd(6755399441055744.0);
+        __m256i e = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n, magic)), _mm256_castpd_si256(magic));
+        e = _mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)), 52);
+        return _mm256_mul_pd(x, _mm256_castsi256_pd(e));
+    }
+
+    static inline double hsum(reg v){
+        __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+    static inline double hmax(reg v){
+        __m128d lo = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+};
+
+struct Avx2Float{
+    typedef float scalar;
+    typedef __m256 reg;
+    static const int width = 8;
+    static const int gemm_mr = 6;
+    static const int exp_degree = 7;
+    static constexpr float exp_min = -87.0f;
+    static constexpr float exp_max = 87.0f;
+
+    static inline reg load(const float* p){ return _mm256_loadu_ps(p); }
+    static inline void store(float* p, reg v){ _mm256_storeu_ps(p, v); }
+    static inline reg load_u8(const unsigned char* p){
+        return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+    }
+    static inline reg set1(float v){ return _mm256_set1_ps(v); }
+    static inline reg zero(){ return _mm256_setzero_ps(); }
+    static inline reg add(reg a, reg b){ return _mm256_add_ps(a, b); }
+    static inline reg sub(reg a, reg b){ return _mm256_sub_ps(a, b); }
+    static inline reg mul(reg a, reg b){ return _mm256_mul_ps(a, b); }
+    static inline reg div(reg a, reg b){ return _mm256_div_ps(a, b); }
+    static inline reg sqrt(reg x){ return _mm256_sqrt_ps(x); }
+    static inline reg min(reg a, reg b){ return _mm256_min_ps(a, b); }
+    static inline reg max(reg a, reg b){ return _mm256_max_ps(a, b); }
+    static inline reg fmadd(reg a, reg b, reg c){ return _mm256_fmadd_ps(a, b, c); }
+    static inline reg fnmadd(reg a, reg b, reg c){ return _mm256_fnmadd_ps(a, b, c); }
+    static inline reg round(reg x){ return _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static inline reg abs(reg x){ return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+    static inline reg copysign(reg x, reg s){ return _mm256_or_ps(abs(x), _mm256_and_ps(s, _mm256_set1_ps(-0.0f))); }
+    static inline reg step(reg x){ return _mm256_and_ps(_mm256_cmp_ps(x, zero(), _CMP_GT_OQ), set1(1.0f)); }
+
+    static inline reg scale2n(reg x, reg n){
+        __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(x, _mm256_castsi256_ps(e));
+    }
+
+    static inline float hsum(reg v){
+        __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+        return _mm_cvtss_f32(_mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1)));
+    }
+    static inline float hmax(reg v){
+        __m128 lo = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        lo = _mm_max_ps(lo, _mm_movehl_ps(lo, lo));
+        return _mm_cvtss_f32(_mm_max_ss(lo, _mm_shuffle_ps(lo, lo, 1)));
+    }
+};
+
+template<typename T> struct Avx2Traits{};
+template<> struct Avx2Traits<double>{ typedef Avx2Double type; };
+template<> struct Avx2Traits<float>{ typedef Avx2Float type; };
+
+template<typename T>
+const BasicKernelTable<T>& avx2_kernels(){
+    static const BasicKernelTable<T> table = make_simd_kernel_table<typename Avx2Traits<T>::type>(ISA_AVX2);
+    return table;
+}
+
+template const BasicKernelTable<float>& avx2_kernels<float>();
+template const BasicKernelTable<double>& avx2_kernels<double>();
@@ -0,0 +1,121 @@
+#include "kernels.hpp"
+
+// AVX-512F kernels, this translation unit is compiled with
+// -mavx512f -mfma and must only be called after checking that
+// the CPU supports them. Keep the includes to a minimum so that
+// no inline function shared with the rest of the library is
+// emitted with AVX-512 instructions.
+
+// GCC reports the undefined source operand of the masked intrinsics
+// as possibly uninitialized, the masked lanes are never used. The
+// warning points into the intrinsics header, so it is only silenced
+// there and still reported for the kernels below
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#include "simd_kernels.hpp"
+
+// Only AVX-512F is required, the bitwise operations on floating
+// point registers go through the integer domain since the _pd/_ps
+// variants need AVX-512DQ
+
+struct Avx512Double{
+    typedef double scalar;
+    typedef __m512d reg;
+    static const int width = 8;
+    static const int gemm_mr = 8;
+    static const int exp_degree = 11;
+    static constexpr double exp_min = -708.0;
+    static constexpr double exp_max = 708.0;
+
+    static inline reg load(const double* p){ return _mm512_loadu_pd(p); }
+    static inline void store(double* p, reg v){ _mm512_storeu_pd(p, v); }
+    static inline reg load_u8(const unsigned char* p){
+        __m512i x = _mm512_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+        return _mm512_cvtepi32_pd(_mm512_castsi512_si256(x));
+    }
+    static inline reg set1(double v){ return _mm512_set1_pd(v); }
+    static inline reg zero(){ return _mm512_setzero_pd(); }
+    static inline reg add(reg a, reg b){ return _mm512_add_pd(a, b); }
+    static inline reg sub(reg a, reg b){ return _mm512_sub_pd(a, b); }
+    static inline reg mul(reg a, reg b){ return _mm512_mul_pd(a, b); }
+    static inline reg div(reg a, reg b){ return _mm512_div_pd(a, b); }
+    static inline reg sqrt(reg x){ return _mm512_sqrt_pd(x); }
+    static inline reg min(reg a, reg b){ return _mm512_min_pd(a, b); }
+    static inline reg max(reg a, reg b){ return _mm512_max_pd(a, b); }
+    static inline reg fmadd(reg a, reg b, reg c){ return _mm512_fmadd_pd(a, b, c); }
+    static inline reg fnmadd(reg a, reg b, reg c){ return _mm512_fnmadd_pd(a, b, c); }
+    static inline reg round(reg x){ return _mm512_roundscale_pd(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static inline reg scale2n(reg x, reg n){ return _mm512_scalef_pd(x, n); }
+
+    static inline reg abs(reg x){
+        return _mm512_castsi512_pd(_mm512_andnot_si512(_mm512_set1_epi64(0x8000000000000000LL), _mm512_castpd_si512(x)));
+    }
+    static inline reg copysign(reg x, reg s){
+        __m512i sign = _mm512_and_si512(_mm512_castpd_si512(s), _mm512_set1_epi64(0x8000000000000000LL));
+        return _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(abs(x)), sign));
+    }
+    static inline reg step(reg x){
+        return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(x, zero(), _CMP_GT_OQ), set1(1.0));
+    }
+
+    static inline double hsum(reg v){ return _mm512_reduce_add_pd(v); }
+    static inline double hmax(reg v){ return _mm512_reduce_max_pd(v); }
+};
+
+struct Avx512Float{
+    typedef float scalar;
+    typedef __m512 reg;
+    static const int width = 16;
+    static const int gemm_mr = 8;
+    static const int exp_degree = 7;
+    static constexpr float exp_min = -87.0f;
+    static constexpr float exp_max = 87.0f;
+
+    static inline reg load(const float* p){ return _mm512_loadu_ps(p); }
+    static inline void store(float* p, reg v){ _mm512_storeu_ps(p, v); }
+    static inline reg load_u8(const unsigned char* p){
+        return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+    }
+    static inline reg set1(float v){ return _mm512_set1_ps(v); }
+    static inline reg zero(){ return _mm512_setzero_ps(); }
+    static inline reg add(reg a, reg b){ return _mm512_add_ps(a, b); }
+    static inline reg sub(reg a, reg b){ return _mm512_sub_ps(a, b); }
+    static inline reg mul(reg a, reg b){ return _mm512_mul_ps(a, b); }
+    static inline reg div(reg a, reg b){ return _mm512_div_ps(a, b); }
+    static inline reg sqrt(reg x){ return _mm512_sqrt_ps(x); }
+    static inline reg min(reg a, reg b){ return _mm512_min_ps(a, b); }
+    static inline reg max(reg a, reg b){ return _mm512_max_ps(a, b); }
+    static inline reg fmadd(reg a, reg b, reg c){ return _mm512_fmadd_ps(a, b, c); }
+    static inline reg fnmadd(reg a, reg b, reg c){ return _mm512_fnmadd_ps(a, b, c); }
+    static inline reg round(reg x){ return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static inline reg scale2n(reg x, reg n){ return _mm512_scalef_ps(x, n); }
+
+    static inline reg abs(reg x){
+        return _mm512_castsi512_ps(_mm512_andnot_si512(_mm512_set1_epi32((int) 0x80000000), _mm512_castps_si512(x)));
+    }
+    static inline reg copysign(reg x, reg s){
+        __m512i sign = _mm512_and_si512(_mm512_castps_si512(s), _mm512_set1_epi32((int) 0x80000000));
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(abs(x)), sign));
+    }
+    static inline reg step(reg x){
+        return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, zero(), _CMP_GT_OQ), set1(1.0f));
+    }
+
+    static inline float hsum(reg v){ return _mm512_reduce_add_ps(v); }
+    static inline float hmax(reg v){ return _mm512_reduce_max_ps(v); }
+};
+
+template<typename T> struct Avx512Traits{};
+template<> struct Avx512Traits<double>{ typedef Avx512Double type; };
+template<> struct Avx512Traits<float>{ typedef Avx512Float type; };
+
+template<typename T>
+const BasicKernelTable<T>& avx512_kernels(){
+    static const BasicKernelTable<T> table = make_simd_kernel_table<typename Avx512Traits<T>::type>(ISA_AVX512);
+    return table;
+}
+
+template const BasicKernelTable<float>& avx512_kernels<float>();
+template const BasicKernelTable<double>& avx512_kernels<double>();
@@ -0,0 +1,290 @@
+#include "kernels.hpp"
+
+#include <cmath>
+
+// Portable kernels, used when no SIMD instruction set is
+// available and as the reference for the SIMD kernels
+
+static const int MR = 4;
+static const int NR = 8;
+
+template<typename T>
+static void gemm_micro_kernel(
+    int kc, T alpha,
+    const T* a, const T* b,
+    T beta, T* c, int ldc,
+    int mr, int nr
+){
+    T acc[MR][NR] = {{0}};
+
+    for(int p = 0; p < kc; p++){
+        const T* _a = a + p * MR;
+        const T* _b = b + p * NR;
+        for(int r = 0; r < MR; r++){
+            T a_r = _a[r];
+            for(int col = 0; col < NR; col++){
+                acc[r][col] += a_r * _b[col];
+            }
+        }
+    }
+
+    for(int r = 0; r < mr; r++){
+        T* _c = c + r * ldc;
+        if(beta == 0){
+            for(int col = 0; col < nr; col++) _c[col] = alpha * acc[r][col];
+        } else{
+            for(int col = 0; col < nr; col++) _c[col] = beta * _c[col] + alpha * acc[r][col];
+        }
+    }
+}
+
+template<typename T>
+static void gemv_n(int m, int n, T alpha, const T* a, int lda, const T* x, T beta, T* y){
+    for(int i = 0; i < m; i++){
+        const T* _a = a + i * lda;
+        T acc = 0;
+        for(int j = 0; j < n; j++){
+            acc += _a[j] * x[j];
+        }
+        y[i] = (beta == 0) ? alpha * acc : beta * y[i] + alpha * acc;
+    }
+}
+
+template<typename T>
+static void gemv_t(int m, int n, T alpha, const T* a, int lda, const T* x, T beta, T* y){
+    for(int j = 0; j < n; j++){
+        y[j] = (beta == 0) ? 0 : beta * y[j];
+    }
+    for(int i = 0; i < m; i++){
+        const T* _a = a + i * lda;
+        T _x = alpha * x[i];
+        for(int j = 0; j < n; j++){
+            y[j] += _x * _a[j];
+        }
+    }
+}
+
+template<typename T>
+static void axpy(int n, T alpha, const T* x, T* y){
+    for(int i = 0; i < n; i++){
+        y[i] += alpha * x[i];
+    }
+}
+
+template<typename T>
+static void bias_add(int rows, int cols, const T* bias, T* out){
+    for(int r = 0; r < rows; r++){
+        T* _out = out + r * cols;
+        for(int j = 0; j < cols; j++){
+            _out[j] += bias[j];
+        }
+    }
+}
+
+template<typename T>
+static void scale_u8(int n, const unsigned char* x, T scale, T* out){
+    for(int i = 0; i < n; i++) out[i] = scale * x[i];
+}
+
+template<typename T>
+static void relu_forward(int n, const T* x, T* out){
+    for(int i = 0; i < n; i++) out[i] = x[i] > 0 ? x[i] : 0;
+}
+
+template<typename T>
+static void relu_derivative(int n, const T* y, T* out){
+    for(int i = 0; i < n; i++) out[i] = y[i] > 0 ? 1 : 0;
+}
+
+template<typename T>
+static void relu_backward(int n, const T* y, const T* dy, T* out){
+    for(int i = 0; i < n; i++) out[i] = y[i] > 0 ? dy[i] : 0;
+}
+
+template<typename T>
+static void sigmoid_forward(int n, const T* x, T* out){
+    for(int i = 0; i < n; i++) out[i] = 1 / (1 + std::exp(-x[i]));
+}
+
+template<typename T>
+static void sigmoid_derivative(int n, const T* y, T* out){
+    for(int i = 0; i < n; i++) out[i] = y[i] * (1 - y[i]);
+}
+
+template<typename T>
+static void sigmoid_backward(int n, const T* y, const T* dy, T* out){
+    for(int i = 0; i < n; i++) out[i] = dy[i] * y[i] * (1 - y[i]);
+}
+
+template<typename T>
+static void tanh_forward(int n, const T* x, T* out){
+    for(int i = 0; i < n; i++) out[i] = std::tanh(x[i]);
+}
+
+template<typename T>
+static void tanh_derivative(int n, const T* y, T* out){
+    for(int i = 0; i < n; i++) out[i] = 1 - y[i] * y[i];
+}
+
+template<typename T>
+static void tanh_backward(int n, const T* y, const T* dy, T* out){
+    for(int i = 0; i < n; i++) out[i] = dy[i] * (1 - y[i] * y[i]);
+}
+
+template<typename T>
+static void softmax(int rows, int cols, const T* x, T* out){
+    for(int r = 0; r < rows; r++){
+        const T* _x = x + r * cols;
+        T* _out = out + r * cols;
+
+        T max = _x[0];
+        for(int j = 1; j < cols; j++) max = _x[j] > max ? _x[j] : max;
+
+        T sum = 0;
+        for(int j = 0; j < cols; j++){
+            _out[j] = std::exp(_x[j] - max);
+            sum += _out[j];
+        }
+        for(int j = 0; j < cols; j++) _out[j] /= sum;
+    }
+}
+
+template<typename T>
+static void softmax_backward(int rows, int cols, const T* y, const T* dy, T* out){
+    for(int r = 0; r < rows; r++){
+        const T* _y = y + r * cols;
+        const T* _dy = dy + r * cols;
+        T* _out = out + r * cols;
+
+        T dot = 0;
+        for(int j = 0; j < cols; j++) dot += _dy[j] * _y[j];
+        for(int j = 0; j < cols; j++) _out[j] = _y[j] * (_dy[j] - dot);
+    }
+}
+
+template<typename T>
+static void sgd_update(int n, const BasicUpdateParams<T>& p, T* w, T* g){
+    T alpha = p.lr * p.scale;
+    for(int i = 0; i < n; i++){
+        w[i] += alpha * g[i];
+        g[i] = 0;
+    }
+}
+
+template<typename T>
+static void momentum_update(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v){
+    for(int i = 0; i < n; i++){
+        v[i] = p.beta1 * v[i] + p.scale * g[i];
+        w[i] += p.lr * v[i];
+        g[i] = 0;
+    }
+}
+
+template<typename T>
+static void nesterov_update(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v){
+    for(int i = 0; i < n; i++){
+        T d = p.scale * g[i];
+        v[i] = p.beta1 * v[i] + d;
+        w[i] += p.lr * (d + p.beta1 * v[i]);
+        g[i] = 0;
+    }
+}
+
+template<typename T>
+static void adam_update(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* m, T* v){
+    T step_size = p.lr / p.bias_correction1;
+    T inv_sqrt_c2 = 1 / std::sqrt(p.bias_correction2);
+    T decay = 1 - p.lr * p.weight_decay;
+    for(int i = 0; i < n; i++){
+        T d = p.scale * g[i];
+        m[i] = p.beta1 * m[i] + (1 - p.beta1) * d;
+        v[i] = p.beta2 * v[i] + (1 - p.beta2) * d * d;
+        w[i] = decay * w[i] + step_size * m[i] / (std::sqrt(v[i]) * inv_sqrt_c2 + p.eps);
+        g[i] = 0;
+    }
+}
+
+template<typename T>
+static inline T relaxed_load(const T* ptr){
+    T value;
+    __atomic_load(ptr, &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+template<typename T>
+static inline void relaxed_store(T* ptr, T value){
+    __atomic_store(ptr, &value, __ATOMIC_RELAXED);
+}
+
+template<typename T>
+void sgd_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g){
+    T alpha = p.lr * p.scale;
+    for(int i = 0; i < n; i++){
+        relaxed_store(w + i, relaxed_load(w + i) + alpha * g[i]);
+        g[i] = 0;
+    }
+}
+
+template<typename T>
+void momentum_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v){
+    for(int i = 0; i < n; i++){
+        T velocity = p.beta1 * relaxed_load(v + i) + p.scale * g[i];
+        relaxed_store(v + i, velocity);
+        relaxed_store(w + i, relaxed_load(w + i) + p.lr * velocity);
+        g[i] = 0;
+    }
+}
+
+template<typename T>
+void nesterov_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* v){
+    for(int i = 0; i < n; i++){
+        T d = p.scale * g[i];
+        T velocity = p.beta1 * relaxed_load(v + i) + d;
+        relaxed_store(v + i, velocity);
+        relaxed_store(w + i, relaxed_load(w + i) + p.lr * (d + p.beta1 * velocity));
+        g[i] = 0;
+    }
+}
+
+template<typename T>
+void adam_update_relaxed(int n, const BasicUpdateParams<T>& p, T* w, T* g, T* m, T* v){
+    T step_size = p.lr / p.bias_correction1;
+    T inv_sqrt_c2 = 1 / std::sqrt(p.bias_correction2);
+    T decay = 1 - p.lr * p.weight_decay;
+    for(int i = 0; i < n; i++){
+        T d = p.scale * g[i];
+        T first_moment = p.beta1 * relaxed_load(m + i) + (1 - p.beta1) * d;
+        T second_moment = p.beta2 * relaxed_load(v + i) + (1 - p.beta2) * d * d;
+        relaxed_store(m + i, first_moment);
+        relaxed_store(v + i, second_moment);
+        relaxed_store(w + i, decay * relaxed_load(w + i) + step_size * first_moment / (std::sqrt(second_moment) * inv_sqrt_c2 + p.eps));
+        g[i] = 0;
+    }
+}
+
+template void sgd_update_relaxed<float>(int n, const BasicUpdateParams<float>& p, float* w, float* g);
+template void sgd_update_relaxed<double>(int n, const BasicUpdateParams<double>& p, double* w, double* g);
+template void momentum_update_relaxed<float>(int n, const BasicUpdateParams<float>& p, float* w, float* g, float* v);
+template void momentum_update_relaxed<double>(int n, const BasicUpdateParams<double>& p, double* w, double* g, double* v);
+template void nesterov_update_relaxed<float>(int n, const BasicUpdateParams<float>& p, float* w, float* g, float* v);
+template void nesterov_update_relaxed<double>(int n, const BasicUpdateParams<double>& p, double* w, double* g, double* v);
+template void adam_update_relaxed<float>(int n, const BasicUpdateParams<float>& p, float* w, float* g, float* m, float* v);
+template void adam_update_relaxed<double>(int n, const BasicUpdateParams<double>& p, double* w, double* g, double* m, double* v);
+
+template<typename T>
+const BasicKernelTable<T>& scalar_kernels(){
+    static const BasicKernelTable<T> table = {
+        ISA_SCALAR, MR, NR,
+        gemm_micro_kernel<T>,
+        gemv_n<T>, gemv_t<T>, axpy<T>, bias_add<T>, scale_u8<T>,
+        relu_forward<T>, relu_derivative<T>, relu_backward<T>,
+        sigmoid_forward<T>, sigmoid_derivative<T>, sigmoid_backward<T>,
+        tanh_forward<T>, tanh_derivative<T>, tanh_backward<T>,
+        softmax<T>, softmax_backward<T>,
+        sgd_update<T>, momentum_update<T>, nesterov_update<T>, adam_update<T>
+    };
+    return table;
+}
+
+template const BasicKernelTable<float>& scalar_kernels<float>();
+template const BasicKernelTable<double>& scalar_kernels<double>();
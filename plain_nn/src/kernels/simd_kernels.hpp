@@ -0,0 +1,560 @@
+#ifndef PLAIN_NN_KERNELS_SIMD_KERNELS_H
+#define PLAIN_NN_KERNELS_SIMD_KERNELS_H
+
+#include "kernels.hpp"
+
+/**
+ * Kernels written once for any SIMD instruction set and element type.
+ * This header is only included by the translation units compiled with
+ * the instruction set flags, each of them defines a traits type V with:
+ * 
+ * - scalar, reg: the element type and the vector register type
+ * - width: the number of elements in a register
+ * - gemm_mr: the number of rows of the gemm register tile, the tile
+ *   is always two registers wide
+ * - exp_min, exp_max, exp_degree: the range where exp is evaluated
+ *   and the degree of the polynomial used to approximate it
+ * - load, store, set1, zero, add, sub, mul, div, sqrt, min, max: as the intrinsics
+ * - fmadd(a, b, c) = a * b + c, fnmadd(a, b, c) = c - a * b
+ * - round(x): round to the nearest integer
+ * - scale2n(x, n): x * 2^n with n integer valued
+ * - abs(x), copysign(x, s): |x| and |x| with the sign of s
+ * - step(x): x > 0 ? 1 : 0
+ * - hsum(x), hmax(x): horizontal sum and max of the lanes
+ * 
+ * All the functions have internal linkage so that each translation unit
+ * gets its own copy compiled for its instruction set. For the same reason
+ * the scalar tails use the compiler builtins instead of <cmath>, whose 
+ * inline overloads could otherwise be shared with the rest of the library.
+ */
+
+static inline double scalar_exp(double x){ return __builtin_exp(x); }
+static inline float scalar_exp(float x){ return __builtin_expf(x); }
+static inline double scalar_tanh(double x){ return __builtin_tanh(x); }
+static inline float scalar_tanh(float x){ return __builtin_tanhf(x); }
+static inline double scalar_sqrt(double x){ return __builtin_sqrt(x); }
+static inline float scalar_sqrt(float x){ return __builtin_sqrtf(x); }
+
+/**
+ * @brief Vectorized exp, the argument is reduced as x = n*ln2 + r
+ * with |r| <= ln2/2, exp(r) is approximated with a Taylor polynomial
+ * and the result is scaled by 2^n.
+ */
+template<class V>
+static inline typename V::reg simd_exp(typename V::reg x){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+
+    static const double inv_factorial[] = {
+        1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+        1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800
+    };
+
+    x = V::min(V::max(x, V::set1(V::exp_min)), V::set1(V::exp_max));
+
+    R n = V::round(V::mul(x, V::set1((T) 1.4426950408889634)));
+    R r = V::fnmadd(n, V::set1((T) 6.93145751953125E-1), x);
+    r = V::fnmadd(n, V::set1((T) 1.42860682030941723212E-6), r);
+
+    R p = V::set1((T) inv_factorial[V::exp_degree]);
+    for(int i = V::exp_degree - 1; i >= 0; i--){
+        p = V::fmadd(p, r, V::set1((T) inv_factorial[i]));
+    }
+
+    return V::scale2n(p, n);
+}
+
+template<class V>
+static void simd_gemm_micro_kernel(
+    int kc, typename V::scalar alpha,
+    const typename V::scalar* a, const typename V::scalar* b,
+    typename V::scalar beta, typename V::scalar* c, int ldc,
+    int mr, int nr
+){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int MR = V::gemm_mr;
+    const int W = V::width;
+
+    // The accumulators are fully unrolled so that they live in registers
+    R acc0[MR], acc1[MR];
+    for(int r = 0; r < MR; r++){
+        acc0[r] = V::zero();
+        acc1[r] = V::zero();
+    }
+
+    for(int p = 0; p < kc; p++){
+        R b0 = V::load(b);
+        R b1 = V::load(b + W);
+        for(int r = 0; r < MR; r++){
+            R a_r = V::set1(a[r]);
+            acc0[r] = V::fmadd(a_r, b0, acc0[r]);
+            acc1[r] = V::fmadd(a_r, b1, acc1[r]);
+        }
+        a += MR;
+        b += 2 * W;
+    }
+
+    R _alpha = V::set1(alpha);
+    R _beta = V::set1(beta);
+
+    if(mr == MR && nr == 2 * W){
+        for(int r = 0; r < MR; r++){
+            T* _c = c + r * ldc;
+            R v0 = V::mul(_alpha, acc0[r]);
+            R v1 = V::mul(_alpha, acc1[r]);
+            if(beta != 0){
+                v0 = V::fmadd(_beta, V::load(_c), v0);
+                v1 = V::fmadd(_beta, V::load(_c + W), v1);
+            }
+            V::store(_c, v0);
+            V::store(_c + W, v1);
+        }
+        return;
+    }
+
+    // Edge tile, only part of the accumulators is written back
+    T tile[MR * 2 * W];
+    for(int r = 0; r < MR; r++){
+        V::store(tile + r * 2 * W, acc0[r]);
+        V::store(tile + r * 2 * W + W, acc1[r]);
+    }
+    for(int r = 0; r < mr; r++){
+        T* _c = c + r * ldc;
+        for(int col = 0; col < nr; col++){
+            _c[col] = (beta == 0) ? alpha * tile[r * 2 * W + col] : beta * _c[col] + alpha * tile[r * 2 * W + col];
+        }
+    }
+}
+
+template<class V>
+static void simd_gemv_n(int m, int n, typename V::scalar alpha, const typename V::scalar* a, int lda, const typename V::scalar* x, typename V::scalar beta, typename V::scalar* y){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    int i = 0;
+    // Four rows at a time so that each load of x is reused
+    for(; i + 4 <= m; i += 4){
+        const T* a0 = a + i * lda;
+        const T* a1 = a0 + lda;
+        const T* a2 = a1 + lda;
+        const T* a3 = a2 + lda;
+        R acc0 = V::zero(), acc1 = V::zero(), acc2 = V::zero(), acc3 = V::zero();
+        int j = 0;
+        for(; j + W <= n; j += W){
+            R _x = V::load(x + j);
+            acc0 = V::fmadd(V::load(a0 + j), _x, acc0);
+            acc1 = V::fmadd(V::load(a1 + j), _x, acc1);
+            acc2 = V::fmadd(V::load(a2 + j), _x, acc2);
+            acc3 = V::fmadd(V::load(a3 + j), _x, acc3);
+        }
+        T s[4] = {V::hsum(acc0), V::hsum(acc1), V::hsum(acc2), V::hsum(acc3)};
+        for(; j < n; j++){
+            s[0] += a0[j] * x[j]; s[1] += a1[j] * x[j];
+            s[2] += a2[j] * x[j]; s[3] += a3[j] * x[j];
+        }
+        for(int r = 0; r < 4; r++){
+            y[i + r] = (beta == 0) ? alpha * s[r] : beta * y[i + r] + alpha * s[r];
+        }
+    }
+    for(; i < m; i++){
+        const T* _a = a + i * lda;
+        R acc = V::zero();
+        int j = 0;
+        for(; j + W <= n; j += W){
+            acc = V::fmadd(V::load(_a + j), V::load(x + j), acc);
+        }
+        T s = V::hsum(acc);
+        for(; j < n; j++) s += _a[j] * x[j];
+        y[i] = (beta == 0) ? alpha * s : beta * y[i] + alpha * s;
+    }
+}
+
+template<class V>
+static void simd_gemv_t(int m, int n, typename V::scalar alpha, const typename V::scalar* a, int lda, const typename V::scalar* x, typename V::scalar beta, typename V::scalar* y){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    for(int j = 0; j < n; j++){
+        y[j] = (beta == 0) ? 0 : beta * y[j];
+    }
+
+    int i = 0;
+    // Four rows at a time so that each load and store of y is reused
+    for(; i + 4 <= m; i += 4){
+        const T* a0 = a + i * lda;
+        const T* a1 = a0 + lda;
+        const T* a2 = a1 + lda;
+        const T* a3 = a2 + lda;
+        T x0 = alpha * x[i], x1 = alpha * x[i + 1], x2 = alpha * x[i + 2], x3 = alpha * x[i + 3];
+        R _x0 = V::set1(x0), _x1 = V::set1(x1), _x2 = V::set1(x2), _x3 = V::set1(x3);
+        int j = 0;
+        for(; j + W <= n; j += W){
+            R _y = V::load(y + j);
+            _y = V::fmadd(_x0, V::load(a0 + j), _y);
+            _y = V::fmadd(_x1, V::load(a1 + j), _y);
+            _y = V::fmadd(_x2, V::load(a2 + j), _y);
+            _y = V::fmadd(_x3, V::load(a3 + j), _y);
+            V::store(y + j, _y);
+        }
+        for(; j < n; j++){
+            y[j] += x0 * a0[j] + x1 * a1[j] + x2 * a2[j] + x3 * a3[j];
+        }
+    }
+    for(; i < m; i++){
+        const T* _a = a + i * lda;
+        T _x = alpha * x[i];
+        R _xv = V::set1(_x);
+        int j = 0;
+        for(; j + W <= n; j += W){
+            V::store(y + j, V::fmadd(_xv, V::load(_a + j), V::load(y + j)));
+        }
+        for(; j < n; j++) y[j] += _x * _a[j];
+    }
+}
+
+template<class V>
+static void simd_axpy(int n, typename V::scalar alpha, const typename V::scalar* x, typename V::scalar* y){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R _alpha = V::set1(alpha);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        V::store(y + i, V::fmadd(_alpha, V::load(x + i), V::load(y + i)));
+    }
+    for(; i < n; i++) y[i] += alpha * x[i];
+}
+
+template<class V>
+static void simd_bias_add(int rows, int cols, const typename V::scalar* bias, typename V::scalar* out){
+    typedef typename V::scalar T;
+    const int W = V::width;
+
+    for(int r = 0; r < rows; r++){
+        T* _out = out + r * cols;
+        int j = 0;
+        for(; j + W <= cols; j += W){
+            V::store(_out + j, V::add(V::load(_out + j), V::load(bias + j)));
+        }
+        for(; j < cols; j++) _out[j] += bias[j];
+    }
+}
+
+template<class V>
+static void simd_scale_u8(int n, const unsigned char* x, typename V::scalar scale, typename V::scalar* out){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R _scale = V::set1(scale);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        V::store(out + i, V::mul(V::load_u8(x + i), _scale));
+    }
+    for(; i < n; i++) out[i] = scale * x[i];
+}
+
+template<class V>
+static void simd_relu(int n, const typename V::scalar* x, typename V::scalar* out){
+    const int W = V::width;
+    int i = 0;
+    for(; i + W <= n; i += W){
+        V::store(out + i, V::max(V::load(x + i), V::zero()));
+    }
+    for(; i < n; i++) out[i] = x[i] > 0 ? x[i] : 0;
+}
+
+template<class V>
+static void simd_relu_derivative(int n, const typename V::scalar* y, typename V::scalar* out){
+    const int W = V::width;
+    int i = 0;
+    for(; i + W <= n; i += W){
+        V::store(out + i, V::step(V::load(y + i)));
+    }
+    for(; i < n; i++) out[i] = y[i] > 0 ? 1 : 0;
+}
+
+template<class V>
+static void simd_relu_backward(int n, const typename V::scalar* y, const typename V::scalar* dy, typename V::scalar* out){
+    const int W = V::width;
+    int i = 0;
+    for(; i + W <= n; i += W){
+        V::store(out + i, V::mul(V::load(dy + i), V::step(V::load(y + i))));
+    }
+    for(; i < n; i++) out[i] = y[i] > 0 ? dy[i] : 0;
+}
+
+template<class V>
+static void simd_sigmoid(int n, const typename V::scalar* x, typename V::scalar* out){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R one = V::set1(1);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R e = simd_exp<V>(V::sub(V::zero(), V::load(x + i)));
+        V::store(out + i, V::div(one, V::add(one, e)));
+    }
+    for(; i < n; i++) out[i] = 1 / (1 + scalar_exp(-x[i]));
+}
+
+template<class V>
+static void simd_sigmoid_derivative(int n, const typename V::scalar* y, typename V::scalar* out){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R one = V::set1(1);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R _y = V::load(y + i);
+        V::store(out + i, V::mul(_y, V::sub(one, _y)));
+    }
+    for(; i < n; i++) out[i] = y[i] * (1 - y[i]);
+}
+
+template<class V>
+static void simd_sigmoid_backward(int n, const typename V::scalar* y, const typename V::scalar* dy, typename V::scalar* out){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R one = V::set1(1);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R _y = V::load(y + i);
+        V::store(out + i, V::mul(V::load(dy + i), V::mul(_y, V::sub(one, _y))));
+    }
+    for(; i < n; i++) out[i] = dy[i] * y[i] * (1 - y[i]);
+}
+
+template<class V>
+static void simd_tanh(int n, const typename V::scalar* x, typename V::scalar* out){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    // tanh(x) = sign(x) * (1 - e) / (1 + e) with e = exp(-2|x|)
+    R one = V::set1(1);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R _x = V::load(x + i);
+        R e = simd_exp<V>(V::mul(V::abs(_x), V::set1(-2)));
+        R t = V::div(V::sub(one, e), V::add(one, e));
+        V::store(out + i, V::copysign(t, _x));
+    }
+    for(; i < n; i++) out[i] = scalar_tanh(x[i]);
+}
+
+template<class V>
+static void simd_tanh_derivative(int n, const typename V::scalar* y, typename V::scalar* out){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R one = V::set1(1);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R _y = V::load(y + i);
+        V::store(out + i, V::fnmadd(_y, _y, one));
+    }
+    for(; i < n; i++) out[i] = 1 - y[i] * y[i];
+}
+
+template<class V>
+static void simd_tanh_backward(int n, const typename V::scalar* y, const typename V::scalar* dy, typename V::scalar* out){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R one = V::set1(1);
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R _y = V::load(y + i);
+        V::store(out + i, V::mul(V::load(dy + i), V::fnmadd(_y, _y, one)));
+    }
+    for(; i < n; i++) out[i] = dy[i] * (1 - y[i] * y[i]);
+}
+
+template<class V>
+static void simd_softmax(int rows, int cols, const typename V::scalar* x, typename V::scalar* out){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    for(int r = 0; r < rows; r++){
+        const T* _x = x + r * cols;
+        T* _out = out + r * cols;
+
+        int j = 0;
+        T max = _x[0];
+        if(cols >= W){
+            R _max = V::load(_x);
+            for(j = W; j + W <= cols; j += W) _max = V::max(_max, V::load(_x + j));
+            max = V::hmax(_max);
+        }
+        for(; j < cols; j++) max = _x[j] > max ? _x[j] : max;
+
+        R _max = V::set1(max);
+        R _sum = V::zero();
+        for(j = 0; j + W <= cols; j += W){
+            R e = simd_exp<V>(V::sub(V::load(_x + j), _max));
+            _sum = V::add(_sum, e);
+            V::store(_out + j, e);
+        }
+        T sum = V::hsum(_sum);
+        for(; j < cols; j++){
+            _out[j] = scalar_exp(_x[j] - max);
+            sum += _out[j];
+        }
+
+        T inv = 1 / sum;
+        R _inv = V::set1(inv);
+        for(j = 0; j + W <= cols; j += W){
+            V::store(_out + j, V::mul(V::load(_out + j), _inv));
+        }
+        for(; j < cols; j++) _out[j] *= inv;
+    }
+}
+
+template<class V>
+static void simd_softmax_backward(int rows, int cols, const typename V::scalar* y, const typename V::scalar* dy, typename V::scalar* out){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    for(int r = 0; r < rows; r++){
+        const T* _y = y + r * cols;
+        const T* _dy = dy + r * cols;
+        T* _out = out + r * cols;
+
+        int j = 0;
+        R _dot = V::zero();
+        for(; j + W <= cols; j += W) _dot = V::fmadd(V::load(_dy + j), V::load(_y + j), _dot);
+        T dot = V::hsum(_dot);
+        for(; j < cols; j++) dot += _dy[j] * _y[j];
+
+        R _dot_all = V::set1(dot);
+        for(j = 0; j + W <= cols; j += W){
+            V::store(_out + j, V::mul(V::load(_y + j), V::sub(V::load(_dy + j), _dot_all)));
+        }
+        for(; j < cols; j++) _out[j] = _y[j] * (_dy[j] - dot);
+    }
+}
+
+template<class V>
+static void simd_sgd_update(int n, const BasicUpdateParams<typename V::scalar>& p, typename V::scalar* w, typename V::scalar* g){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    T alpha = p.lr * p.scale;
+    R _alpha = V::set1(alpha);
+    R zero = V::zero();
+    int i = 0;
+    for(; i + W <= n; i += W){
+        V::store(w + i, V::fmadd(_alpha, V::load(g + i), V::load(w + i)));
+        V::store(g + i, zero);
+    }
+    for(; i < n; i++){
+        w[i] += alpha * g[i];
+        g[i] = 0;
+    }
+}
+
+template<class V>
+static void simd_momentum_update(int n, const BasicUpdateParams<typename V::scalar>& p, typename V::scalar* w, typename V::scalar* g, typename V::scalar* v){
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R lr = V::set1(p.lr), scale = V::set1(p.scale), beta1 = V::set1(p.beta1);
+    R zero = V::zero();
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R _v = V::fmadd(beta1, V::load(v + i), V::mul(scale, V::load(g + i)));
+        V::store(v + i, _v);
+        V::store(w + i, V::fmadd(lr, _v, V::load(w + i)));
+        V::store(g + i, zero);
+    }
+    for(; i < n; i++){
+        v[i] = p.beta1 * v[i] + p.scale * g[i];
+        w[i] += p.lr * v[i];
+        g[i] = 0;
+    }
+}
+
+template<class V>
+static void simd_nesterov_update(int n, const BasicUpdateParams<typename V::scalar>& p, typename V::scalar* w, typename V::scalar* g, typename V::scalar* v){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    R lr = V::set1(p.lr), scale = V::set1(p.scale), beta1 = V::set1(p.beta1);
+    R zero = V::zero();
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R d = V::mul(scale, V::load(g + i));
+        R _v = V::fmadd(beta1, V::load(v + i), d);
+        V::store(v + i, _v);
+        V::store(w + i, V::fmadd(lr, V::fmadd(beta1, _v, d), V::load(w + i)));
+        V::store(g + i, zero);
+    }
+    for(; i < n; i++){
+        T d = p.scale * g[i];
+        v[i] = p.beta1 * v[i] + d;
+        w[i] += p.lr * (d + p.beta1 * v[i]);
+        g[i] = 0;
+    }
+}
+
+template<class V>
+static void simd_adam_update(int n, const BasicUpdateParams<typename V::scalar>& p, typename V::scalar* w, typename V::scalar* g, typename V::scalar* m, typename V::scalar* v){
+    typedef typename V::scalar T;
+    typedef typename V::reg R;
+    const int W = V::width;
+
+    T step_size = p.lr / p.bias_correction1;
+    T inv_sqrt_c2 = 1 / scalar_sqrt(p.bias_correction2);
+    T decay = 1 - p.lr * p.weight_decay;
+
+    R _step_size = V::set1(step_size), _inv_sqrt_c2 = V::set1(inv_sqrt_c2), _decay = V::set1(decay);
+    R scale = V::set1(p.scale), eps = V::set1(p.eps);
+    R beta1 = V::set1(p.beta1), one_minus_beta1 = V::set1(1 - p.beta1);
+    R beta2 = V::set1(p.beta2), one_minus_beta2 = V::set1(1 - p.beta2);
+    R zero = V::zero();
+    int i = 0;
+    for(; i + W <= n; i += W){
+        R d = V::mul(scale, V::load(g + i));
+        R _m = V::fmadd(beta1, V::load(m + i), V::mul(one_minus_beta1, d));
+        R _v = V::fmadd(beta2, V::load(v + i), V::mul(one_minus_beta2, V::mul(d, d)));
+        V::store(m + i, _m);
+        V::store(v + i, _v);
+        R denom = V::fmadd(V::sqrt(_v), _inv_sqrt_c2, eps);
+        V::store(w + i, V::fmadd(_decay, V::load(w + i), V::div(V::mul(_step_size, _m), denom)));
+        V::store(g + i, zero);
+    }
+    for(; i < n; i++){
+        T d = p.scale * g[i];
+        m[i] = p.beta1 * m[i] + (1 - p.beta1) * d;
+        v[i] = p.beta2 * v[i] + (1 - p.beta2) * d * d;
+        w[i] = decay * w[i] + step_size * m[i] / (scalar_sqrt(v[i]) * inv_sqrt_c2 + p.eps);
+        g[i] = 0;
+    }
+}
+
+/**
+ * @brief Build the kernel table of the traits type V
+ */
+template<class V>
+static BasicKernelTable<typename V::scalar> make_simd_kernel_table(IsaLevel isa){
+    BasicKernelTable<typename V::scalar> table = {
+        isa, V::gemm_mr, 2 * V::width,
+        simd_gemm_micro_kernel<V>,
+        simd_gemv_n<V>, simd_gemv_t<V>, simd_axpy<V>, simd_bias_add<V>, simd_scale_u8<V>,
+        simd_relu<V>, simd_relu_derivative<V>, simd_relu_backward<V>,
+        simd_sigmoid<V>, simd_sigmoid_derivative<V>, simd_sigmoid_backward<V>,
+        simd_tanh<V>, simd_tanh_derivative<V>, simd_tanh_backward<V>,
+        simd_softmax<V>, simd_softmax_backward<V>,
+        simd_sgd_update<V>, simd_momentum_update<V>, simd_nesterov_update<V>, simd_adam_update<V>
+    };
+    return table;
+}
+
+#endif // PLAIN_NN_KERNELS_SIMD_KERNELS_H
@@ -4,21 +4,25 @@
 #include <string>
 
 
-ActivationFn* get_activation_fn_from_name(std::string name){
-    ActivationFn* activation_fn;
+template<typename T>
+BasicActivationFn<T>* get_activation_fn_from_name(std::string name){
+    BasicActivationFn<T>* activation_fn;
     std::string activation_name = string_to_lower(name);
 
     if(activation_name.compare(string_to_lower(ACTIVATION_NAMES[ActivationType::RELU])) == 0){
-        activation_fn = new ReLU();
+        activation_fn = new BasicReLU<T>();
     } else if(activation_name.compare(string_to_lower(ACTIVATION_NAMES[ActivationType::SIGMOID])) == 0){
-        activation_fn = new Sigmoid();
+        activation_fn = new BasicSigmoid<T>();
     } else if(activation_name.compare(string_to_lower(ACTIVATION_NAMES[ActivationType::TANH])) == 0){
-        activation_fn = new Tanh();
+        activation_fn = new BasicTanh<T>();
     } else if(activation_name.compare(string_to_lower(ACTIVATION_NAMES[ActivationType::SOFTMAX])) == 0){
-        activation_fn = new Softmax();
+        activation_fn = new BasicSoftmax<T>();
     } else {
-        activation_fn = new None();
+        activation_fn = new BasicNone<T>();
     }
 
     return activation_fn;
-}
\ No newline at end of file
+}
+
+template BasicActivationFn<float>* get_activation_fn_from_name<float>(std::string name);
+template BasicActivationFn<double>* get_activation_fn_from_name<double>(std::string name);
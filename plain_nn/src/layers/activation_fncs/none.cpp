@@ -1,14 +1,29 @@
 #include "activation_fncs.hpp"
 #include "tensor.hpp"
 
-None::None(){
+template<typename T>
+BasicNone<T>::BasicNone(){
     this->fn_type = ActivationType::NONE;
 }
 
-Tensor None::forward(Tensor& input){
+template<typename T>
+BasicTensor<T> BasicNone<T>::forward(BasicTensor<T>& input){
     return input;
 }
 
-Tensor None::backward(Tensor& input){
-    return Tensor(input.shape(), false, 1.0);
-}
\ No newline at end of file
+template<typename T>
+void BasicNone<T>::forward_inplace(__attribute_maybe_unused__ BasicTensor<T>& tensor){}
+
+template<typename T>
+BasicTensor<T> BasicNone<T>::backward(BasicTensor<T>& input){
+    return BasicTensor<T>(input.shape(), false, 1);
+}
+
+template<typename T>
+void BasicNone<T>::backward_inplace(__attribute_maybe_unused__ BasicTensor<T>& output, __attribute_maybe_unused__ BasicTensor<T>& grads){}
+
+template<typename T>
+void BasicNone<T>::fill_epilogue(__attribute_maybe_unused__ BasicGemmEpilogue<T>& epilogue){}
+
+template class BasicNone<float>;
+template class BasicNone<double>;
@@ -1,28 +1,43 @@
 #include "activation_fncs.hpp"
 #include "tensor.hpp"
-#include <algorithm>
+#include "kernels.hpp"
 
-ReLU::ReLU(){
+template<typename T>
+BasicReLU<T>::BasicReLU(){
     this->fn_type = ActivationType::RELU;
 }
 
 
-Tensor ReLU::forward(Tensor& input){
-    std::vector<double> output;
-    
-    double *_input = input.data();
-    std::for_each(_input, _input+input.size(), [&output](double& x){output.push_back(std::max(0.0, x));});
+template<typename T>
+BasicTensor<T> BasicReLU<T>::forward(BasicTensor<T>& input){
+    BasicTensor<T> output(input.shape());
+    get_kernels<T>().relu(input.size(), input.data(), output.data());
+    return output;
+}
+
 
-    return Tensor(input.shape(), output);
+template<typename T>
+void BasicReLU<T>::forward_inplace(BasicTensor<T>& tensor){
+    get_kernels<T>().relu(tensor.size(), tensor.data(), tensor.data());
 }
 
 
-Tensor ReLU::backward(Tensor& input){
+template<typename T>
+BasicTensor<T> BasicReLU<T>::backward(BasicTensor<T>& input){
+    BasicTensor<T> output(input.shape());
+    get_kernels<T>().relu_derivative(input.size(), input.data(), output.data());
+    return output;
+}
 
-    std::vector<double> output;
+template<typename T>
+void BasicReLU<T>::backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads){
+    get_kernels<T>().relu_backward(output.size(), output.data(), grads.data(), grads.data());
+}
 
-    double *_input = input.data();
-    std::for_each(_input, _input+input.size(), [&output](double& x){output.push_back(x > 0 ? 1 : 0);});
+template<typename T>
+void BasicReLU<T>::fill_epilogue(BasicGemmEpilogue<T>& epilogue){
+    epilogue.activation = get_kernels<T>().relu;
+}
 
-    return Tensor(input.shape(), output);
-}
\ No newline at end of file
+template class BasicReLU<float>;
+template class BasicReLU<double>;
@@ -1,28 +1,40 @@
 #include "activation_fncs.hpp"
 #include "tensor.hpp"
-#include <cmath>
-#include <algorithm>
+#include "kernels.hpp"
 
-Sigmoid::Sigmoid(){
+template<typename T>
+BasicSigmoid<T>::BasicSigmoid(){
     this->fn_type = ActivationType::SIGMOID;
 }
 
-Tensor Sigmoid::forward(Tensor& input){
-
-    std::vector<double> output;
-
-    double* _input = input.data();
-    std::for_each(_input, _input+input.size(), [&output](double& x){output.push_back(1 / (1 + std::exp(-x)));});
+template<typename T>
+BasicTensor<T> BasicSigmoid<T>::forward(BasicTensor<T>& input){
+    BasicTensor<T> output(input.shape());
+    get_kernels<T>().sigmoid(input.size(), input.data(), output.data());
+    return output;
+}
 
-    return Tensor(input.shape(), output);
+template<typename T>
+void BasicSigmoid<T>::forward_inplace(BasicTensor<T>& tensor){
+    get_kernels<T>().sigmoid(tensor.size(), tensor.data(), tensor.data());
 }
 
-Tensor Sigmoid::backward(Tensor& input){
+template<typename T>
+BasicTensor<T> BasicSigmoid<T>::backward(BasicTensor<T>& input){
+    BasicTensor<T> output(input.shape());
+    get_kernels<T>().sigmoid_derivative(input.size(), input.data(), output.data());
+    return output;
+}
 
-    std::vector<double> output;
+template<typename T>
+void BasicSigmoid<T>::backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads){
+    get_kernels<T>().sigmoid_backward(output.size(), output.data(), grads.data(), grads.data());
+}
 
-    double* _input = input.data();
-    std::for_each(_input, _input+input.size(), [&output](double& x){output.push_back(x * (1 - x));});
+template<typename T>
+void BasicSigmoid<T>::fill_epilogue(BasicGemmEpilogue<T>& epilogue){
+    epilogue.activation = get_kernels<T>().sigmoid;
+}
 
-    return Tensor(input.shape(), output);
-}
\ No newline at end of file
+template class BasicSigmoid<float>;
+template class BasicSigmoid<double>;
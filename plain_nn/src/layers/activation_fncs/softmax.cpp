@@ -1,33 +1,50 @@
 #include "activation_fncs.hpp"
 #include "tensor.hpp"
+#include "kernels.hpp"
 
-#include <cmath>
-#include <algorithm>
-
-Softmax::Softmax(){
+template<typename T>
+BasicSoftmax<T>::BasicSoftmax(){
     this->fn_type = ActivationType::SOFTMAX;
 }
 
-Tensor Softmax::forward(Tensor& input){
-    std::vector<double> output(input.size());
-    double *_input = input.data();
-    double max = *std::max_element(_input, _input + input.size());
-    double sum = 0.0;
-    for (int i = 0; i < input.size(); i++){
-        output[i] = std::exp(_input[i] - max);
-        sum += output[i];
-    }
-    for (int i = 0; i < input.size(); i++){
-        output[i] /= sum;
-    }
-    return Tensor(input.shape(), output);
+template<typename T>
+BasicTensor<T> BasicSoftmax<T>::forward(BasicTensor<T>& input){
+    BasicTensor<T> output(input.shape());
+
+    // The softmax is computed independently over the last dimension,
+    // so that a batch of shape (N, C) yields N distributions
+    int row_size = input.shape().back();
+    int rows = input.size() / row_size;
+
+    get_kernels<T>().softmax(rows, row_size, input.data(), output.data());
+    return output;
+}
+
+template<typename T>
+void BasicSoftmax<T>::forward_inplace(BasicTensor<T>& tensor){
+    int row_size = tensor.shape(tensor.ndim() - 1);
+    get_kernels<T>().softmax(tensor.size() / row_size, row_size, tensor.data(), tensor.data());
+}
+
+template<typename T>
+BasicTensor<T> BasicSoftmax<T>::backward(BasicTensor<T>& input){
+    // An elementwise derivative can only hold the diagonal of the jacobian
+    BasicTensor<T> output(input.shape());
+    get_kernels<T>().sigmoid_derivative(input.size(), input.data(), output.data());
+    return output;
+}
+
+template<typename T>
+void BasicSoftmax<T>::backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads){
+    // The whole jacobian of each row, the outputs of a row are not independent
+    int row_size = output.shape(output.ndim() - 1);
+    get_kernels<T>().softmax_backward(output.size() / row_size, row_size, output.data(), grads.data(), grads.data());
+}
+
+template<typename T>
+void BasicSoftmax<T>::fill_epilogue(BasicGemmEpilogue<T>& epilogue){
+    epilogue.row_activation = get_kernels<T>().softmax;
 }
 
-Tensor Softmax::backward(Tensor& input){
-    std::vector<double> output(input.size());
-    double *_input = input.data();
-    for (int i = 0; i < input.size(); i++){
-        output[i] = _input[i] * (1 - _input[i]);
-    }
-    return Tensor(input.shape(), output);
-}
\ No newline at end of file
+template class BasicSoftmax<float>;
+template class BasicSoftmax<double>;
@@ -1,28 +1,41 @@
 #include "activation_fncs.hpp"
 #include "tensor.hpp"
-#include <cmath>
-#include <algorithm>
+#include "kernels.hpp"
 
-Tanh::Tanh(){
+template<typename T>
+BasicTanh<T>::BasicTanh(){
     this->fn_type = ActivationType::TANH;
 }
 
-Tensor Tanh::forward(Tensor& input){
-
-    std::vector<double> output;
+template<typename T>
+BasicTensor<T> BasicTanh<T>::forward(BasicTensor<T>& input){
+    BasicTensor<T> output(input.shape());
+    get_kernels<T>().tanh(input.size(), input.data(), output.data());
+    return output;
+}
 
-    double* _input = input.data();
-    std::for_each(_input, _input+input.size(), [&output](double& x){output.push_back(std::tanh(x));});
+template<typename T>
+void BasicTanh<T>::forward_inplace(BasicTensor<T>& tensor){
+    get_kernels<T>().tanh(tensor.size(), tensor.data(), tensor.data());
+}
 
-    return Tensor(input.shape(), output);
+template<typename T>
+BasicTensor<T> BasicTanh<T>::backward(BasicTensor<T>& input){
+    // 1 - y^2, the input being the output of the forward pass
+    BasicTensor<T> output(input.shape());
+    get_kernels<T>().tanh_derivative(input.size(), input.data(), output.data());
+    return output;
 }
 
-Tensor Tanh::backward(Tensor& input){
+template<typename T>
+void BasicTanh<T>::backward_inplace(BasicTensor<T>& output, BasicTensor<T>& grads){
+    get_kernels<T>().tanh_backward(output.size(), output.data(), grads.data(), grads.data());
+}
 
-    std::vector<double> output;
+template<typename T>
+void BasicTanh<T>::fill_epilogue(BasicGemmEpilogue<T>& epilogue){
+    epilogue.activation = get_kernels<T>().tanh;
+}
 
-    double* _input = input.data();
-    std::for_each(_input, _input+input.size(), [&output](double& x){output.push_back(1 - std::pow(std::tanh(x), 2));});
-    
-    return Tensor(input.shape(), output);
-}
\ No newline at end of file
+template class BasicTanh<float>;
+template class BasicTanh<double>;
@@ -1,10 +1,13 @@
 #include "layers.hpp"
 #include "activation_fncs.hpp"
+#include "gemm.hpp"
 
 #include <stdexcept>
 #include <vector>
+#include <algorithm>
 
-Dense::Dense(int input_size, int output_size, ActivationFn* activation, bool frozen){
+template<typename T>
+BasicDense<T>::BasicDense(int input_size, int output_size, BasicActivationFn<T>* activation, bool frozen){
 
     this->input_size = input_size;
     this->output_size = output_size;
@@ -12,54 +15,58 @@ Dense::Dense(int input_size, int output_size, ActivationFn* activation, bool fro
     this->layer_type = LayerType::DENSE;
     this->activation_fn = activation;
 
-    this->output = Tensor({output_size});
-    this->weights = Tensor({input_size, output_size}, true);
-    this->d_weights = Tensor({input_size, output_size});
-    this->biases = Tensor({output_size});
-    this->d_biases = Tensor({output_size});
+    this->output = BasicTensor<T>({output_size});
+    this->weights = BasicTensor<T>({input_size, output_size}, true);
+    this->d_weights = BasicTensor<T>({input_size, output_size});
+    this->biases = BasicTensor<T>({output_size});
+    this->d_biases = BasicTensor<T>({output_size});
 
     this->is_frozen = frozen;
     this->is_initialized = true;
 }
 
-Dense::Dense(int output_size, ActivationFn* activation, bool frozen){
+template<typename T>
+BasicDense<T>::BasicDense(int output_size, BasicActivationFn<T>* activation, bool frozen){
 
     this->output_size = output_size;
 
     this->layer_type = LayerType::DENSE;
     this->activation_fn = activation;
 
-    this->output = Tensor({output_size});
+    this->output = BasicTensor<T>({output_size});
 
     this->is_frozen = frozen;
     this->is_initialized = false;
 }
 
-void Dense::initialize(std::vector<int> input_shape){
+template<typename T>
+void BasicDense<T>::initialize(std::vector<int> input_shape){
 
     this->input_size = input_shape[0];
 
-    this->weights = Tensor({input_size, output_size}, true);
-    this->d_weights = Tensor({input_size, output_size});
-    this->biases = Tensor({output_size});
-    this->d_biases = Tensor({output_size});
+    this->weights = BasicTensor<T>({input_size, output_size}, true);
+    this->d_weights = BasicTensor<T>({input_size, output_size});
+    this->biases = BasicTensor<T>({output_size});
+    this->d_biases = BasicTensor<T>({output_size});
 
     this->is_initialized = true;
 }
 
-Tensor* Dense::get_params(){
+template<typename T>
+BasicTensor<T>* BasicDense<T>::get_params(){
     return &this->weights;
 }
 
-std::vector<double> Dense::get_saveable_params(){
-    std::vector<double> saveable_weights;
+template<typename T>
+std::vector<T> BasicDense<T>::get_saveable_params(){
+    std::vector<T> saveable_weights;
     
-    double* weights_data = this->weights.data();
+    T* weights_data = this->weights.data();
     for(int i=0; i<this->weights.size(); i++){
         saveable_weights.push_back(weights_data[i]);
     }
 
-    double* biases_data = this->biases.data();
+    T* biases_data = this->biases.data();
     for(int i=0; i<this->biases.size(); i++){
         saveable_weights.push_back(biases_data[i]);
     }
@@ -67,7 +74,8 @@ std::vector<double> Dense::get_saveable_params(){
     return saveable_weights;
 }
 
-void Dense::load_params( std::vector<double>& params){
+template<typename T>
+void BasicDense<T>::load_params( std::vector<T>& params){
     int idx = 0;
 
     size_t params_count = this->input_size * this->output_size + this->output_size;
@@ -88,120 +96,271 @@ void Dense::load_params( std::vector<double>& params){
     this->is_initialized = true;
 }
 
-Tensor& Dense::forward(Tensor& input){
+template<typename T>
+BasicTensor<T>& BasicDense<T>::forward(BasicTensor<T>& input){
+    return this->compute_forward(input, this->output);
+}
 
-    double *_input = input.data();
-    double *_output = this->output.data();
-    double *_weights = this->weights.data();
-    double *_biases = this->biases.data();
+template<typename T>
+BasicTensor<T>& BasicDense<T>::forward(BasicTensor<T>& input, BasicLayerWorkspace<T>& workspace){
+    return this->compute_forward(input, workspace.output);
+}
 
-    for(int j = 0; j< this->output_size; j++){
-        _output[j] = _biases[j];
-        for(int i=0; i<this->input_size; i++){
-            _output[j] += _input[i] * _weights[i*this->output_size + j];
-        }
-        // _output[j] = this->activation_fn->forward(_output[j]);
-    } 
-    output = this->activation_fn->forward(output);
+template<typename T>
+BasicTensor<T>& BasicDense<T>::compute_forward(BasicTensor<T>& input, BasicTensor<T>& output){
+
+    // The input is either a single sample of shape (input_size) or
+    // a batch of samples of shape (batch_size, input_size)
+    // The shape is queried without copying it, so that a
+    // steady-state forward pass does not allocate
+    bool is_batched = input.ndim() > 1;
+    int batch_size = is_batched ? input.shape(0) : 1;
+
+    // The samples of a view can be further apart than input_size,
+    // e.g. a slice of the features, but their features must be adjacent
+    if(input.stride(input.ndim() - 1) != 1){
+        throw std::runtime_error("The features of the input of a Dense layer must be contiguous");
+    }
+    int input_stride = is_batched ? input.stride(0) : this->input_size;
+
+    if(output.size() != batch_size * this->output_size || output.ndim() != input.ndim()){
+        if(is_batched) output.reshape({batch_size, this->output_size});
+        else output.reshape({this->output_size});
+    }
+
+    T *_input = input.data();
+    T *_output = output.data();
+    T *_weights = this->weights.data();
+    T *_biases = this->biases.data();
+
+    // Y = f(X * W + b), computed as a single matrix-matrix product
+    // over the whole batch so that each row of the weights is
+    // loaded once per batch instead of once per sample. The bias
+    // and the activation are applied by the epilogue of the
+    // product, while each tile of Y is still in cache
+    BasicGemmEpilogue<T> epilogue = {_biases, nullptr, nullptr};
+    this->activation_fn->fill_epilogue(epilogue);
+
+    gemm(NO_TRANS, NO_TRANS, batch_size, this->output_size, this->input_size,
+        1.0, _input, input_stride, _weights, this->output_size,
+        0.0, _output, this->output_size, epilogue);
 
     return output;
 }
 
-Tensor Dense::backward(
-        Tensor* prev_output, 
-        Tensor* next_weights,
-        Tensor* next_grad){
+template<typename T>
+BasicTensor<T>& BasicDense<T>::backward(
+        BasicTensor<T>* prev_output, 
+        BasicTensor<T>* next_weights,
+        BasicTensor<T>* next_grad){
+    return this->compute_backward(prev_output, next_weights, next_grad, this->output, this->d_weights, this->d_biases, this->grads);
+}
+
+template<typename T>
+BasicTensor<T>& BasicDense<T>::backward(
+        BasicTensor<T>* prev_output, 
+        BasicTensor<T>* next_weights,
+        BasicTensor<T>* next_grad,
+        BasicLayerWorkspace<T>& workspace){
+    return this->compute_backward(prev_output, next_weights, next_grad, workspace.output, workspace.d_weights, workspace.d_biases, workspace.grads);
+}
+
+template<typename T>
+BasicTensor<T>& BasicDense<T>::compute_backward(
+        BasicTensor<T>* prev_output, 
+        BasicTensor<T>* next_weights,
+        BasicTensor<T>* next_grad,
+        BasicTensor<T>& output,
+        BasicTensor<T>& d_weights,
+        BasicTensor<T>& d_biases,
+        BasicTensor<T>& grads){
     
-    Tensor d_err = Tensor({this->output_size});
-    Tensor grads = Tensor({this->output_size});
+    int batch_size = output.size() / this->output_size;
+
+    // Every element is overwritten below, the buffer
+    // is only reallocated when the batch size changes
+    if(grads.is_view() || grads.shape() != output.shape()){
+        grads.reshape(output.shape());
+    }
 
     // Taking a local reference directly to the data
     // significantly improves the performance
-    double* _prev_output = (prev_output == nullptr) ? nullptr : prev_output->data();
-    double* _next_weights = (next_weights == nullptr) ? nullptr : next_weights->data();
-    double* _next_grad = (next_grad == nullptr) ? nullptr : next_grad->data();
+    T* _prev_output = (prev_output == nullptr) ? nullptr : prev_output->data();
+    T* _next_weights = (next_weights == nullptr) ? nullptr : next_weights->data();
+    T* _next_grad = (next_grad == nullptr) ? nullptr : next_grad->data();
     
-    double* _d_err = d_err.data();
-    double* _grads = grads.data();
-    double* _output = this->output.data();
-    double* _d_weights = this->d_weights.data();
-    double* _d_biases = this->d_biases.data();
-
-    Tensor act_fn_der = this->activation_fn->backward(this->output);
-    double* _act_fn_der = act_fn_der.data();
-
-    for(int perceptron = 0; perceptron < this->output_size; perceptron++){
-
-        if(next_weights == nullptr){
-            // If next_grad is null, it means that this is the last layer
-            // and the next layer is the output layer. In this case, the
-            // next_grad is the gradient of the loss function with respect
-            // to the output of this layer.
-            _d_err[perceptron] = _next_grad[perceptron] - _output[perceptron];
-            _grads[perceptron] += _d_err[perceptron] * _act_fn_der[perceptron];
-        } else{
-            // If next_grad is not null, it means that this is not the last
-            // layer and the next layer is not the output layer. In this case,
-            // the next_grad is the gradient of the loss function with respect
-            // to the output of the next layer.
-            _d_err[perceptron] = 0;
-            int next_layer_size = next_grad->size();
-            int offset = perceptron * next_layer_size;
-            for(int next_perceptron = 0; next_perceptron < next_layer_size; next_perceptron++){
-                _d_err[perceptron] += _next_grad[next_perceptron] * _next_weights[offset + next_perceptron];
-            }
-            _grads[perceptron] += _d_err[perceptron] * _act_fn_der[perceptron];
-        }
+    T* _grads = grads.data();
+    T* _d_weights = d_weights.data();
+    T* _d_biases = d_biases.data();
+
+    if(next_weights == nullptr){
+        // If next_weights is null, it means that this is the last layer
+        // and the next layer is the output layer. In this case, the
+        // next_grad is the error signal of the loss function with respect
+        // to the output of this layer, or to the input of the activation
+        // when the loss is fused with it.
+        std::copy(_next_grad, _next_grad + batch_size * this->output_size, _grads);
+    } else{
+        // If next_weights is not null, it means that this is not the last
+        // layer and the next layer is not the output layer. In this case,
+        // the next_grad is the gradient of the loss function with respect
+        // to the output of the next layer. For the whole batch this is 
+        // D = G_next * W_next^T
+        int next_layer_size = next_grad->size() / batch_size;
+        gemm(NO_TRANS, TRANS, batch_size, this->output_size, next_layer_size,
+            1.0, _next_grad, next_layer_size, _next_weights, next_layer_size,
+            0.0, _grads, this->output_size);
     }
 
-    // Accumulate the gradients for the weights and biases
-    for(int perceptron = 0; perceptron < this->input_size; perceptron++){
-        int offset = perceptron * this->output_size;
-        for(int weight = 0; weight < this->output_size; weight++){
-            _d_weights[offset + weight] += _grads[weight] * _prev_output[perceptron];
-        }
+    // The error is multiplied in place by the derivative of the
+    // activation, evaluated on the output of the forward pass
+    if(next_weights != nullptr || !this->fused_output_grad){
+        this->activation_fn->backward_inplace(output, grads);
     }
 
-    for(int perceptron = 0; perceptron < this->output_size; perceptron++){
-        _d_biases[perceptron] += _grads[perceptron];
+    // Accumulate the gradients for the weights and biases over
+    // the whole batch, dW += X^T * G and db += sum_b(G)
+    int prev_output_stride = (prev_output != nullptr && prev_output->ndim() > 1) ? prev_output->stride(0) : this->input_size;
+    gemm(TRANS, NO_TRANS, this->input_size, this->output_size, batch_size,
+        1.0, _prev_output, prev_output_stride, _grads, this->output_size,
+        1.0, _d_weights, this->output_size);
+
+    for(int b = 0; b < batch_size; b++){
+        axpy(this->output_size, 1.0, _grads + b * this->output_size, _d_biases);
     }
 
     return grads;
 }
 
-void Dense::step(double learning_rate, int batch_size){
-    
-    double* _d_weights = this->d_weights.data();
-    double* _weights = this->weights.data();
-    double* _d_biases = this->d_biases.data();
-    double* _biases = this->biases.data();
-
-    for(int perceptron = 0; perceptron < this->input_size; perceptron++){
-        int offset = perceptron * this->output_size;
-        for(int weight = 0; weight < this->output_size; weight++){
-            _weights[offset + weight] += learning_rate * _d_weights[offset + weight] / batch_size;
-        }
+template<typename T>
+void BasicDense<T>::init_workspace(BasicLayerWorkspace<T>& workspace, T* grads){
+    workspace.output = BasicTensor<T>({this->output_size});
+    if(grads != nullptr){
+        std::fill(grads, grads + this->weights.size() + this->biases.size(), 0);
+        workspace.d_weights = BasicTensor<T>({this->input_size, this->output_size}, grads);
+        workspace.d_biases = BasicTensor<T>({this->output_size}, grads + this->weights.size());
+    } else{
+        workspace.d_weights = BasicTensor<T>({this->input_size, this->output_size});
+        workspace.d_biases = BasicTensor<T>({this->output_size});
     }
+}
 
-    for(int perceptron = 0; perceptron < this->output_size; perceptron++){
-        _biases[perceptron] += learning_rate * _d_biases[perceptron] / batch_size;
-    }
+template<typename T>
+void BasicDense<T>::bind_params(T* params, T* grads){
+    // The weights are followed by the biases, as in get_saveable_params
+    int weights_size = this->weights.size();
+    int biases_size = this->biases.size();
+
+    std::copy(this->weights.data(), this->weights.data() + weights_size, params);
+    std::copy(this->biases.data(), this->biases.data() + biases_size, params + weights_size);
+    std::copy(this->d_weights.data(), this->d_weights.data() + weights_size, grads);
+    std::copy(this->d_biases.data(), this->d_biases.data() + biases_size, grads + weights_size);
+
+    this->weights = BasicTensor<T>({this->input_size, this->output_size}, params);
+    this->biases = BasicTensor<T>({this->output_size}, params + weights_size);
+    this->d_weights = BasicTensor<T>({this->input_size, this->output_size}, grads);
+    this->d_biases = BasicTensor<T>({this->output_size}, grads + weights_size);
+}
+
+template<typename T>
+void BasicDense<T>::accumulate_workspace(BasicLayerWorkspace<T>& workspace){
+    axpy(this->d_weights.size(), 1.0, workspace.d_weights.data(), this->d_weights.data());
+    axpy(this->d_biases.size(), 1.0, workspace.d_biases.data(), this->d_biases.data());
+
+    workspace.d_weights.clear();
+    workspace.d_biases.clear();
+}
+
+template<typename T>
+void BasicDense<T>::step(double learning_rate, int batch_size){
+    BasicSGD<T> sgd;
+    step(sgd, 0, learning_rate, batch_size);
+}
+
+template<typename T>
+void BasicDense<T>::step(double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace){
+    BasicSGD<T> sgd;
+    step(sgd, 0, learning_rate, batch_size, workspace);
+}
+
+template<typename T>
+void BasicDense<T>::step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size){
+    
+    T* _d_weights = this->d_weights.data();
+    T* _weights = this->weights.data();
+    T* _d_biases = this->d_biases.data();
+    T* _biases = this->biases.data();
+
+    // The gradients are reset by the update itself
+    optimizer.update(state_offset, this->weights.size(), _weights, _d_weights, learning_rate, 1.0 / batch_size);
+    optimizer.update(state_offset + this->weights.size(), this->biases.size(), _biases, _d_biases, learning_rate, 1.0 / batch_size);
+}
+
+template<typename T>
+void BasicDense<T>::step(BasicOptimizer<T>& optimizer, long int state_offset, double learning_rate, int batch_size, BasicLayerWorkspace<T>& workspace){
 
-    // Reset the gradients
-    d_weights.clear();
-    d_biases.clear();
+    // Other threads may be reading or updating the same weights, each
+    // value is updated atomically but an update racing with another
+    // one can be lost, which in practice does not prevent convergence
+    optimizer.update_relaxed(state_offset, this->weights.size(), this->weights.data(), workspace.d_weights.data(), learning_rate, 1.0 / batch_size);
+    optimizer.update_relaxed(state_offset + this->weights.size(), this->biases.size(), this->biases.data(), workspace.d_biases.data(), learning_rate, 1.0 / batch_size);
 }
 
-LayerSummary Dense::get_summary(){
+template<typename T>
+LayerSummary BasicDense<T>::get_summary(){
     LayerSummary summary;
     summary.layer_type = this->layer_type;
     summary.layer_name = LAYER_TYPE_NAMES[this->layer_type];
     summary.activation_fn = this->activation_fn->name();
 
     summary.param_count = this->input_size * this->output_size + this->output_size;
-    summary.param_size = sizeof(double);
+    summary.param_size = sizeof(T);
+    summary.dtype = DTypeOf<T>::value;
 
     summary.layer_shape = weights.shape();
     return summary;
 }
 
+template<typename T>
+LayerCost BasicDense<T>::get_cost(int batch_size, bool input_grads){
+    long int in = this->input_size, out = this->output_size;
+    long int params = in * out + out;
+    double params_per_sample = static_cast<double>(params) / batch_size;
+
+    LayerCost cost = {};
+    cost.trainable = !this->is_frozen;
+    cost.param_count = params;
+
+    // Y = f(X * W + b), the weights are read once per batch
+    cost.forward_flops = 2 * in * out + out + out * ACTIVATION_FORWARD_FLOPS[this->activation_fn->type()];
+    double moved = in + out + params_per_sample;
+    cost.activation_bytes = out * sizeof(T);
+
+    if(cost.trainable){
+        // dW += X^T * G and db += G, the derivative of the activation
+        // is skipped when it is fused with the loss
+        cost.backward_flops = 2 * in * out + out;
+        if(!this->fused_output_grad) cost.backward_flops += out * ACTIVATION_BACKWARD_FLOPS[this->activation_fn->type()];
+        moved += 4 * out + in + 2 * params_per_sample;
+
+        // dX = G * W^T, computed by the backward pass of the previous layer
+        if(input_grads){
+            cost.backward_flops += 2 * in * out;
+            moved += out + in + params_per_sample;
+        }
+
+        cost.activation_bytes += out * sizeof(T);
+        cost.gradient_bytes = params * sizeof(T);
+    }
+
+    cost.bytes_per_sample = moved * sizeof(T);
+    return cost;
+}
+
+template<typename T>
+ActivationType BasicDense<T>::activation_type(){
+    return this->activation_fn->type();
+}
+
+template class BasicDense<float>;
+template class BasicDense<double>;
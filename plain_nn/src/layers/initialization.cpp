@@ -1,15 +1,22 @@
 #include "initialization.hpp"
+#include "aligned_buffer.hpp"
 #include <cmath>
 #include <vector>
 
+template<typename T, typename Alloc>
 void GolorotInitialization::initialize(
-    std::vector<double>& tensor,
+    std::vector<T, Alloc>& tensor,
     double dim_sum
 ){
     std::srand(time(NULL));
     double limit_ih = std::sqrt(6.0/dim_sum);
 
     for(size_t i=0; i<tensor.size(); i++){
-        tensor[i] = ((double) std::rand() / RAND_MAX) * 2 * limit_ih - limit_ih;
+        tensor[i] = static_cast<T>(((double) std::rand() / RAND_MAX) * 2 * limit_ih - limit_ih);
     }
 }
+
+template void GolorotInitialization::initialize(std::vector<float>& tensor, double dim_sum);
+template void GolorotInitialization::initialize(std::vector<double>& tensor, double dim_sum);
+template void GolorotInitialization::initialize(AlignedVectorF& tensor, double dim_sum);
+template void GolorotInitialization::initialize(AlignedVector& tensor, double dim_sum);
@@ -5,32 +5,37 @@
 #include "layers.hpp"
 #include "tensor.hpp"
 
-Input::Input(std::initializer_list<int> shape, bool frozen){
+template<typename T>
+BasicInput<T>::BasicInput(std::initializer_list<int> shape, bool frozen){
 
     this->layer_type = LayerType::INPUT;
 
-    this->output = Tensor(shape);
+    this->output = BasicTensor<T>(shape);
 
     this->is_frozen = frozen;
     this->is_initialized = true;
 }
 
-Input::Input(std::vector<int> shape, bool frozen){
+template<typename T>
+BasicInput<T>::BasicInput(std::vector<int> shape, bool frozen){
     
     this->layer_type = LayerType::INPUT;
 
-    this->output = Tensor(shape);
+    this->output = BasicTensor<T>(shape);
 
     this->is_frozen = frozen;
     this->is_initialized = true;
 }
 
-Tensor& Input::forward( Tensor& input){
-    this->output = input;
+template<typename T>
+BasicTensor<T>& BasicInput<T>::forward( BasicTensor<T>& input){
+    // The output views the input, nothing is copied
+    this->output = input.view();
     return this->output;
 }
 
-Tensor Input::backward(__attribute_maybe_unused__ Tensor* prev_output, __attribute_maybe_unused__ Tensor* next_weights, __attribute_maybe_unused__ Tensor* next_grad){
+template<typename T>
+BasicTensor<T>& BasicInput<T>::backward(__attribute_maybe_unused__ BasicTensor<T>* prev_output, __attribute_maybe_unused__ BasicTensor<T>* next_weights, __attribute_maybe_unused__ BasicTensor<T>* next_grad){
     
     // The input layer does not have any weights or biases, so there is no
     // need to calculate the gradients. Throw runtime exception with message
@@ -38,7 +43,31 @@ Tensor Input::backward(__attribute_maybe_unused__ Tensor* prev_output, __attribu
     throw std::runtime_error("Input layer does not have weights or biases, so it does not have gradients.");
 }
 
-void Input::step(__attribute_maybe_unused__ double learning_rate, __attribute_maybe_unused__ int batch_size){
+template<typename T>
+BasicTensor<T>& BasicInput<T>::forward( BasicTensor<T>& input, BasicLayerWorkspace<T>& workspace){
+    workspace.output = input.view();
+    return workspace.output;
+}
+
+template<typename T>
+BasicTensor<T>& BasicInput<T>::backward(__attribute_maybe_unused__ BasicTensor<T>* prev_output, __attribute_maybe_unused__ BasicTensor<T>* next_weights, __attribute_maybe_unused__ BasicTensor<T>* next_grad, __attribute_maybe_unused__ BasicLayerWorkspace<T>& workspace){
+    throw std::runtime_error("Input layer does not have weights or biases, so it does not have gradients.");
+}
+
+template<typename T>
+void BasicInput<T>::init_workspace( __attribute_maybe_unused__ BasicLayerWorkspace<T>& workspace, __attribute_maybe_unused__ T* grads){
+    // The input layer does not have any weights or biases,
+    // so there are no gradients to allocate
+}
+
+template<typename T>
+void BasicInput<T>::accumulate_workspace( __attribute_maybe_unused__ BasicLayerWorkspace<T>& workspace){
+    // The input layer does not have any weights or biases,
+    // so there are no gradients to accumulate
+}
+
+template<typename T>
+void BasicInput<T>::step(__attribute_maybe_unused__ double learning_rate, __attribute_maybe_unused__ int batch_size){
     // The input layer does not have any weights or biases, so there is no
     // need to update them. Throw runtime exception with message
 
@@ -47,35 +76,65 @@ void Input::step(__attribute_maybe_unused__ double learning_rate, __attribute_ma
 
 
 
-std::vector<double> Input::get_saveable_params(){
+template<typename T>
+void BasicInput<T>::step(__attribute_maybe_unused__ double learning_rate, __attribute_maybe_unused__ int batch_size, __attribute_maybe_unused__ BasicLayerWorkspace<T>& workspace){
+    throw std::runtime_error("Input layer does not have weights or biases, so it does not have gradients.");
+}
+
+template<typename T>
+void BasicInput<T>::step(
+    __attribute_maybe_unused__ BasicOptimizer<T>& optimizer, __attribute_maybe_unused__ long int state_offset,
+    __attribute_maybe_unused__ double learning_rate, __attribute_maybe_unused__ int batch_size
+){
+    throw std::runtime_error("Input layer does not have weights or biases, so it does not have gradients.");
+}
+
+template<typename T>
+void BasicInput<T>::step(
+    __attribute_maybe_unused__ BasicOptimizer<T>& optimizer, __attribute_maybe_unused__ long int state_offset,
+    __attribute_maybe_unused__ double learning_rate, __attribute_maybe_unused__ int batch_size,
+    __attribute_maybe_unused__ BasicLayerWorkspace<T>& workspace
+){
+    throw std::runtime_error("Input layer does not have weights or biases, so it does not have gradients.");
+}
+
+template<typename T>
+std::vector<T> BasicInput<T>::get_saveable_params(){
     // The input layer does not have any weights or biases, so there is no
     // need to save them. Throw runtime exception with message
 
-    return std::vector<double>();
+    return std::vector<T>();
 }
 
-void Input::load_params( __attribute_maybe_unused__ std::vector<double>& params){
+template<typename T>
+void BasicInput<T>::load_params( __attribute_maybe_unused__ std::vector<T>& params){
     // The input layer does not have any weights or biases, so there is no
     // need to load them. Throw runtime exception with message
 
     return;
 }
 
-void Input::initialize( __attribute_maybe_unused__ std::vector<int> input_shape){
+template<typename T>
+void BasicInput<T>::initialize( __attribute_maybe_unused__ std::vector<int> input_shape){
     // The input layer does not have any weights or biases, so there is no
     // need to initialize them. Throw runtime exception with message
 
     throw std::runtime_error("Input layer does not have weights or biases, so it does not have gradients.");
 }
 
-LayerSummary Input::get_summary(){
+template<typename T>
+LayerSummary BasicInput<T>::get_summary(){
     LayerSummary summary;
     summary.layer_type = this->layer_type;
     summary.layer_name = LAYER_TYPE_NAMES[this->layer_type];
     summary.activation_fn = ACTIVATION_NAMES[ActivationType::NONE];
     summary.param_count = 0;
     summary.param_size = 0;
+    summary.dtype = DTypeOf<T>::value;
     summary.layer_shape = this->output.shape();
 
     return summary;
-}
\ No newline at end of file
+}
+
+template class BasicInput<float>;
+template class BasicInput<double>;
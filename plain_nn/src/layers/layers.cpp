@@ -4,27 +4,43 @@
 #include <string>
 #include <vector>
 
-void Layer::freeze(bool freeze){
+template<typename T>
+void BasicLayer<T>::freeze(bool freeze){
     is_frozen = freeze;
 }
 
-std::string Layer::name(){
+template<typename T>
+std::string BasicLayer<T>::name(){
     return LAYER_TYPE_NAMES[layer_type];
 }
 
+template<typename T>
+LayerCost BasicLayer<T>::get_cost(__attribute_maybe_unused__ int batch_size, __attribute_maybe_unused__ bool input_grads){
+    LayerCost cost = {};
+    cost.trainable = !is_frozen;
+    cost.param_count = get_summary().param_count;
+    return cost;
+}
+
 
-Layer* build_layer_from_name(std::string name, std::vector<int> layer_shape, ActivationFn* activation_fn){
-    Layer* layer;
+template<typename T>
+BasicLayer<T>* build_layer_from_name(std::string name, std::vector<int> layer_shape, BasicActivationFn<T>* activation_fn){
+    BasicLayer<T>* layer;
     std::string layer_name = string_to_lower(name);
 
     if(layer_name.compare(string_to_lower(LAYER_TYPE_NAMES[LayerType::DENSE])) == 0){
-        layer = new Dense(layer_shape[0], layer_shape[1], activation_fn);
+        layer = new BasicDense<T>(layer_shape[0], layer_shape[1], activation_fn);
     } else if(layer_name.compare(string_to_lower(LAYER_TYPE_NAMES[LayerType::INPUT])) == 0){
-        layer = new Input({layer_shape[0]});
+        layer = new BasicInput<T>({layer_shape[0]});
     } else {
         std::printf("Layer type not found: %s\n", name.c_str());
         exit(1);
     }
 
     return layer;
-}
\ No newline at end of file
+}
+
+template class BasicLayer<float>;
+template class BasicLayer<double>;
+template BasicLayer<float>* build_layer_from_name(std::string name, std::vector<int> layer_shape, BasicActivationFn<float>* activation_fn);
+template BasicLayer<double>* build_layer_from_name(std::string name, std::vector<int> layer_shape, BasicActivationFn<double>* activation_fn);
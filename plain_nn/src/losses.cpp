@@ -0,0 +1,126 @@
+#include "losses.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+// Probabilities are clamped away from 0 and 1 before taking their
+// logarithm or dividing by them, so that a saturated output does
+// not produce an infinite loss or gradient
+template<typename T>
+static T clamp_probability(T y){
+    const T eps = std::is_same<T, float>::value ? (T) 1e-7 : (T) 1e-12;
+    return std::min(std::max(y, eps), 1 - eps);
+}
+
+
+template<typename T>
+BasicMSE<T>::BasicMSE(){
+    this->loss_type = LossType::MSE;
+}
+
+template<typename T>
+double BasicMSE<T>::compute(
+    int rows, int cols, __attribute_maybe_unused__ ActivationType activation,
+    const T* output, const T* targets, T* grads, double* loss_per_class
+){
+    double loss = 0;
+    for(int r = 0; r < rows; r++){
+        for(int j = 0; j < cols; j++){
+            int i = r * cols + j;
+            double diff = targets[i] - output[i];
+            double class_loss = 0.5 * diff * diff;
+            loss += class_loss;
+            if(loss_per_class != nullptr) loss_per_class[j] += class_loss;
+
+            // Also the gradient with respect to the input of an identity activation
+            if(grads != nullptr) grads[i] = diff;
+        }
+    }
+    return loss;
+}
+
+template<typename T>
+bool BasicMSE<T>::fuses_with(ActivationType activation){
+    return activation == ActivationType::NONE;
+}
+
+
+template<typename T>
+BasicCrossEntropy<T>::BasicCrossEntropy(){
+    this->loss_type = LossType::CROSS_ENTROPY;
+}
+
+template<typename T>
+double BasicCrossEntropy<T>::compute(
+    int rows, int cols, ActivationType activation,
+    const T* output, const T* targets, T* grads, double* loss_per_class
+){
+    bool fused = fuses_with(activation);
+
+    double loss = 0;
+    for(int r = 0; r < rows; r++){
+        for(int j = 0; j < cols; j++){
+            int i = r * cols + j;
+            T t = targets[i];
+            T y = clamp_probability(output[i]);
+
+            // Only the target classes contribute to the loss
+            if(t != 0){
+                double class_loss = -t * std::log((double) y);
+                loss += class_loss;
+                if(loss_per_class != nullptr) loss_per_class[j] += class_loss;
+            }
+
+            if(grads != nullptr) grads[i] = fused ? t - output[i] : t / y;
+        }
+    }
+    return loss;
+}
+
+template<typename T>
+bool BasicCrossEntropy<T>::fuses_with(ActivationType activation){
+    return activation == ActivationType::SOFTMAX;
+}
+
+
+template<typename T>
+BasicBinaryCrossEntropy<T>::BasicBinaryCrossEntropy(){
+    this->loss_type = LossType::BINARY_CROSS_ENTROPY;
+}
+
+template<typename T>
+double BasicBinaryCrossEntropy<T>::compute(
+    int rows, int cols, ActivationType activation,
+    const T* output, const T* targets, T* grads, double* loss_per_class
+){
+    bool fused = fuses_with(activation);
+
+    double loss = 0;
+    for(int r = 0; r < rows; r++){
+        for(int j = 0; j < cols; j++){
+            int i = r * cols + j;
+            T t = targets[i];
+            T y = clamp_probability(output[i]);
+
+            double class_loss = -(t * std::log((double) y) + (1 - t) * std::log(1 - (double) y));
+            loss += class_loss;
+            if(loss_per_class != nullptr) loss_per_class[j] += class_loss;
+
+            if(grads != nullptr) grads[i] = fused ? t - output[i] : (t - y) / (y * (1 - y));
+        }
+    }
+    return loss;
+}
+
+template<typename T>
+bool BasicBinaryCrossEntropy<T>::fuses_with(ActivationType activation){
+    return activation == ActivationType::SIGMOID;
+}
+
+template class BasicMSE<float>;
+template class BasicMSE<double>;
+template class BasicCrossEntropy<float>;
+template class BasicCrossEntropy<double>;
+template class BasicBinaryCrossEntropy<float>;
+template class BasicBinaryCrossEntropy<double>;
@@ -0,0 +1,63 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(){
+    m_data = nullptr;
+    m_size = 0;
+}
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+void MappedFile::open(std::string path){
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::runtime_error("Error opening file: " + path);
+    }
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0){
+        ::close(fd);
+        throw std::runtime_error("Error reading the size of file: " + path);
+    }
+
+    size_t size = file_stat.st_size;
+    void* data = nullptr;
+    if(size > 0){
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+
+    if(data == MAP_FAILED){
+        throw std::runtime_error("Error mapping file: " + path);
+    }
+
+    m_data = static_cast<unsigned char*>(data);
+    m_size = size;
+}
+
+void MappedFile::close(){
+    if(m_data != nullptr){
+        munmap(m_data, m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+const unsigned char* MappedFile::data(){
+    return m_data;
+}
+
+size_t MappedFile::size(){
+    return m_size;
+}
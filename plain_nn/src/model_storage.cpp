@@ -3,6 +3,36 @@
 #include "layers.hpp"
 #include "json.h"
 #include <fstream>
+#include <cstdlib>
+#include <cstring>
+
+
+/**
+ * @brief Find the value of a key in a JSON object
+ *
+ * @param object The object to search
+ * @param key The key to search for
+ * @return json_value_s* The value, or a null pointer if the key is missing
+ */
+static json_value_s* find_json_value(json_object_s* object, const char* key){
+    for(json_object_element_s* element = object->start; element != nullptr; element = element->next){
+        if(std::strcmp(element->name->string, key) == 0){
+            return element->value;
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief Read count parameters stored as S and convert them to T
+ */
+template<typename S, typename T>
+static void read_params(std::ifstream& file, std::vector<T>& params, int count){
+    std::vector<S> stored(count, 0);
+    file.read((char*)stored.data(), count * sizeof(S));
+    params.assign(stored.begin(), stored.end());
+}
 
 
 void ModelStorage::save_model_arch(
@@ -24,6 +54,7 @@ void ModelStorage::save_model_arch(
         file << "        \"activation_fn\": \"" << summary.activation_fn << "\",\n";
         file << "        \"param_count\": " << summary.param_count << ",\n";
         file << "        \"param_size\": " << summary.param_size << ",\n";
+        file << "        \"dtype\": \"" << DTYPE_NAMES[summary.dtype] << "\",\n";
         file << "        \"layer_shape\": [";
 
         for(size_t shape_idx = 0; shape_idx < summary.layer_shape.size(); shape_idx++){
@@ -44,20 +75,27 @@ void ModelStorage::save_model_arch(
     file.close();
 }
 
+template<typename T>
 void ModelStorage::save_model_weights(
     std::string file_name,
-    std::vector<std::vector<double> > weights
+    std::vector<std::vector<T> > weights
 ){
     std::ofstream file(file_name + MODEL_WEIGHTS_FILE_EXT, std::ios::binary);
     if(!file.is_open()){
         throw std::runtime_error("Error opening weights file: " + file_name + MODEL_WEIGHTS_FILE_EXT);
     }
 
+    unsigned int version = MODEL_WEIGHTS_VERSION;
+    unsigned int dtype = DTypeOf<T>::value;
+    file.write(MODEL_WEIGHTS_MAGIC, sizeof(MODEL_WEIGHTS_MAGIC));
+    file.write((char*)&version, sizeof(version));
+    file.write((char*)&dtype, sizeof(dtype));
+
     for(size_t weight_idx = 0; weight_idx < weights.size(); weight_idx++){
-        std::vector<double> weight = weights[weight_idx];
+        std::vector<T>& weight = weights[weight_idx];
+
+        file.write((char*)weight.data(), weight.size() * sizeof(T));
 
-        file.write((char*)weight.data(), weight.size() * sizeof(double));
-    
     }
 
     file.close();
@@ -65,9 +103,10 @@ void ModelStorage::save_model_weights(
 }
 
 
+template<typename T>
 void ModelStorage::load_model_arch(
     std::string file_name,
-    PlainNN& model
+    BasicPlainNN<T>& model
 ){
     std::ifstream file(file_name + MODEL_ARCH_FILE_EXT);
     if(!file.is_open()){
@@ -87,29 +126,28 @@ void ModelStorage::load_model_arch(
 
     struct json_object_s* root_obj = json_value_as_object(root);
     if(root_obj == NULL){
+        std::free(root);
         throw std::runtime_error("Error parsing JSON file.");
     }
 
     for(json_object_element_s *element = root_obj->start; element != nullptr; element = element->next){
 
-        //json_string_s* key = element->name;
-
         json_object_s* layer_obj = json_value_as_object(element->value);
-        
-        json_object_element_s* layer_name_obj = layer_obj->start;
-        json_string_s* layer_name = json_value_as_string(layer_name_obj->value);
-
-        json_object_element_s* activation_fn_obj = layer_name_obj->next;
-        json_string_s* activation_fn = json_value_as_string(activation_fn_obj->value);
-
-        json_object_element_s* param_count_obj = activation_fn_obj->next;
-        //json_number_s* param_count = json_value_as_number(param_count_obj->value);
+        if(layer_obj == NULL){
+            std::free(root);
+            throw std::runtime_error("Error parsing JSON file, layer " + std::string(element->name->string) + " is not an object.");
+        }
 
-        json_object_element_s* param_size_obj = param_count_obj->next;
-        //json_number_s* param_size = json_value_as_number(param_size_obj->value);
+        // Fields are looked up by name, so that files saved before a
+        // field was added (e.g. dtype) can still be loaded
+        json_string_s* layer_name = json_value_as_string(find_json_value(layer_obj, "layer_name"));
+        json_string_s* activation_fn = json_value_as_string(find_json_value(layer_obj, "activation_fn"));
+        json_array_s* layer_shape = json_value_as_array(find_json_value(layer_obj, "layer_shape"));
 
-        json_object_element_s* layer_shape_obj = param_size_obj->next;
-        json_array_s* layer_shape = json_value_as_array(layer_shape_obj->value);
+        if(layer_name == NULL || activation_fn == NULL || layer_shape == NULL){
+            std::free(root);
+            throw std::runtime_error("Error parsing JSON file, layer " + std::string(element->name->string) + " is missing required fields.");
+        }
 
         std::vector<int> shape;
         for(json_array_element_s* shape_element = layer_shape->start; shape_element != nullptr; shape_element = shape_element->next){
@@ -118,41 +156,80 @@ void ModelStorage::load_model_arch(
         }
 
         std::string activation_fn_str = std::string(activation_fn->string);
-        ActivationFn* activation_fn_ptr = get_activation_fn_from_name(activation_fn_str);
-        
+        BasicActivationFn<T>* activation_fn_ptr = get_activation_fn_from_name<T>(activation_fn_str);
+
         std::string layer_name_str = std::string(layer_name->string);
-        Layer* layer = build_layer_from_name(layer_name_str, shape, activation_fn_ptr);
-        
+        BasicLayer<T>* layer = build_layer_from_name(layer_name_str, shape, activation_fn_ptr);
+
         model.add_layer(layer);
     }
 
-    // TODO: Free the JSON object
+    std::free(root);
 }
 
 
+template<typename T>
 void ModelStorage::load_model_weights(
     std::string file_name,
     int layer_count,
-    PlainNN& model
+    BasicPlainNN<T>& model
 ){
     std::ifstream file(file_name + MODEL_WEIGHTS_FILE_EXT, std::ios::binary);
     if(!file.is_open()){
         throw std::runtime_error("Error opening weights file: " + file_name + MODEL_WEIGHTS_FILE_EXT);
     }
 
+    // Files saved before the header was introduced only
+    // contain the raw float64 parameters
+    DType file_dtype = FLOAT64;
+
+    char magic[sizeof(MODEL_WEIGHTS_MAGIC)] = {0};
+    file.read(magic, sizeof(magic));
+    if(file.gcount() == sizeof(magic) && std::memcmp(magic, MODEL_WEIGHTS_MAGIC, sizeof(magic)) == 0){
+        unsigned int version = 0, dtype = 0;
+        file.read((char*)&version, sizeof(version));
+        file.read((char*)&dtype, sizeof(dtype));
+
+        if(version != MODEL_WEIGHTS_VERSION){
+            throw std::runtime_error("Unsupported weights file version " + std::to_string(version) + " in " + file_name + MODEL_WEIGHTS_FILE_EXT);
+        }
+        if(dtype != FLOAT32 && dtype != FLOAT64){
+            throw std::runtime_error("Unsupported weights dtype " + std::to_string(dtype) + " in " + file_name + MODEL_WEIGHTS_FILE_EXT);
+        }
+        file_dtype = static_cast<DType>(dtype);
+    } else{
+        file.clear();
+        file.seekg(0);
+    }
+
     for(int layer_idx = 0; layer_idx < layer_count; layer_idx++){
-        Layer* layer = model.get_layer(layer_idx);
+        BasicLayer<T>* layer = model.get_layer(layer_idx);
 
         LayerSummary summary = layer->get_summary();
 
         int params_count = summary.param_count;
 
-        std::vector<double> weights(params_count, 0);
+        std::vector<T> weights;
+
+        if(file_dtype == FLOAT32){
+            read_params<float>(file, weights, params_count);
+        } else{
+            read_params<double>(file, weights, params_count);
+        }
 
-        file.read((char*)weights.data(), params_count * summary.param_size);
+        if(!file){
+            throw std::runtime_error("Unexpected end of weights file: " + file_name + MODEL_WEIGHTS_FILE_EXT);
+        }
 
         layer->load_params(weights);
     }
 
     file.close();
-}
\ No newline at end of file
+}
+
+template void ModelStorage::save_model_weights(std::string file_name, std::vector<std::vector<float> > weights);
+template void ModelStorage::save_model_weights(std::string file_name, std::vector<std::vector<double> > weights);
+template void ModelStorage::load_model_arch(std::string file_name, BasicPlainNN<float>& model);
+template void ModelStorage::load_model_arch(std::string file_name, BasicPlainNN<double>& model);
+template void ModelStorage::load_model_weights(std::string file_name, int layer_count, BasicPlainNN<float>& model);
+template void ModelStorage::load_model_weights(std::string file_name, int layer_count, BasicPlainNN<double>& model);
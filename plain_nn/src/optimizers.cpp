@@ -0,0 +1,165 @@
+#include "optimizers.hpp"
+#include "kernels.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+template<typename T>
+BasicSGD<T>::BasicSGD(){
+    this->optimizer_type = OptimizerType::SGD;
+}
+
+template<typename T>
+void BasicSGD<T>::init(__attribute_maybe_unused__ long int num_params){}
+
+template<typename T>
+void BasicSGD<T>::update(
+    __attribute_maybe_unused__ long int state_offset, int n, T* params, T* grads,
+    double learning_rate, double scale
+){
+    BasicUpdateParams<T> update_params = {};
+    update_params.lr = learning_rate;
+    update_params.scale = scale;
+    get_kernels<T>().sgd_update(n, update_params, params, grads);
+}
+
+template<typename T>
+void BasicSGD<T>::update_relaxed(
+    __attribute_maybe_unused__ long int state_offset, int n, T* params, T* grads,
+    double learning_rate, double scale
+){
+    BasicUpdateParams<T> update_params = {};
+    update_params.lr = learning_rate;
+    update_params.scale = scale;
+    sgd_update_relaxed(n, update_params, params, grads);
+}
+
+
+template<typename T>
+BasicMomentum<T>::BasicMomentum(double momentum, bool nesterov){
+    this->optimizer_type = nesterov ? OptimizerType::NESTEROV : OptimizerType::MOMENTUM;
+    m_momentum = momentum;
+}
+
+template<typename T>
+void BasicMomentum<T>::init(long int num_params){
+    if(static_cast<long int>(m_velocity.size()) != num_params){
+        m_velocity.assign(num_params, 0);
+    }
+}
+
+template<typename T>
+int BasicMomentum<T>::state_size(){
+    return 1;
+}
+
+template<typename T>
+void BasicMomentum<T>::update(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale){
+    BasicUpdateParams<T> update_params = {};
+    update_params.lr = learning_rate;
+    update_params.scale = scale;
+    update_params.beta1 = m_momentum;
+
+    T* velocity = m_velocity.data() + state_offset;
+    if(this->optimizer_type == OptimizerType::NESTEROV){
+        get_kernels<T>().nesterov_update(n, update_params, params, grads, velocity);
+    } else{
+        get_kernels<T>().momentum_update(n, update_params, params, grads, velocity);
+    }
+}
+
+template<typename T>
+void BasicMomentum<T>::update_relaxed(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale){
+    BasicUpdateParams<T> update_params = {};
+    update_params.lr = learning_rate;
+    update_params.scale = scale;
+    update_params.beta1 = m_momentum;
+
+    T* velocity = m_velocity.data() + state_offset;
+    if(this->optimizer_type == OptimizerType::NESTEROV){
+        nesterov_update_relaxed(n, update_params, params, grads, velocity);
+    } else{
+        momentum_update_relaxed(n, update_params, params, grads, velocity);
+    }
+}
+
+
+template<typename T>
+BasicNesterov<T>::BasicNesterov(double momentum) : BasicMomentum<T>(momentum, true){}
+
+
+template<typename T>
+BasicAdam<T>::BasicAdam(double beta1, double beta2, double eps, double weight_decay) : m_step(0){
+    this->optimizer_type = weight_decay != 0 ? OptimizerType::ADAMW : OptimizerType::ADAM;
+    m_beta1 = beta1;
+    m_beta2 = beta2;
+    m_eps = eps;
+    m_weight_decay = weight_decay;
+}
+
+template<typename T>
+void BasicAdam<T>::init(long int num_params){
+    if(static_cast<long int>(m_first_moment.size()) != num_params){
+        m_first_moment.assign(num_params, 0);
+        m_second_moment.assign(num_params, 0);
+        m_step = 0;
+    }
+}
+
+template<typename T>
+int BasicAdam<T>::state_size(){
+    return 2;
+}
+
+template<typename T>
+void BasicAdam<T>::begin_step(){
+    m_step.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename T>
+BasicUpdateParams<T> BasicAdam<T>::update_params(double learning_rate, double scale){
+    // Without a call to begin_step the moments are treated as
+    // those of the first step
+    long int step = std::max(m_step.load(std::memory_order_relaxed), 1L);
+
+    BasicUpdateParams<T> update_params;
+    update_params.lr = learning_rate;
+    update_params.scale = scale;
+    update_params.beta1 = m_beta1;
+    update_params.beta2 = m_beta2;
+    update_params.eps = m_eps;
+    update_params.weight_decay = m_weight_decay;
+    update_params.bias_correction1 = 1 - std::pow(m_beta1, step);
+    update_params.bias_correction2 = 1 - std::pow(m_beta2, step);
+    return update_params;
+}
+
+template<typename T>
+void BasicAdam<T>::update(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale){
+    get_kernels<T>().adam_update(n, update_params(learning_rate, scale), params, grads,
+        m_first_moment.data() + state_offset, m_second_moment.data() + state_offset);
+}
+
+template<typename T>
+void BasicAdam<T>::update_relaxed(long int state_offset, int n, T* params, T* grads, double learning_rate, double scale){
+    adam_update_relaxed(n, update_params(learning_rate, scale), params, grads,
+        m_first_moment.data() + state_offset, m_second_moment.data() + state_offset);
+}
+
+
+template<typename T>
+BasicAdamW<T>::BasicAdamW(double weight_decay, double beta1, double beta2, double eps)
+    : BasicAdam<T>(beta1, beta2, eps, weight_decay){
+    this->optimizer_type = OptimizerType::ADAMW;
+}
+
+template class BasicSGD<float>;
+template class BasicSGD<double>;
+template class BasicMomentum<float>;
+template class BasicMomentum<double>;
+template class BasicNesterov<float>;
+template class BasicNesterov<double>;
+template class BasicAdam<float>;
+template class BasicAdam<double>;
+template class BasicAdamW<float>;
+template class BasicAdamW<double>;
@@ -3,26 +3,73 @@
 #include "layers.hpp"
 #include "data_loaders.hpp"
 #include "model_storage.hpp"
+#include "gemm.hpp"
 #include "utils.hpp"
+#include "trace.hpp"
 
 #include <vector>
 #include <chrono>
 #include <algorithm>
 #include <map>
+#include <stdexcept>
+#include <mutex>
+#include <atomic>
+
+template<typename T>
+BasicPlainNN<T>::BasicPlainNN(int num_threads): m_lr_scheduler(nullptr){
+    m_thread_pool = new ThreadPool(num_threads);
+    m_loss = new BasicMSE<T>();
+    m_optimizer = new BasicSGD<T>();
+    m_profiler = nullptr;
+    m_training_strategy = TrainingStrategy::SYNCHRONOUS;
+    m_inference_plan.max_batch_size = 0;
+}
+
+template<typename T>
+BasicPlainNN<T>::~BasicPlainNN(){
+    delete m_thread_pool;
+    delete m_loss;
+    delete m_optimizer;
+    delete m_profiler;
+}
+
+template<typename T>
+void BasicPlainNN<T>::set_num_threads(int num_threads){
+    if(num_threads == m_thread_pool->size()) return;
+
+    ThreadPool* thread_pool = new ThreadPool(num_threads);
+    delete m_thread_pool;
+    m_thread_pool = thread_pool;
+}
+
+template<typename T>
+int BasicPlainNN<T>::num_threads(){
+    return m_thread_pool->size();
+}
+
+template<typename T>
+void BasicPlainNN<T>::set_training_strategy(TrainingStrategy strategy){
+    m_training_strategy = strategy;
+}
 
-PlainNN::PlainNN(){}
+template<typename T>
+TrainingStrategy BasicPlainNN<T>::training_strategy(){
+    return m_training_strategy;
+}
 
-void PlainNN::add_layer(Layer* layer){
+template<typename T>
+void BasicPlainNN<T>::add_layer(BasicLayer<T>* layer){
     if(m_layers.size() == 0 && layer->layer_type != LayerType::INPUT){
         std::printf("First layer must be an input layer\n");
         exit(1);
     }
 
     m_layers.push_back(layer);
+    m_inference_plan.workspaces.clear();
 
     if(!m_layers.back()->is_initialized){
         if(m_layers.back()->layer_type == LayerType::DENSE){
-            Dense* dense_layer = dynamic_cast<Dense*>(m_layers.back());
+            BasicDense<T>* dense_layer = dynamic_cast<BasicDense<T>*>(m_layers.back());
             
             // TODO: assert that the output shape of the previous layer
             // is the same as the input shape of the current layer
@@ -30,35 +77,115 @@ void PlainNN::add_layer(Layer* layer){
             dense_layer->initialize({m_layers[m_layers.size()-2]->output.shape().back()});
         }
     }
+
+    bind_params();
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::bind_params(){
+    // Each layer starts on an aligned boundary, the padding
+    // is left to 0 and is never read by the layers
+    m_param_offsets.assign(m_layers.size(), 0);
+    long int num_params = 0;
+    for(size_t layer_idx = 0; layer_idx < m_layers.size(); layer_idx++){
+        m_param_offsets[layer_idx] = num_params;
+        num_params += align_count<T>(m_layers[layer_idx]->get_summary().param_count);
+    }
+
+    // The layers copy their values from the previous arenas,
+    // which are released only once all of them are moved
+    BasicAlignedBuffer<T> params, grads;
+    params.allocate(num_params);
+    grads.allocate(num_params);
+    for(size_t layer_idx = 0; layer_idx < m_layers.size(); layer_idx++){
+        m_layers[layer_idx]->bind_params(params.data() + m_param_offsets[layer_idx], grads.data() + m_param_offsets[layer_idx]);
+    }
+    m_params = std::move(params);
+    m_grads = std::move(grads);
+
+    // The workspaces view the previous layout
+    m_workers.clear();
+
+    std::vector<std::string> names, types;
+    layer_names(names, types);
+    m_trace_names.resize(m_layers.size() * NUM_LAYER_SECTIONS);
+    for(size_t layer_idx = 0; layer_idx < m_layers.size(); layer_idx++){
+        for(int section = 0; section < NUM_LAYER_SECTIONS; section++){
+            m_trace_names[layer_idx * NUM_LAYER_SECTIONS + section] = Tracer::intern(
+                names[layer_idx] + "." + string_to_lower(PROFILE_SECTION_NAMES[section]));
+        }
+    }
+}
+
+
+template<typename T>
+BasicTensor<T> BasicPlainNN<T>::parameters(){
+    return BasicTensor<T>({static_cast<int>(m_params.size())}, m_params.data());
 }
 
 
-Layer* PlainNN::get_layer(int index){
+template<typename T>
+BasicTensor<T> BasicPlainNN<T>::gradients(){
+    return BasicTensor<T>({static_cast<int>(m_grads.size())}, m_grads.data());
+}
+
+
+template<typename T>
+BasicLayer<T>* BasicPlainNN<T>::get_layer(int index){
     return m_layers[index];
 }
 
 
-void PlainNN::freeze_layer(int index, bool freeze){
+template<typename T>
+void BasicPlainNN<T>::freeze_layer(int index, bool freeze){
     m_layers[index]->is_frozen = freeze;
 }
 
 
-void PlainNN::set_lr_scheduler(LRScheduler* scheduler){
+template<typename T>
+void BasicPlainNN<T>::set_lr_scheduler(LRScheduler* scheduler){
     m_lr_scheduler = scheduler;
 }
 
 
-void PlainNN::summary(){
-    std::printf("___________________________________________________________\n");
-    std::printf("%-12s %-12s %-15s %15s\n", "Layer", "(Type)", "Output Shape", "Param #");
-    std::printf("===========================================================\n");
+template<typename T>
+void BasicPlainNN<T>::set_loss(BasicLoss<T>* loss){
+    if(loss == m_loss) return;
+    delete m_loss;
+    m_loss = loss;
+}
+
+
+template<typename T>
+BasicLoss<T>* BasicPlainNN<T>::loss(){
+    return m_loss;
+}
 
-    int total_param_count = 0;
+
+template<typename T>
+void BasicPlainNN<T>::set_optimizer(BasicOptimizer<T>* optimizer){
+    if(optimizer == m_optimizer) return;
+    delete m_optimizer;
+    m_optimizer = optimizer;
+}
+
+
+template<typename T>
+BasicOptimizer<T>* BasicPlainNN<T>::optimizer(){
+    return m_optimizer;
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::layer_names(std::vector<std::string>& names, std::vector<std::string>& types){
+    names.clear();
+    types.clear();
 
     std::map<int, int> encountered_layers;
 
     for(size_t i = 0; i < m_layers.size(); i++){
-        Layer* layer = m_layers[i];
+        BasicLayer<T>* layer = m_layers[i];
 
         LayerSummary summary = layer->get_summary();
 
@@ -72,8 +199,40 @@ void PlainNN::summary(){
             layer_name += string_to_lower(summary.layer_name) + "_" + std::to_string(encountered_layers[summary.layer_type]-1);
         }
 
-        std::string layer_type = "(" + layer->name() + ")";
-        std::string output_shape = layer->output.shape_str();
+        names.push_back(layer_name);
+        types.push_back("(" + layer->name() + ")");
+    }
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::summary(int batch_size){
+    std::vector<LayerCost> costs = layer_costs(batch_size);
+
+    std::printf("__________________________________________________________________________________________\n");
+    std::printf("%-12s %-12s %-15s %12s %11s %11s %11s\n", "Layer", "(Type)", "Output Shape", "Param #", "Fwd FLOPs", "Bwd FLOPs", "Act. Mem");
+    std::printf("==========================================================================================\n");
+
+    int total_param_count = 0;
+    int trainable_param_count = 0;
+    LayerCost total = {};
+    int state_size = m_optimizer->state_size();
+
+    std::vector<std::string> names, types;
+    layer_names(names, types);
+
+    size_t buff_size = 16;
+    char forward_buff[buff_size], backward_buff[buff_size], activation_buff[buff_size];
+
+    for(size_t i = 0; i < m_layers.size(); i++){
+        BasicLayer<T>* layer = m_layers[i];
+
+        LayerSummary summary = layer->get_summary();
+        LayerCost& cost = costs[i];
+
+        // The output shape is reported per sample, regardless of the
+        // batch size used by the last forward pass
+        std::string output_shape = "(" + std::to_string(summary.layer_shape.back()) + ")";
 
         int num_params = 0;
 
@@ -81,27 +240,127 @@ void PlainNN::summary(){
 
         if(summary.layer_name.compare(LAYER_TYPE_NAMES[LayerType::INPUT]) != 0){
             total_param_count += num_params;
+            if(cost.trainable) trainable_param_count += num_params;
         }
 
-        std::printf("%-12s %-12s %-15s %15d\n", layer_name.c_str(), layer_type.c_str(), output_shape.c_str(), num_params);
+        total.forward_flops += cost.forward_flops;
+        total.backward_flops += cost.backward_flops;
+        total.activation_bytes += cost.activation_bytes;
+        total.gradient_bytes += cost.gradient_bytes;
+        total.optimizer_bytes += cost.optimizer_bytes;
+        total.bytes_per_sample += cost.bytes_per_sample;
+
+        count_to_readable(cost.forward_flops, forward_buff, buff_size);
+        count_to_readable(cost.backward_flops, backward_buff, buff_size);
+        count_to_readable(cost.activation_bytes, activation_buff, buff_size, true);
+        std::printf("%-12s %-12s %-15s %12d %11s %11s %11s\n", names[i].c_str(), types[i].c_str(), output_shape.c_str(), num_params,
+            forward_buff, backward_buff, activation_buff);
     }
 
-    std::printf("===========================================================\n");
+    std::printf("==========================================================================================\n");
 
     int params_buff_size = 32;
     char trainable_params_buff[params_buff_size], non_trainable_params_buff[params_buff_size], total_params_buff[params_buff_size];
-    count_to_size(total_param_count, total_params_buff, params_buff_size, sizeof(double));
-    count_to_size(total_param_count, trainable_params_buff, params_buff_size, sizeof(double));
-    count_to_size(0, non_trainable_params_buff, params_buff_size, sizeof(double));
+    count_to_size(total_param_count, total_params_buff, params_buff_size, sizeof(T));
+    count_to_size(trainable_param_count, trainable_params_buff, params_buff_size, sizeof(T));
+    count_to_size(total_param_count - trainable_param_count, non_trainable_params_buff, params_buff_size, sizeof(T));
 
     std::printf("Total params: %s\n", total_params_buff);
     std::printf("Trainable params: %s\n", trainable_params_buff);
     std::printf("Non-trainable params: %s\n", non_trainable_params_buff);
-    std::printf("___________________________________________________________\n");
+    std::printf("__________________________________________________________________________________________\n");
+
+    char moved_buff[buff_size], gradient_buff[buff_size], optimizer_buff[buff_size];
+    count_to_readable(total.forward_flops, forward_buff, buff_size);
+    count_to_readable(total.backward_flops, backward_buff, buff_size);
+    count_to_readable(total.activation_bytes, activation_buff, buff_size, true);
+    count_to_readable(total.bytes_per_sample, moved_buff, buff_size, true);
+    count_to_readable(total.gradient_bytes, gradient_buff, buff_size, true);
+    count_to_readable(total.optimizer_bytes, optimizer_buff, buff_size, true);
+
+    std::printf("Training cost per sample, batch size %d:\n", batch_size);
+    std::printf("    Forward FLOPs: %s\n", forward_buff);
+    std::printf("    Backward FLOPs: %s\n", backward_buff);
+    std::printf("    Activation memory: %s\n", activation_buff);
+    std::printf("    Bytes moved (estimate): %s\n", moved_buff);
+    std::printf("Gradient memory: %s\n", gradient_buff);
+    std::printf("Optimizer state memory (%s, %d per param): %s\n", m_optimizer->name().c_str(), state_size, optimizer_buff);
+    std::printf("__________________________________________________________________________________________\n");
 }
 
 
-void PlainNN::save(std::string file_name, bool weights_only){
+template<typename T>
+std::vector<LayerCost> BasicPlainNN<T>::layer_costs(int batch_size){
+    if(batch_size < 1){
+        throw std::runtime_error("Batch size must be at least 1, got " + std::to_string(batch_size));
+    }
+
+    // As set by train, the derivative of the output activation
+    // is skipped when the loss is fused with it
+    if(!m_layers.empty()){
+        BasicLayer<T>* output_layer = m_layers.back();
+        output_layer->fused_output_grad = m_loss->fuses_with(output_layer->activation_type());
+    }
+
+    std::vector<LayerCost> costs;
+    int state_size = m_optimizer->state_size();
+    bool input_grads = false;
+    for(size_t layer_idx = 0; layer_idx < m_layers.size(); layer_idx++){
+        LayerCost cost = m_layers[layer_idx]->get_cost(batch_size, input_grads);
+
+        // The update reads and writes the parameters, the
+        // gradients and the state of the optimizer once per step
+        if(cost.trainable){
+            cost.optimizer_bytes = cost.param_count * state_size * sizeof(T);
+            cost.bytes_per_sample += (4.0 + 2 * state_size) * cost.param_count * sizeof(T) / batch_size;
+        }
+
+        // The backward pass of a trainable layer propagates
+        // the gradients to the input of the next one
+        input_grads = layer_idx > 0 && cost.trainable;
+        costs.push_back(cost);
+    }
+    return costs;
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::enable_profiling(bool enable){
+    if(enable && m_profiler == nullptr){
+        m_profiler = new Profiler();
+    } else if(!enable){
+        delete m_profiler;
+        m_profiler = nullptr;
+    }
+}
+
+
+template<typename T>
+Profiler* BasicPlainNN<T>::profiler(){
+    return m_profiler;
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::print_profile(int epoch){
+    if(m_profiler == nullptr){
+        throw std::runtime_error("Profiling is not enabled, call enable_profiling before training");
+    }
+    if(epoch >= static_cast<int>(m_profiler->epochs().size())){
+        throw std::runtime_error("No profile for epoch " + std::to_string(epoch) + ", the last training run has "
+            + std::to_string(m_profiler->epochs().size()) + " epochs");
+    }
+
+    std::vector<std::string> names, types;
+    layer_names(names, types);
+
+    EpochProfile profile = epoch < 0 ? m_profiler->total() : m_profiler->epochs()[epoch];
+    Profiler::print(profile, names, types);
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::save(std::string file_name, bool weights_only){
     if (!weights_only)
     {
         std::vector<LayerSummary> layer_summaries;
@@ -111,7 +370,7 @@ void PlainNN::save(std::string file_name, bool weights_only){
         ModelStorage::save_model_arch(file_name, layer_summaries);
     }
 
-    std::vector<std::vector<double>> weights;
+    std::vector<std::vector<T> > weights;
 
     for(size_t i = 0; i < m_layers.size(); i++){
         weights.push_back(m_layers[i]->get_saveable_params());
@@ -121,7 +380,8 @@ void PlainNN::save(std::string file_name, bool weights_only){
 }
 
 
-void PlainNN::load(std::string file_name, bool weights_only){
+template<typename T>
+void BasicPlainNN<T>::load(std::string file_name, bool weights_only){
     if(!weights_only){
 
         ModelStorage::load_model_arch(file_name, *this);
@@ -133,72 +393,187 @@ void PlainNN::load(std::string file_name, bool weights_only){
 }
 
 
-Tensor PlainNN::forward(Tensor& input){
-    Tensor output = input;
+template<typename T>
+BasicTensor<T> BasicPlainNN<T>::forward(BasicTensor<T>& input){
+    BasicTensor<T>* output = &input;
 
+    // Each layer reads the output buffer of the previous one,
+    // only the final output is copied
     for(size_t i = 1; i < m_layers.size(); i++){
-        output = m_layers[i]->forward(output);
+        output = &m_layers[i]->forward(*output);
     }
 
-    return output;
+    return *output;
 }
 
 
-EvaluationResult PlainNN::evaluate(DataLoader& dataloader, bool show_output, bool indent){
-    int correct = 0;
-    int total_steps = dataloader.steps_per_epoch(1);
-    double accuracy = 0, loss = 0, tmp_loss = 0;
+template<typename T>
+void BasicPlainNN<T>::compile(int max_batch_size){
+    m_inference_plan = create_inference_plan(max_batch_size);
+
+    // A first pass grows the packing buffers of the matrix
+    // products on this thread to their final size
+    predict(m_inference_plan.workspaces[0].output);
+}
+
+
+template<typename T>
+BasicTensor<T>& BasicPlainNN<T>::predict(BasicTensor<T>& input){
+    if(m_inference_plan.workspaces.empty()){
+        throw std::runtime_error("Model must be compiled before calling predict");
+    }
+
+    return predict(input, m_inference_plan);
+}
+
+
+template<typename T>
+BasicInferencePlan<T> BasicPlainNN<T>::create_inference_plan(int max_batch_size){
+    if(m_layers.size() < 2){
+        throw std::runtime_error("Model must have at least one layer after the input layer to be compiled");
+    }
+    if(max_batch_size < 1){
+        throw std::runtime_error("Maximum batch size must be at least 1, got " + std::to_string(max_batch_size));
+    }
+
+    BasicInferencePlan<T> plan;
+    plan.max_batch_size = max_batch_size;
+    plan.workspaces.resize(m_layers.size());
+
+    // Only the outputs are needed for inference, the gradient
+    // buffers of the workspaces are left empty
+    for(size_t layer_idx = 0; layer_idx < m_layers.size(); layer_idx++){
+        int output_size = m_layers[layer_idx]->output.shape().back();
+        if(max_batch_size == 1) plan.workspaces[layer_idx].output = BasicTensor<T>({output_size});
+        else plan.workspaces[layer_idx].output = BasicTensor<T>({max_batch_size, output_size});
+    }
+
+    return plan;
+}
+
+
+template<typename T>
+BasicTensor<T>& BasicPlainNN<T>::predict(BasicTensor<T>& input, BasicInferencePlan<T>& plan){
+    if(plan.workspaces.size() != m_layers.size()){
+        throw std::runtime_error("Inference plan does not match the layers of the model, it must be created again after the model is modified");
+    }
+
+    int batch_size = input.ndim() > 1 ? input.shape(0) : 1;
+    if(batch_size > plan.max_batch_size){
+        throw std::runtime_error("Batch of " + std::to_string(batch_size) + " samples exceeds the maximum batch size of the plan, " + std::to_string(plan.max_batch_size));
+    }
+
+    TraceScope scope("predict", "inference");
+
+    BasicTensor<T>* output = &input;
+    for(size_t layer_idx = 1; layer_idx < m_layers.size(); layer_idx++){
+        TraceScope layer_scope(m_trace_names[layer_idx * NUM_LAYER_SECTIONS + PROFILE_FORWARD], "layer");
+        output = &m_layers[layer_idx]->forward(*output, plan.workspaces[layer_idx]);
+    }
+
+    return *output;
+}
+
+
+template<typename T>
+int BasicPlainNN<T>::input_size(){
+    if(m_layers.empty()){
+        throw std::runtime_error("Model has no input layer");
+    }
+    return m_layers.front()->output.shape().back();
+}
+
+
+template<typename T>
+int BasicPlainNN<T>::output_size(){
+    if(m_layers.empty()){
+        throw std::runtime_error("Model has no layers");
+    }
+    return m_layers.back()->output.shape().back();
+}
+
+
+template<typename T>
+EvaluationResult BasicPlainNN<T>::evaluate(BasicDataLoader<T>& dataloader, bool show_output, bool indent){
+    return evaluate(dataloader, 1, show_output, indent);
+}
+
+
+template<typename T>
+EvaluationResult BasicPlainNN<T>::evaluate(BasicDataLoader<T>& dataloader, int batch_size, bool show_output, bool indent){
+    if(batch_size < 1){
+        throw std::runtime_error("Evaluation batch size must be at least 1, got " + std::to_string(batch_size));
+    }
+
+    TraceScope scope("evaluate", "evaluate");
+
+    int num_classes = dataloader.num_classes();
+    int total_steps = dataloader.steps_per_epoch(batch_size);
+    int total = 0;
+
+    // The workspaces are kept if the model already trained with these threads
+    if(m_workers.size() != static_cast<size_t>(m_thread_pool->size()) || m_workers[0].workspaces.size() != m_layers.size()){
+        init_workers();
+    }
+    for(size_t worker_idx = 0; worker_idx < m_workers.size(); worker_idx++){
+        m_workers[worker_idx].error = 0;
+        m_workers[worker_idx].correct = 0;
+        m_workers[worker_idx].loss_per_class.assign(num_classes, 0);
+    }
 
     auto running_s_time = std::chrono::system_clock::now();
     auto step_s_time = std::chrono::system_clock::now();
 
     size_t time_buff_size = 24;
     char step_time_buff[time_buff_size], running_time_buff[time_buff_size];
-
-    std::vector<double> loss_per_class(dataloader.num_classes(), 0);
     
+    BasicBatchData<T> batch;
+
     char message_buff[128];
     for(int step = 0; step < total_steps; step++){
 
         step_s_time = std::chrono::system_clock::now();
 
-        BatchData batch = dataloader.get_batch(1);
-        if(batch.input_data.size() == 0){
+        TraceScope step_scope("evaluate_step", "evaluate");
+        {
+            TraceScope loader_scope("fill_batch", "loader");
+            dataloader.fill_batch(batch_size, batch);
+        }
+        if(batch.size() == 0){
             // If the batch is empty, it means that the dataloader has reached the end of the dataset
             continue;
         }
 
-        // we are sampling only one element at a time
-        Tensor input = batch.input_data[0];
-        Tensor target_one_hot = batch.targets_one_hot[0];
-        int target = batch.targets_idx[0];
-
-        Tensor output = forward(input);
-
-        double *_output = output.data();
-        double *_target_one_hot = target_one_hot.data();
+        int batch_rows = batch.size();
+        int num_workers = std::min(static_cast<int>(m_workers.size()), batch_rows);
+        int rows_per_worker = (batch_rows + num_workers - 1) / num_workers;
+        num_workers = (batch_rows + rows_per_worker - 1) / rows_per_worker;
 
-        int output_size = output.size();
-
-        int max_idx = 0;
-        for(int i=0; i<output_size; i++){
-            if(_output[max_idx] < _output[i]){
-                max_idx = i;
-            }
-        }
-
-        if(max_idx == target){
-            correct++;
-        }
-
-        for(int i = 0; i < output_size; i++){
-            tmp_loss = 0.5 * std::pow(_output[i] - _target_one_hot[i], 2);
-            loss += tmp_loss;
-            loss_per_class[i] += tmp_loss;
+        if(num_workers == 1){
+            evaluate_worker(m_workers[0], batch.input_data, batch.targets_one_hot.data(), batch.targets_idx.data());
+        } else{
+            m_thread_pool->run(num_workers, [&](int worker_idx){
+                WorkerState& worker = m_workers[worker_idx];
+                int start = worker_idx * rows_per_worker;
+                int end = std::min(start + rows_per_worker, batch_rows);
+
+                // The worker reads its rows of the batch in place
+                worker.input = batch.input_data.slice(start, end);
+                evaluate_worker(worker, worker.input,
+                    batch.targets_one_hot.data() + start * num_classes, batch.targets_idx.data() + start);
+            });
         }
+        total += batch_rows;
 
         if(show_output){
 
+            double loss = 0;
+            int correct = 0;
+            for(size_t worker_idx = 0; worker_idx < m_workers.size(); worker_idx++){
+                loss += m_workers[worker_idx].error;
+                correct += m_workers[worker_idx].correct;
+            }
+
             auto step_e_time = std::chrono::system_clock::now();
 
             std::chrono::duration<double> step_duration = step_e_time - step_s_time;
@@ -208,7 +583,7 @@ EvaluationResult PlainNN::evaluate(DataLoader& dataloader, bool show_output, boo
             make_duration_readable(running_duration, running_time_buff, time_buff_size);
 
             std::sprintf(message_buff, "Loss: %.04f - Accuracy: %.04f - %s elapsed - %s/step", 
-                loss/(step+1), (double)correct/(step+1), running_time_buff, step_time_buff);
+                loss/total, (double)correct/total, running_time_buff, step_time_buff);
             print_progress(step+1, total_steps, message_buff, 20, indent);
         }
     }
@@ -216,50 +591,67 @@ EvaluationResult PlainNN::evaluate(DataLoader& dataloader, bool show_output, boo
         printf("\n");
     }
 
-    accuracy = (double)correct / total_steps;
+    // The accumulators of the workers are merged in a fixed
+    // order, the result does not depend on the scheduling
+    double loss = 0;
+    int correct = 0;
+    std::vector<double> loss_per_class(num_classes, 0);
+    for(size_t worker_idx = 0; worker_idx < m_workers.size(); worker_idx++){
+        WorkerState& worker = m_workers[worker_idx];
+        loss += worker.error;
+        correct += worker.correct;
+        for(int i = 0; i < num_classes; i++){
+            loss_per_class[i] += worker.loss_per_class[i];
+        }
+    }
+
+    double accuracy = total > 0 ? (double)correct / total : 0;
 
-    std::for_each(loss_per_class.begin(), loss_per_class.end(), [total_steps](double& loss){
-        loss /= total_steps;
+    std::for_each(loss_per_class.begin(), loss_per_class.end(), [total](double& loss){
+        loss /= std::max(total, 1);
     });
 
     // Reset the dataloader to the beginning of the dataset
     dataloader.new_epoch();
 
     return EvaluationResult{
-        correct, total_steps, accuracy,
-        loss/total_steps,
+        correct, total, accuracy,
+        loss/std::max(total, 1),
         loss_per_class};
 }
 
 
-void PlainNN::train(
-    DataLoader& train_dataloader,
+template<typename T>
+TrainingStats BasicPlainNN<T>::train(
+    BasicDataLoader<T>& train_dataloader,
     double learning_rate,
     int epochs,
     int batch_size,
     bool save_checkpoint,
     std::string checkpoint_path
 ){
-    _train(&train_dataloader, nullptr, learning_rate, epochs, batch_size, save_checkpoint, checkpoint_path);
+    return _train(&train_dataloader, nullptr, learning_rate, epochs, batch_size, save_checkpoint, checkpoint_path);
 }
 
 
-void PlainNN::train(
-    DataLoader& train_dataloader,
-    DataLoader& test_dataloader,
+template<typename T>
+TrainingStats BasicPlainNN<T>::train(
+    BasicDataLoader<T>& train_dataloader,
+    BasicDataLoader<T>& test_dataloader,
     double learning_rate,
     int epochs,
     int batch_size,
     bool save_checkpoint,
     std::string checkpoint_path
 ){
-    _train(&train_dataloader, &test_dataloader, learning_rate, epochs, batch_size, save_checkpoint, checkpoint_path);
+    return _train(&train_dataloader, &test_dataloader, learning_rate, epochs, batch_size, save_checkpoint, checkpoint_path);
 }
 
 
-void PlainNN::_train(
-    DataLoader* train_dataloader,
-    DataLoader* test_dataloader,
+template<typename T>
+TrainingStats BasicPlainNN<T>::_train(
+    BasicDataLoader<T>* train_dataloader,
+    BasicDataLoader<T>* test_dataloader,
     double learning_rate,
     int epochs,
     int batch_size,
@@ -277,113 +669,430 @@ void PlainNN::_train(
     }
 
     int steps_per_epoch = train_dataloader->steps_per_epoch(batch_size);
+
+    BasicLayer<T>* output_layer = m_layers.back();
+    output_layer->fused_output_grad = m_loss->fuses_with(output_layer->activation_type());
+
+    init_workers();
+
+    // The state of the optimizer is laid out like the parameters, when
+    // no layer is frozen a single update sweeps the whole arena. The
+    // profiler times the update of each layer, which then updates
+    // its own range of the arena
+    m_optimizer->init(m_params.size());
+    bool update_all = m_profiler == nullptr;
+    for(size_t layer_idx = 1; layer_idx < m_layers.size(); layer_idx++){
+        if(m_layers[layer_idx]->is_frozen) update_all = false;
+    }
+
+    if(m_profiler != nullptr){
+        m_profiler->start(m_layers.size(), m_workers.size());
+    }
+
+    long int total_samples = 0;
+    double train_time = 0;
+    double loader_time = 0;
     
-    char trailing_message_buff[128];
+    char trailing_message_buff[160];
     size_t time_buff_size = 24;
     char epoch_running_time_buff[time_buff_size], step_time_buff[time_buff_size];
 
+    // Filled in place at every step, its buffers are reused
+    BasicBatchData<T> batch;
+
     for(int epoch=0; epoch < epochs; epoch++){
+        TraceScope epoch_scope("epoch", "train");
 
         auto epoch_s_time = std::chrono::system_clock::now();
+        long int epoch_samples = 0;
         std::printf("Epoch %d/%d\n", epoch+1, epochs);
 
-        for(int step = 0; step<steps_per_epoch; step++){
+        if(m_training_strategy == TrainingStrategy::HOGWILD){
 
-            auto step_s_time = std::chrono::system_clock::now();
+            epoch_samples = train_epoch_hogwild(train_dataloader, learning_rate, batch_size, steps_per_epoch, loader_time);
+
+            std::chrono::duration<double> epoch_duration = std::chrono::system_clock::now() - epoch_s_time;
+            train_time += epoch_duration.count();
+            total_samples += epoch_samples;
+        } else{
+            for(int step = 0; step<steps_per_epoch; step++){
+
+                TraceScope step_scope("step", "train");
+                auto step_s_time = std::chrono::system_clock::now();
+                Profiler::Clock::time_point profile_s_time;
+                if(m_profiler != nullptr) profile_s_time = Profiler::Clock::now();
             
-            BatchData batch = train_dataloader->get_batch(batch_size);
+                {
+                    TraceScope loader_scope("fill_batch", "loader");
+                    train_dataloader->fill_batch(batch_size, batch);
+                }
 
-            if(batch.input_data.size() == 0){
-                // If the batch is empty, it means that the dataloader has reached the end of the dataset
-                continue;
+                std::chrono::duration<double> loader_duration = std::chrono::system_clock::now() - step_s_time;
+                loader_time += loader_duration.count();
+                if(m_profiler != nullptr) m_profiler->record(0, PROFILE_LOADER, profile_s_time);
+
+                if(batch.size() == 0){
+                    // If the batch is empty, it means that the dataloader has reached the end of the dataset
+                    continue;
+                }
+
+                // The batch is split in contiguous chunks of samples, one per
+                // worker, each chunk being processed as a single sub-batch
+                int batch_rows = batch.size();
+                int num_workers = std::min(static_cast<int>(m_workers.size()), batch_rows);
+                int rows_per_worker = (batch_rows + num_workers - 1) / num_workers;
+                num_workers = (batch_rows + rows_per_worker - 1) / rows_per_worker;
+
+                m_thread_pool->run(num_workers, [&](int worker_idx){
+                    TraceScope worker_scope("train_worker", "train");
+                    WorkerState& worker = m_workers[worker_idx];
+                    int start = worker_idx * rows_per_worker;
+                    int end = std::min(start + rows_per_worker, batch_rows);
+
+                    // The worker reads its rows of the batch in place, the
+                    // targets are overwritten by the error signal of the loss
+                    worker.input = batch.input_data.slice(start, end);
+                    worker.targets = batch.targets_one_hot.slice(start, end);
+                    worker.targets_idx.assign(batch.targets_idx.begin() + start, batch.targets_idx.begin() + end);
+
+                    train_worker(worker);
+                });
+
+                if(m_profiler != nullptr) profile_s_time = Profiler::Clock::now();
+                reduce_gradients(num_workers);
+                if(m_profiler != nullptr) m_profiler->record(0, PROFILE_REDUCE, profile_s_time);
+
+                double error = 0;
+                int correct = 0;
+                for(int worker_idx = 0; worker_idx < num_workers; worker_idx++){
+                    error += m_workers[worker_idx].error;
+                    correct += m_workers[worker_idx].correct;
+                }
+
+                {
+                    TraceScope update_scope("update", "train");
+                    m_optimizer->begin_step();
+                    if(update_all){
+                        m_optimizer->update(0, m_params.size(), m_params.data(), m_grads.data(), learning_rate, 1.0 / batch_size);
+                    } else{
+                        for(size_t layer_idx = 1; layer_idx < m_layers.size(); layer_idx++){
+                            if(m_layers[layer_idx]->is_frozen){
+                                continue;
+                            }
+                            TraceScope layer_scope(m_trace_names[layer_idx * NUM_LAYER_SECTIONS + PROFILE_UPDATE], "layer");
+                            if(m_profiler != nullptr) profile_s_time = Profiler::Clock::now();
+                            m_layers[layer_idx]->step(*m_optimizer, m_param_offsets[layer_idx], learning_rate, batch_size);
+                            if(m_profiler != nullptr) m_profiler->record(0, layer_idx, PROFILE_UPDATE, profile_s_time);
+                        }
+                    }
+                }
+                if(m_profiler != nullptr) m_profiler->count_step(0);
+
+                auto step_e_time = std::chrono::system_clock::now();
+                std::chrono::duration<double> step_duration = step_e_time - step_s_time;
+                std::chrono::duration<double> running_epoch_time = step_e_time - epoch_s_time;
+                train_time += step_duration.count();
+                total_samples += batch_rows;
+                epoch_samples += batch_rows;
+            
+                make_duration_readable(step_duration, step_time_buff, time_buff_size);
+                make_duration_readable(running_epoch_time, epoch_running_time_buff, time_buff_size);
+
+                std::sprintf(trailing_message_buff, "%s %s/step - %.0f samples/s - Error: %.04f - Accuracy: %.04f", 
+                    epoch_running_time_buff, step_time_buff, epoch_samples / running_epoch_time.count(),
+                    error/batch_size, (double)correct/batch_size);
+                print_progress(step+1, steps_per_epoch, trailing_message_buff, 20);
             }
+        }
+        std::printf("\n");
 
-            std::vector<Tensor> input = batch.input_data;
-            std::vector<Tensor> batch_targets = batch.targets_one_hot;
-            std::vector<int> batch_targets_idx = batch.targets_idx;
+        if(m_profiler != nullptr){
+            std::chrono::duration<double> epoch_duration = std::chrono::system_clock::now() - epoch_s_time;
+            m_profiler->end_epoch(epoch, epoch_duration.count());
+            print_profile(epoch);
+        }
 
-            double error = 0;
-            int correct = 0;
+        train_dataloader->new_epoch();
 
-            for(size_t b = 0; b<input.size(); b++){
+        if(test_dataloader != nullptr){
+            evaluate(*test_dataloader, batch_size, true, true);
+        }
 
-                Tensor output = forward(input[b]);
+        if(m_lr_scheduler != nullptr){
+            m_lr_scheduler->step(learning_rate, epoch);
+        }
 
-                double *_output = output.data();
-                double *_batch_targets = batch_targets[b].data();
+        if(save_checkpoint){
+            char epoch_checkpoint_path[checkpoint_path.size() + std::to_string(epoch+1).size() + 1];
+            std::sprintf(epoch_checkpoint_path, checkpoint_path.c_str(), epoch+1);
+            save(epoch_checkpoint_path);
+        }
+    }
 
-                int output_size = output.size();
+    return TrainingStats{
+        m_thread_pool->size(), total_samples, train_time, loader_time,
+        train_time > 0 ? total_samples / train_time : 0};
+}
 
-                for(int i=0; i<output_size; i++){
-                    error += 0.5 * std::pow(_output[i] - _batch_targets[i], 2);
-                }
 
-                int max_idx = 0;
-                for(int i=0; i<output_size; i++){
-                    if(_output[max_idx] < _output[i]){
-                        max_idx = i;
-                    }
-                }
-                if(max_idx == batch_targets_idx[b]){
-                    correct++;
-                }
-            
-                int last_layer_idx = m_layers.size() - 1;
-                Tensor next_layer_grads = Tensor();
-                for(int layer_idx = last_layer_idx; layer_idx > 0; layer_idx--){
-                    
-                    if(m_layers[layer_idx]->is_frozen){
-                        continue;
-                    }
+template<typename T>
+long int BasicPlainNN<T>::train_epoch_hogwild(
+    BasicDataLoader<T>* train_dataloader,
+    double learning_rate,
+    int batch_size,
+    int steps_per_epoch,
+    double& loader_time
+){
+    // The dataloader is the only shared state that is protected,
+    // the weights are read and updated concurrently by design. The
+    // updates use relaxed atomics, the forward and backward passes
+    // read the weights with plain loads so that they stay vectorized
+    std::mutex dataloader_mutex;
+    std::atomic<int> next_step(0);
+    std::atomic<int> completed_steps(0);
+    std::atomic<long int> epoch_samples(0);
+    std::vector<double> worker_loader_time(m_workers.size(), 0);
+
+    bool update_all = m_profiler == nullptr;
+    for(size_t layer_idx = 1; layer_idx < m_layers.size(); layer_idx++){
+        if(m_layers[layer_idx]->is_frozen) update_all = false;
+    }
 
-                    next_layer_grads = m_layers[layer_idx]->backward(
-                        layer_idx == 1 ? &input[b] : &m_layers[layer_idx-1]->output,
-                        layer_idx == last_layer_idx ? nullptr : m_layers[layer_idx+1]->get_params(),
-                        layer_idx == last_layer_idx ? &batch_targets[b] : &next_layer_grads
-                    );
-                }
+    auto epoch_s_time = std::chrono::system_clock::now();
+
+    m_thread_pool->run(m_workers.size(), [&](int worker_idx){
+        WorkerState& worker = m_workers[worker_idx];
+
+        char trailing_message_buff[160];
+        size_t time_buff_size = 24;
+        char epoch_running_time_buff[time_buff_size], step_time_buff[time_buff_size];
+
+        while(next_step.fetch_add(1, std::memory_order_relaxed) < steps_per_epoch){
+
+            TraceScope step_scope("step", "train");
+            auto step_s_time = std::chrono::system_clock::now();
+            Profiler::Clock::time_point profile_s_time;
+            if(m_profiler != nullptr) profile_s_time = Profiler::Clock::now();
+
+            {
+                TraceScope loader_scope("fill_batch", "loader");
+                std::lock_guard<std::mutex> lock(dataloader_mutex);
+                train_dataloader->fill_batch(batch_size, worker.batch);
             }
 
-            for(size_t layer_idx = 1; layer_idx < m_layers.size(); layer_idx++){
-                if(m_layers[layer_idx]->is_frozen){
-                    continue;
+            // Includes the time spent waiting for the other workers
+            // to release the dataloader
+            std::chrono::duration<double> loader_duration = std::chrono::system_clock::now() - step_s_time;
+            worker_loader_time[worker_idx] += loader_duration.count();
+            if(m_profiler != nullptr) m_profiler->record(worker_idx, PROFILE_LOADER, profile_s_time);
+
+            int batch_rows = worker.batch.size();
+            if(batch_rows == 0){
+                continue;
+            }
+
+            // The worker trains on the whole batch, its buffers are
+            // exchanged with the ones of the worker instead of copied
+            std::swap(worker.input, worker.batch.input_data);
+            std::swap(worker.targets, worker.batch.targets_one_hot);
+            std::swap(worker.targets_idx, worker.batch.targets_idx);
+
+            train_worker(worker);
+
+            {
+                TraceScope update_scope("update", "train");
+                m_optimizer->begin_step();
+                if(update_all){
+                    m_optimizer->update_relaxed(0, m_params.size(), m_params.data(), worker.grads.data(), learning_rate, 1.0 / batch_size);
+                } else{
+                    for(size_t layer_idx = 1; layer_idx < m_layers.size(); layer_idx++){
+                        if(m_layers[layer_idx]->is_frozen){
+                            continue;
+                        }
+                        TraceScope layer_scope(m_trace_names[layer_idx * NUM_LAYER_SECTIONS + PROFILE_UPDATE], "layer");
+                        if(m_profiler != nullptr) profile_s_time = Profiler::Clock::now();
+                        m_layers[layer_idx]->step(*m_optimizer, m_param_offsets[layer_idx], learning_rate, batch_size, worker.workspaces[layer_idx]);
+                        if(m_profiler != nullptr) m_profiler->record(worker_idx, layer_idx, PROFILE_UPDATE, profile_s_time);
+                    }
                 }
-                m_layers[layer_idx]->step(learning_rate, batch_size);
             }
+            if(m_profiler != nullptr) m_profiler->count_step(worker_idx);
+
+            long int samples = epoch_samples.fetch_add(batch_rows, std::memory_order_relaxed) + batch_rows;
+            int step = completed_steps.fetch_add(1, std::memory_order_relaxed) + 1;
 
             auto step_e_time = std::chrono::system_clock::now();
             std::chrono::duration<double> step_duration = step_e_time - step_s_time;
             std::chrono::duration<double> running_epoch_time = step_e_time - epoch_s_time;
-            
+
             make_duration_readable(step_duration, step_time_buff, time_buff_size);
             make_duration_readable(running_epoch_time, epoch_running_time_buff, time_buff_size);
 
-            std::sprintf(trailing_message_buff, "%s %s/step - Error: %.04f - Accuracy: %.04f", 
-                epoch_running_time_buff, step_time_buff, error/batch_size, (double)correct/batch_size);
-            print_progress(step+1, steps_per_epoch, trailing_message_buff, 20);
+            // Error and accuracy are the ones of the last batch of this worker
+            std::sprintf(trailing_message_buff, "%s %s/step - %.0f samples/s - Error: %.04f - Accuracy: %.04f", 
+                epoch_running_time_buff, step_time_buff, samples / running_epoch_time.count(),
+                worker.error/batch_size, (double)worker.correct/batch_size);
+
+            std::lock_guard<std::mutex> lock(dataloader_mutex);
+            print_progress(step, steps_per_epoch, trailing_message_buff, 20);
         }
-        std::printf("\n");
+    });
 
-        train_dataloader->new_epoch();
+    for(size_t worker_idx = 0; worker_idx < worker_loader_time.size(); worker_idx++){
+        loader_time += worker_loader_time[worker_idx] / worker_loader_time.size();
+    }
 
-        if(test_dataloader != nullptr){
-            evaluate(*test_dataloader, true, true);
+    return epoch_samples.load();
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::init_workers(){
+    m_workers.resize(m_thread_pool->size());
+
+    for(size_t worker_idx = 0; worker_idx < m_workers.size(); worker_idx++){
+        WorkerState& worker = m_workers[worker_idx];
+        worker.index = worker_idx;
+        worker.workspaces.resize(m_layers.size());
+        worker.grads.allocate(m_grads.size());
+        for(size_t layer_idx = 0; layer_idx < m_layers.size(); layer_idx++){
+            m_layers[layer_idx]->init_workspace(worker.workspaces[layer_idx], worker.grads.data() + m_param_offsets[layer_idx]);
         }
+    }
+}
 
-        if(m_lr_scheduler != nullptr){
-            m_lr_scheduler->step(learning_rate, epoch);
+
+template<typename T>
+void BasicPlainNN<T>::evaluate_worker(WorkerState& worker, BasicTensor<T>& input, const T* targets, const int* targets_idx){
+    BasicTensor<T>* output = &input;
+    for(size_t layer_idx = 1; layer_idx < m_layers.size(); layer_idx++){
+        TraceScope scope(m_trace_names[layer_idx * NUM_LAYER_SECTIONS + PROFILE_FORWARD], "layer");
+        output = &m_layers[layer_idx]->forward(*output, worker.workspaces[layer_idx]);
+    }
+
+    T *_output = output->data();
+    int output_size = output->shape().back();
+    int rows = output->size() / output_size;
+
+    worker.error += m_loss->compute(rows, output_size, m_layers.back()->activation_type(),
+        _output, targets, nullptr, worker.loss_per_class.data());
+
+    for(int b = 0; b < rows; b++){
+        T *_output_row = _output + b * output_size;
+
+        int max_idx = 0;
+        for(int i=0; i<output_size; i++){
+            if(_output_row[max_idx] < _output_row[i]){
+                max_idx = i;
+            }
         }
+        if(max_idx == targets_idx[b]){
+            worker.correct++;
+        }
+    }
+}
 
-        if(save_checkpoint){
-            char epoch_checkpoint_path[checkpoint_path.size() + std::to_string(epoch+1).size() + 1];
-            std::sprintf(epoch_checkpoint_path, checkpoint_path.c_str(), epoch+1);
-            save(epoch_checkpoint_path);
+
+template<typename T>
+void BasicPlainNN<T>::train_worker(WorkerState& worker){
+    int last_layer_idx = m_layers.size() - 1;
+
+    Profiler::Clock::time_point profile_s_time;
+
+    BasicTensor<T>* output = &worker.input;
+    for(int layer_idx = 1; layer_idx <= last_layer_idx; layer_idx++){
+        TraceScope scope(m_trace_names[layer_idx * NUM_LAYER_SECTIONS + PROFILE_FORWARD], "layer");
+        if(m_profiler != nullptr) profile_s_time = Profiler::Clock::now();
+        output = &m_layers[layer_idx]->forward(*output, worker.workspaces[layer_idx]);
+        if(m_profiler != nullptr) m_profiler->record(worker.index, layer_idx, PROFILE_FORWARD, profile_s_time);
+    }
+
+    T *_output = output->data();
+    T *_targets = worker.targets.data();
+
+    int output_size = output->shape().back();
+    int rows = worker.targets_idx.size();
+
+    // The targets are replaced by the error signal of the loss,
+    // which is the gradient given to the output layer
+    worker.error = m_loss->compute(rows, output_size, m_layers[last_layer_idx]->activation_type(),
+        _output, _targets, _targets, nullptr);
+    worker.correct = 0;
+
+    for(int b = 0; b < rows; b++){
+        T *_output_row = _output + b * output_size;
+
+        int max_idx = 0;
+        for(int i=0; i<output_size; i++){
+            if(_output_row[max_idx] < _output_row[i]){
+                max_idx = i;
+            }
+        }
+        if(max_idx == worker.targets_idx[b]){
+            worker.correct++;
         }
     }
+
+    // The gradients are written in the buffers of the workspaces,
+    // the backward pass does not allocate once they have grown
+    BasicTensor<T>* next_layer_grads = &worker.targets;
+    for(int layer_idx = last_layer_idx; layer_idx > 0; layer_idx--){
+
+        if(m_layers[layer_idx]->is_frozen){
+            continue;
+        }
+
+        TraceScope scope(m_trace_names[layer_idx * NUM_LAYER_SECTIONS + PROFILE_BACKWARD], "layer");
+        if(m_profiler != nullptr) profile_s_time = Profiler::Clock::now();
+        next_layer_grads = &m_layers[layer_idx]->backward(
+            layer_idx == 1 ? &worker.input : &worker.workspaces[layer_idx-1].output,
+            layer_idx == last_layer_idx ? nullptr : m_layers[layer_idx+1]->get_params(),
+            next_layer_grads,
+            worker.workspaces[layer_idx]
+        );
+        if(m_profiler != nullptr) m_profiler->record(worker.index, layer_idx, PROFILE_BACKWARD, profile_s_time);
+    }
 }
 
 
-void PlainNN::count_to_size(int num_params, char* buff, size_t buff_size, size_t size){
+template<typename T>
+void BasicPlainNN<T>::reduce_gradients(int num_workers){
+    TraceScope scope("reduce_gradients", "train");
+
+    // The gradients of each worker are a single buffer, split
+    // in aligned chunks that are summed in parallel
+    long int num_params = m_grads.size();
+    int num_chunks = m_thread_pool->size();
+    long int chunk_size = align_count<T>((num_params + num_chunks - 1) / num_chunks);
+
+    auto add_chunk = [&](int chunk_idx, T* src, T* dst){
+        long int start = chunk_idx * chunk_size;
+        long int count = std::min(chunk_size, num_params - start);
+        if(count <= 0) return;
+
+        axpy(count, 1.0, src + start, dst + start);
+        std::fill(src + start, src + start + count, 0);
+    };
+
+    // At each round the worker i adds the gradients of the worker
+    // i + stride to its own, the pairs and chunks are independent
+    for(int stride = 1; stride < num_workers; stride *= 2){
+        int num_pairs = (num_workers - stride + 2 * stride - 1) / (2 * stride);
+
+        m_thread_pool->run(num_pairs * num_chunks, [&](int task_idx){
+            int dst_idx = (task_idx / num_chunks) * 2 * stride;
+            add_chunk(task_idx % num_chunks, m_workers[dst_idx + stride].grads.data(), m_workers[dst_idx].grads.data());
+        });
+    }
+
+    m_thread_pool->run(num_chunks, [&](int chunk_idx){
+        add_chunk(chunk_idx, m_workers[0].grads.data(), m_grads.data());
+    });
+}
+
+
+template<typename T>
+void BasicPlainNN<T>::count_to_size(int num_params, char* buff, size_t buff_size, size_t size){
     const char* suffixes[] = {"B", "KB", "MB", "GB", "TB"};
     int suffix_idx = 0;
 
@@ -399,18 +1108,36 @@ void PlainNN::count_to_size(int num_params, char* buff, size_t buff_size, size_t
     std::snprintf(buff, buff_size, "%d (%.2f %s)", num_params, _num_params, suffixes[suffix_idx]);
 }
 
-void PlainNN::print_progress(int curr_progress, int total, std::string trailing_message, int width, bool indent){
+template<typename T>
+void BasicPlainNN<T>::count_to_readable(double count, char* buff, size_t buff_size, bool bytes){
+    const char* metric_suffixes[] = {"", " K", " M", " G", " T"};
+    const char* bytes_suffixes[] = {" B", " KB", " MB", " GB", " TB"};
+    double base = bytes ? 1024 : 1000;
+    int suffix_idx = 0;
+
+    while(count >= base && suffix_idx < 4){
+        count /= base;
+        suffix_idx++;
+    }
+
+    if(suffix_idx == 0) std::snprintf(buff, buff_size, "%.0f%s", count, bytes ? bytes_suffixes[0] : metric_suffixes[0]);
+    else std::snprintf(buff, buff_size, "%.2f%s", count, bytes ? bytes_suffixes[suffix_idx] : metric_suffixes[suffix_idx]);
+}
+
+template<typename T>
+void BasicPlainNN<T>::print_progress(int curr_progress, int total, const char* trailing_message, int width, bool indent){
     char progress_buff[50];
     int progress = (int)((curr_progress / (double)total) * width);
     for(int i = 0; i < width; i++){
         progress_buff[i] = i < progress ? '=' : ' ';
     }
     progress_buff[width] = '\0';
-    std::printf("\r%s%d/%d [%s] %s", (indent) ? "    " : "", curr_progress, total, progress_buff, trailing_message.c_str());
+    std::printf("\r%s%d/%d [%s] %s", (indent) ? "    " : "", curr_progress, total, progress_buff, trailing_message);
     std::fflush(stdout);
 }
 
-void PlainNN::make_duration_readable(const std::chrono::duration<double>& duration, char* buff, size_t buff_size){
+template<typename T>
+void BasicPlainNN<T>::make_duration_readable(const std::chrono::duration<double>& duration, char* buff, size_t buff_size){
     
     long int us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
     if(us >= 1000000){
@@ -426,4 +1153,7 @@ void PlainNN::make_duration_readable(const std::chrono::duration<double>& durati
         // print the time formatted in microseconds
         std::snprintf(buff, buff_size, "%3ldus", us);
     }
-}
\ No newline at end of file
+}
+
+template class BasicPlainNN<float>;
+template class BasicPlainNN<double>;
@@ -0,0 +1,135 @@
+#include "profiler.hpp"
+#include "aligned_buffer.hpp"
+
+#include <cstdio>
+#include <algorithm>
+
+// Index of the step count in a slot, after the sections
+static const int STEPS_IDX = NUM_PROFILE_SECTIONS;
+
+// Index of the first time of the layers in a slot
+static const int LAYERS_IDX = NUM_PROFILE_SECTIONS + 1;
+
+Profiler::Profiler(){
+    m_num_layers = 0;
+}
+
+void Profiler::start(int num_layers, int num_threads){
+    m_num_layers = num_layers;
+    m_epochs.clear();
+
+    // The padding keeps the values of two threads on different cache lines
+    size_t slot_size = LAYERS_IDX + num_layers * NUM_LAYER_SECTIONS + BUFFER_ALIGNMENT / sizeof(double);
+    m_slots.assign(num_threads, std::vector<double>(slot_size, 0));
+}
+
+void Profiler::record(int thread_idx, int layer_idx, ProfileSection section, Clock::time_point start){
+    std::chrono::duration<double> duration = Clock::now() - start;
+    m_slots[thread_idx][LAYERS_IDX + layer_idx * NUM_LAYER_SECTIONS + section] += duration.count();
+}
+
+void Profiler::record(int thread_idx, ProfileSection section, Clock::time_point start){
+    std::chrono::duration<double> duration = Clock::now() - start;
+    m_slots[thread_idx][section] += duration.count();
+}
+
+void Profiler::count_step(int thread_idx){
+    m_slots[thread_idx][STEPS_IDX]++;
+}
+
+void Profiler::end_epoch(int epoch, double wall_time){
+    EpochProfile profile;
+    profile.epoch = epoch;
+    profile.steps = 0;
+    profile.num_threads = m_slots.size();
+    profile.wall_time = wall_time;
+    profile.section_time.assign(NUM_PROFILE_SECTIONS, 0);
+    profile.layer_time.assign(m_num_layers, std::vector<double>(NUM_LAYER_SECTIONS, 0));
+
+    for(size_t thread_idx = 0; thread_idx < m_slots.size(); thread_idx++){
+        std::vector<double>& slot = m_slots[thread_idx];
+        profile.steps += static_cast<long int>(slot[STEPS_IDX]);
+
+        for(int section = 0; section < NUM_PROFILE_SECTIONS; section++){
+            profile.section_time[section] += slot[section];
+        }
+        for(int layer_idx = 0; layer_idx < m_num_layers; layer_idx++){
+            for(int section = 0; section < NUM_LAYER_SECTIONS; section++){
+                double time = slot[LAYERS_IDX + layer_idx * NUM_LAYER_SECTIONS + section];
+                profile.layer_time[layer_idx][section] += time;
+                profile.section_time[section] += time;
+            }
+        }
+        std::fill(slot.begin(), slot.end(), 0);
+    }
+
+    m_epochs.push_back(profile);
+}
+
+EpochProfile Profiler::total(){
+    EpochProfile total;
+    total.epoch = -1;
+    total.steps = 0;
+    total.num_threads = m_slots.size();
+    total.wall_time = 0;
+    total.section_time.assign(NUM_PROFILE_SECTIONS, 0);
+    total.layer_time.assign(m_num_layers, std::vector<double>(NUM_LAYER_SECTIONS, 0));
+
+    for(size_t epoch_idx = 0; epoch_idx < m_epochs.size(); epoch_idx++){
+        EpochProfile& profile = m_epochs[epoch_idx];
+        total.steps += profile.steps;
+        total.wall_time += profile.wall_time;
+        for(int section = 0; section < NUM_PROFILE_SECTIONS; section++){
+            total.section_time[section] += profile.section_time[section];
+        }
+        for(int layer_idx = 0; layer_idx < m_num_layers; layer_idx++){
+            for(int section = 0; section < NUM_LAYER_SECTIONS; section++){
+                total.layer_time[layer_idx][section] += profile.layer_time[layer_idx][section];
+            }
+        }
+    }
+    return total;
+}
+
+void Profiler::print(EpochProfile& profile, std::vector<std::string>& layer_names, std::vector<std::string>& layer_types){
+    double recorded_time = 0;
+    for(int section = 0; section < NUM_PROFILE_SECTIONS; section++){
+        recorded_time += profile.section_time[section];
+    }
+
+    // Times are reported in milliseconds per step
+    double scale = profile.steps > 0 ? 1000.0 / profile.steps : 0;
+    double share = recorded_time > 0 ? 100.0 / recorded_time : 0;
+
+    std::printf("__________________________________________________________________\n");
+    std::printf("%-12s %-12s %10s %10s %10s %7s\n", "Layer", "(Type)", "Forward", "Backward", "Update", "%");
+    std::printf("==================================================================\n");
+
+    for(size_t layer_idx = 0; layer_idx < profile.layer_time.size(); layer_idx++){
+        std::vector<double>& time = profile.layer_time[layer_idx];
+        double layer_time = time[PROFILE_FORWARD] + time[PROFILE_BACKWARD] + time[PROFILE_UPDATE];
+
+        std::printf("%-12s %-12s %10.3f %10.3f %10.3f %6.1f%%\n",
+            layer_names[layer_idx].c_str(), layer_types[layer_idx].c_str(),
+            time[PROFILE_FORWARD] * scale, time[PROFILE_BACKWARD] * scale, time[PROFILE_UPDATE] * scale,
+            layer_time * share);
+    }
+
+    std::printf("==================================================================\n");
+
+    double layers_time = 0;
+    for(int section = 0; section < NUM_LAYER_SECTIONS; section++) layers_time += profile.section_time[section];
+    std::printf("%-25s %10.3f %10.3f %10.3f %6.1f%%\n", "Layers",
+        profile.section_time[PROFILE_FORWARD] * scale, profile.section_time[PROFILE_BACKWARD] * scale,
+        profile.section_time[PROFILE_UPDATE] * scale, layers_time * share);
+
+    for(int section = NUM_LAYER_SECTIONS; section < NUM_PROFILE_SECTIONS; section++){
+        std::printf("%-25s %10.3f %21s %6.1f%%\n", PROFILE_SECTION_NAMES[section].c_str(),
+            profile.section_time[section] * scale, "", profile.section_time[section] * share);
+    }
+
+    std::printf("==================================================================\n");
+    std::printf("Steps: %ld - %.3f ms/step\n", profile.steps, profile.wall_time * scale);
+    std::printf("Times in ms per step, summed over %d thread%s\n", profile.num_threads, profile.num_threads > 1 ? "s" : "");
+    std::printf("__________________________________________________________________\n");
+}
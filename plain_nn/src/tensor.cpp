@@ -7,103 +7,250 @@
 #include "tensor.hpp"
 #include "initialization.hpp"
 
-Tensor::Tensor(){}
+template<typename T>
+BasicTensor<T>::BasicTensor(){}
 
-Tensor::Tensor(std::initializer_list<int> dims, bool random_init, double fill_value ){
-    int data_size = 1;
-    int dim_sum = 0;
-    for(int dim : dims){
-        m_shape.push_back(dim);
-        data_size *= dim;
-        dim_sum += dim;
-    }
+template<typename T>
+BasicTensor<T>::BasicTensor(std::initializer_list<int> dims, bool random_init, T fill_value )
+    : BasicTensor(std::vector<int>(dims), random_init, fill_value){}
 
+
+template<typename T>
+BasicTensor<T>::BasicTensor(std::vector<int> dims, bool random_init, T fill_value ){
+    int data_size = set_shape(dims);
     m_data.resize(data_size, fill_value);
 
+    int dim_sum = 0;
+    for(int dim : dims) dim_sum += dim;
     if(random_init) GolorotInitialization::initialize(m_data, dim_sum);
 }
 
 
-Tensor::Tensor(std::vector<int> dims, bool random_init, double fill_value ){
-    int data_size = 1;
-    int dim_sum = 0;
-    for(int dim : dims){
-        m_shape.push_back(dim);
-        data_size *= dim;
-        dim_sum += dim;
-    }
+template<typename T>
+BasicTensor<T>::BasicTensor(std::initializer_list<int> dims, std::vector<T>& data){
+    set_shape(dims);
+    m_data.assign(data.begin(), data.end());
+}
 
-    m_data.resize(data_size, fill_value);
+template<typename T>
+BasicTensor<T>::BasicTensor(std::vector<int> dims, std::vector<T>& data){
+    set_shape(dims);
+    m_data.assign(data.begin(), data.end());
+}
 
-    if(random_init) GolorotInitialization::initialize(m_data, dim_sum);
+template<typename T>
+BasicTensor<T>::BasicTensor(std::initializer_list<int> dims, BasicAlignedVector<T>&& data){
+    set_shape(dims);
+    m_data = std::move(data);
+}
+
+template<typename T>
+BasicTensor<T>::BasicTensor(std::vector<int> dims, BasicAlignedVector<T>&& data){
+    set_shape(std::move(dims));
+    m_data = std::move(data);
+}
+
+
+template<typename T>
+BasicTensor<T>::BasicTensor(std::vector<int> dims, T* data){
+    m_view_size = set_shape(std::move(dims));
+    m_view = data;
+}
+
+
+template<typename T>
+BasicTensor<T>::BasicTensor(std::initializer_list<int> dims, T* data) : BasicTensor(std::vector<int>(dims), data){}
+
+
+template<typename T>
+BasicTensor<T>::BasicTensor(std::vector<int> dims, std::vector<int> strides, T* data){
+    if(strides.size() != dims.size()){
+        throw std::runtime_error("Expected " + std::to_string(dims.size()) + " strides, got " + std::to_string(strides.size()));
+    }
+    m_view_size = set_shape(std::move(dims));
+    m_strides = std::move(strides);
+    m_view = data;
 }
 
 
-Tensor::Tensor(std::initializer_list<int> dims, std::vector<double>& data){
+template<typename T>
+int BasicTensor<T>::set_shape(std::vector<int> dims){
+    m_shape = std::move(dims);
+    m_strides.resize(m_shape.size());
+
     int data_size = 1;
-    for(int dim : dims){
-        m_shape.push_back(dim);
-        data_size *= dim;
+    for(int i = m_shape.size() - 1; i >= 0; i--){
+        m_strides[i] = data_size;
+        data_size *= m_shape[i];
     }
-    m_data = data;
+    return data_size;
 }
 
-Tensor::Tensor(std::vector<int> dims, std::vector<double>& data){
-    m_shape = dims;
-    m_data = data;
+
+/**
+ * @brief Call fn on each element of a strided tensor, in row-major order
+ */
+template<typename T, typename F>
+static void for_each_element(T* data, const std::vector<int>& shape, const std::vector<int>& strides, size_t dim, F& fn){
+    if(dim == shape.size()){
+        fn(*data);
+        return;
+    }
+    for(int i = 0; i < shape[dim]; i++){
+        for_each_element(data + (long int) i * strides[dim], shape, strides, dim + 1, fn);
+    }
 }
 
 
-void Tensor::clear(){
-    std::fill(m_data.begin(), m_data.end(), 0);
+template<typename T>
+void BasicTensor<T>::clear(){
+    if(size() == 0) return;
+
+    if(is_contiguous()){
+        std::fill(data(), data() + size(), 0);
+    } else{
+        auto set_zero = [](T& x){ x = 0; };
+        for_each_element(data(), m_shape, m_strides, 0, set_zero);
+    }
 }
 
 
-std::vector<int> Tensor::shape(){
+template<typename T>
+const std::vector<int>& BasicTensor<T>::shape(){
     return m_shape;
 }
 
 
-int Tensor::shape(int index){
+template<typename T>
+int BasicTensor<T>::shape(int index){
     return m_shape[index];
 }
 
 
-double* Tensor::data(){
-    return m_data.data();
+template<typename T>
+int BasicTensor<T>::stride(int index){
+    return m_strides[index];
 }
 
 
-int Tensor::size(){
-    return m_data.size();
+template<typename T>
+const std::vector<int>& BasicTensor<T>::strides(){
+    return m_strides;
 }
 
 
-double& Tensor::operator[](int index){
-    return m_data[index];
+template<typename T>
+bool BasicTensor<T>::is_contiguous(){
+    if(m_view == nullptr) return true;
+
+    int expected = 1;
+    for(int i = m_shape.size() - 1; i >= 0; i--){
+        // The stride of a dimension of size 1 is never used
+        if(m_shape[i] != 1 && m_strides[i] != expected) return false;
+        expected *= m_shape[i];
+    }
+    return true;
+}
+
+
+template<typename T>
+int BasicTensor<T>::ndim(){
+    return m_shape.size();
 }
 
 
-void Tensor::reshape(std::initializer_list<int> dims, bool random_init, double fill_value){
+template<typename T>
+T* BasicTensor<T>::data(){
+    return m_view != nullptr ? m_view : m_data.data();
+}
+
+
+template<typename T>
+int BasicTensor<T>::size(){
+    return m_view != nullptr ? m_view_size : m_data.size();
+}
+
+
+template<typename T>
+T& BasicTensor<T>::operator[](int index){
+    return data()[index];
+}
+
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::view(){
+    return BasicTensor<T>(m_shape, m_strides, data());
+}
+
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::view(std::vector<int> dims){
     int data_size = 1;
-    int dim_sum = 0;
+    for(int dim : dims) data_size *= dim;
 
-    m_shape.clear();
-    m_data.clear();
+    if(data_size != size()){
+        throw std::runtime_error("Cannot view a tensor of shape " + shape_str() + " with " + std::to_string(data_size) + " elements");
+    }
+    if(!is_contiguous()){
+        throw std::runtime_error("Cannot change the shape of a non contiguous view");
+    }
+    return BasicTensor<T>(dims, data());
+}
 
-    for(int dim : dims){
-        m_shape.push_back(dim);
-        data_size *= dim;
-        dim_sum += dim;
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::slice(int start, int end, int dim){
+    if(dim < 0 || dim >= ndim() || start < 0 || end > m_shape[dim] || start > end){
+        throw std::runtime_error("Invalid slice [" + std::to_string(start) + ", " + std::to_string(end)
+            + ") of dimension " + std::to_string(dim) + " of a tensor of shape " + shape_str());
     }
 
+    std::vector<int> dims(m_shape);
+    dims[dim] = end - start;
+    return BasicTensor<T>(dims, m_strides, data() + (long int) start * m_strides[dim]);
+}
+
+
+template<typename T>
+BasicTensor<T> BasicTensor<T>::contiguous(){
+    BasicTensor<T> copy(m_shape);
+    if(size() == 0) return copy;
+
+    T* _copy = copy.data();
+    if(is_contiguous()){
+        std::copy(data(), data() + size(), _copy);
+    } else{
+        auto append = [&_copy](T& x){ *_copy++ = x; };
+        for_each_element(data(), m_shape, m_strides, 0, append);
+    }
+    return copy;
+}
+
+
+template<typename T>
+void BasicTensor<T>::reshape(std::initializer_list<int> dims, bool random_init, T fill_value){
+    reshape(std::vector<int>(dims), random_init, fill_value);
+}
+
+
+template<typename T>
+void BasicTensor<T>::reshape(std::vector<int> dims, bool random_init, T fill_value){
+    int dim_sum = 0;
+    for(int dim : dims) dim_sum += dim;
+
+    m_data.clear();
+    m_view = nullptr;
+    m_view_size = 0;
+
+    int data_size = set_shape(std::move(dims));
     m_data.resize(data_size, fill_value);
 
     if(random_init) GolorotInitialization::initialize(m_data, dim_sum);
 }
 
 
-std::string Tensor::shape_str(){
+template<typename T>
+std::string BasicTensor<T>::shape_str(){
     std::string str;
     str += "(";
 
@@ -114,4 +261,39 @@ std::string Tensor::shape_str(){
 
     str += ")";
     return str;
-}
\ No newline at end of file
+}
+
+
+template<typename T>
+BasicTensor<T> stack(std::vector<BasicTensor<T> >& tensors){
+    if(tensors.size() == 0) return BasicTensor<T>();
+
+    std::vector<int> dims = tensors[0].shape();
+    int item_size = tensors[0].size();
+    dims.insert(dims.begin(), static_cast<int>(tensors.size()));
+
+    BasicTensor<T> stacked(dims);
+    T* _stacked = stacked.data();
+
+    for(size_t i = 0; i < tensors.size(); i++){
+        if(tensors[i].size() != item_size){
+            throw std::runtime_error("Cannot stack tensors with different shapes " + tensors[0].shape_str() + " and " + tensors[i].shape_str());
+        }
+        if(tensors[i].is_contiguous()){
+            std::copy(tensors[i].data(), tensors[i].data() + item_size, _stacked + i * item_size);
+        } else{
+            // Gathered in place, without a contiguous copy of each view
+            T* _item = _stacked + i * item_size;
+            auto append = [&_item](T& x){ *_item++ = x; };
+            for_each_element(tensors[i].data(), tensors[i].shape(), tensors[i].strides(), 0, append);
+        }
+    }
+
+    return stacked;
+}
+
+
+template struct BasicTensor<float>;
+template struct BasicTensor<double>;
+template BasicTensor<float> stack(std::vector<BasicTensor<float> >& tensors);
+template BasicTensor<double> stack(std::vector<BasicTensor<double> >& tensors);
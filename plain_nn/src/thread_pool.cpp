@@ -0,0 +1,94 @@
+#include "thread_pool.hpp"
+#include "trace.hpp"
+
+#include <stdexcept>
+
+ThreadPool::ThreadPool(int num_threads){
+    if(num_threads < 1){
+        throw std::runtime_error("Thread pool size must be at least 1, got " + std::to_string(num_threads));
+    }
+
+    m_task = nullptr;
+    m_num_tasks = 0;
+    m_next_task = 0;
+    m_generation = 0;
+    m_active_workers = 0;
+    m_stop = false;
+
+    // The calling thread is one of the threads of the pool
+    for(int i = 1; i < num_threads; i++){
+        m_workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start_cv.notify_all();
+
+    for(size_t i = 0; i < m_workers.size(); i++){
+        m_workers[i].join();
+    }
+}
+
+int ThreadPool::size(){
+    return m_workers.size() + 1;
+}
+
+void ThreadPool::run(int num_tasks, const std::function<void(int)>& task){
+    if(num_tasks <= 0) return;
+
+    if(m_workers.empty() || num_tasks == 1){
+        for(int i = 0; i < num_tasks; i++) task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_num_tasks = num_tasks;
+        m_next_task = 0;
+        m_active_workers = m_workers.size();
+        m_generation++;
+    }
+    m_start_cv.notify_all();
+
+    execute_tasks();
+
+    // Every worker must be done with this job before the
+    // task, which lives on the caller's stack, goes away
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cv.wait(lock, [this]{ return m_active_workers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::execute_tasks(){
+    for(int i = m_next_task.fetch_add(1); i < m_num_tasks; i = m_next_task.fetch_add(1)){
+        (*m_task)(i);
+    }
+}
+
+void ThreadPool::worker_loop(int worker_idx){
+    Tracer::set_thread_name("pool worker " + std::to_string(worker_idx));
+    long int seen_generation = 0;
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_cv.wait(lock, [this, seen_generation]{ return m_stop || m_generation != seen_generation; });
+            if(m_stop) return;
+            seen_generation = m_generation;
+        }
+
+        execute_tasks();
+
+        bool last_worker;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            last_worker = --m_active_workers == 0;
+        }
+        if(last_worker) m_done_cv.notify_one();
+    }
+}
@@ -0,0 +1,168 @@
+#include "trace.hpp"
+
+#include <vector>
+#include <set>
+#include <mutex>
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+/**
+ * @brief A complete event, the times are in nanoseconds
+ */
+struct TraceEvent{
+    const char* name;
+    const char* category;
+    long int start;
+    long int duration;
+};
+
+/**
+ * @brief The events of a thread, kept after the thread exits
+ * so that they can still be saved
+ */
+struct ThreadTrace{
+    int tid;
+    std::string name;
+    // @brief Guards the events and the dropped count, a scope still open
+    // when the trace is stopped can record while it is saved or restarted
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    long int dropped;
+};
+
+static std::mutex registry_mutex;
+static std::vector<ThreadTrace*> registry;
+static std::set<std::string> interned_names;
+static long int trace_origin = 0;
+static std::atomic<long int> max_events(1 << 20);
+
+static thread_local ThreadTrace* local_trace = nullptr;
+static thread_local std::string local_name;
+
+// Registers the buffer of the calling thread on its first event or when
+// it is named, the other threads that are never traced do not allocate one
+static ThreadTrace* thread_trace(){
+    if(local_trace == nullptr){
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        local_trace = new ThreadTrace();
+        local_trace->tid = registry.size() + 1;
+        local_trace->name = local_name.empty() ? "thread " + std::to_string(local_trace->tid) : local_name;
+        local_trace->dropped = 0;
+        registry.push_back(local_trace);
+    }
+    return local_trace;
+}
+
+// The names are chosen by the callers, quotes and
+// backslashes are escaped to keep the file valid
+static std::string escape_json(const std::string& str){
+    std::string escaped;
+    for(char c : str){
+        if(c == '"' || c == '\\') escaped += '\\';
+        if(static_cast<unsigned char>(c) >= 0x20) escaped += c;
+    }
+    return escaped;
+}
+
+void Tracer::start(long int max_events_per_thread){
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for(size_t i = 0; i < registry.size(); i++){
+        std::lock_guard<std::mutex> trace_lock(registry[i]->mutex);
+        registry[i]->events.clear();
+        registry[i]->dropped = 0;
+    }
+    max_events.store(max_events_per_thread);
+    trace_origin = now();
+    s_enabled.store(true);
+}
+
+void Tracer::stop(){
+    s_enabled.store(false);
+}
+
+void Tracer::record(const char* name, const char* category, long int start, long int end){
+    ThreadTrace* trace = thread_trace();
+
+    // Only contended while the trace is saved or restarted
+    std::lock_guard<std::mutex> lock(trace->mutex);
+    if(static_cast<long int>(trace->events.size()) >= max_events.load(std::memory_order_relaxed)){
+        trace->dropped++;
+        return;
+    }
+    trace->events.push_back(TraceEvent{name, category, start, end - start});
+}
+
+void Tracer::set_thread_name(std::string name){
+    // The named threads are registered right away, so that they appear
+    // in the timeline even when they record no event
+    local_name = name;
+    ThreadTrace* trace = thread_trace();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    trace->name = name;
+}
+
+const char* Tracer::intern(std::string name){
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return interned_names.insert(name).first->c_str();
+}
+
+long int Tracer::num_events(){
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    long int count = 0;
+    for(size_t i = 0; i < registry.size(); i++){
+        std::lock_guard<std::mutex> trace_lock(registry[i]->mutex);
+        count += registry[i]->events.size();
+    }
+    return count;
+}
+
+long int Tracer::num_dropped(){
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    long int count = 0;
+    for(size_t i = 0; i < registry.size(); i++){
+        std::lock_guard<std::mutex> trace_lock(registry[i]->mutex);
+        count += registry[i]->dropped;
+    }
+    return count;
+}
+
+void Tracer::save(std::string file_name){
+    std::ofstream file(file_name);
+    if(!file.is_open()){
+        throw std::runtime_error("Error opening trace file: " + file_name);
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    int pid = getpid();
+    long int dropped = 0;
+
+    // The timestamps are in microseconds since the start of the trace
+    char event_buff[128];
+    file << "{\"traceEvents\": [\n";
+    bool first = true;
+    for(size_t i = 0; i < registry.size(); i++){
+        ThreadTrace* trace = registry[i];
+        std::lock_guard<std::mutex> trace_lock(trace->mutex);
+        dropped += trace->dropped;
+
+        file << (first ? "" : ",\n");
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << trace->tid
+            << ", \"args\": {\"name\": \"" << escape_json(trace->name) << "\"}}";
+        first = false;
+
+        for(size_t event_idx = 0; event_idx < trace->events.size(); event_idx++){
+            TraceEvent& event = trace->events[event_idx];
+            std::snprintf(event_buff, sizeof(event_buff), "\"ts\": %.3f, \"dur\": %.3f",
+                (event.start - trace_origin) / 1000.0, event.duration / 1000.0);
+            file << ",\n{\"name\": \"" << escape_json(event.name) << "\", \"cat\": \"" << escape_json(event.category)
+                << "\", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << trace->tid << ", " << event_buff << "}";
+        }
+    }
+    file << "\n],\n\"displayTimeUnit\": \"ms\",\n\"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+
+    file.close();
+}
@@ -0,0 +1,30 @@
+#include "allocation_counter.hpp"
+
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+// Every heap allocation of the process goes through these, gcc
+// flags the free of memory obtained with the replaced operator new
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static std::atomic<long int> s_allocation_count(0);
+
+long int allocation_count(){
+    return s_allocation_count.load();
+}
+
+void* operator new(std::size_t size){
+    s_allocation_count++;
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if(ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, __attribute_maybe_unused__ std::size_t size) noexcept{
+    std::free(ptr);
+}
@@ -0,0 +1,13 @@
+#ifndef PLAIN_NN_TEST_ALLOCATION_COUNTER_H
+#define PLAIN_NN_TEST_ALLOCATION_COUNTER_H
+
+/**
+ * @brief Get the number of heap allocations of the process so far,
+ * counted by the global operator new of allocation_counter.cpp, which
+ * the test executable must be linked with
+ *
+ * @return long int The number of calls to operator new
+ */
+long int allocation_count();
+
+#endif // PLAIN_NN_TEST_ALLOCATION_COUNTER_H
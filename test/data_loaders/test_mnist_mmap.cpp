@@ -0,0 +1,167 @@
+#include "data_loaders.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+void write_idx_int(std::ofstream& file, int value){
+    value = __builtin_bswap32(value);
+    file.write(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Write images of rows*cols pixels whose value depends on
+ * the image and pixel index, and labels equal to the image index % 10
+ */
+void write_idx_files(std::string images_path, std::string labels_path, int count, int rows, int cols){
+    std::ofstream images(images_path, std::ios::binary);
+    write_idx_int(images, 0x00000803);
+    write_idx_int(images, count);
+    write_idx_int(images, rows);
+    write_idx_int(images, cols);
+    for(int i = 0; i < count; i++){
+        for(int j = 0; j < rows * cols; j++){
+            unsigned char pixel = (unsigned char) (i * 31 + j * 7);
+            images.write(reinterpret_cast<char*>(&pixel), 1);
+        }
+    }
+
+    std::ofstream labels(labels_path, std::ios::binary);
+    write_idx_int(labels, 0x00000801);
+    write_idx_int(labels, count);
+    for(int i = 0; i < count; i++){
+        unsigned char label = (unsigned char) (i % 10);
+        labels.write(reinterpret_cast<char*>(&label), 1);
+    }
+}
+
+template<typename T>
+bool check_batches(std::string images_path, std::string labels_path, int count, int rows, int cols, double tol){
+    BasicMNISTDataLoader<T> loader(images_path, labels_path, false, false);
+    loader.load();
+
+    int batch_size = 4;
+    int steps = loader.steps_per_epoch(batch_size);
+    if(steps != (count + batch_size - 1) / batch_size){
+        std::cout << "Unexpected steps per epoch: " << steps << std::endl;
+        return false;
+    }
+
+    // The same batch is reused for every step
+    int seen = 0;
+    BasicBatchData<T> batch;
+    for(int step = 0; step < steps; step++){
+        loader.fill_batch(batch_size, batch);
+        if(batch.input_data.shape(1) != rows * cols || batch.input_data.shape(0) != batch.size()){
+            std::cout << "Wrong batch shape: " << batch.input_data.shape_str() << std::endl;
+            return false;
+        }
+
+        for(int b = 0; b < batch.size(); b++, seen++){
+            if(batch.targets_idx[b] != seen % 10 || batch.targets_one_hot[b * 10 + seen % 10] != 1){
+                std::cout << "Wrong label for image " << seen << std::endl;
+                return false;
+            }
+            for(int j = 0; j < rows * cols; j++){
+                double expected = (unsigned char) (seen * 31 + j * 7) / 255.0;
+                if(std::fabs(batch.input_data[b * rows * cols + j] - expected) > tol){
+                    std::cout << "Wrong pixel " << j << " of image " << seen << ": "
+                        << batch.input_data[b * rows * cols + j] << " != " << expected << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // The last batch is smaller and must not read past the end
+    if(seen != count){
+        std::cout << "Expected " << count << " images, got " << seen << std::endl;
+        return false;
+    }
+
+    // A shuffled epoch visits every image exactly once
+    BasicMNISTDataLoader<T> shuffled(images_path, labels_path, true, false);
+    shuffled.load();
+    shuffled.new_epoch();
+    std::vector<int> visits(count, 0);
+    for(int step = 0; step < steps; step++){
+        shuffled.fill_batch(batch_size, batch);
+        for(int b = 0; b < batch.size(); b++){
+            // The first pixel identifies the image
+            int image_idx = -1;
+            for(int i = 0; i < count; i++){
+                if(std::fabs(batch.input_data[b * rows * cols] - (unsigned char) (i * 31) / 255.0) <= tol) image_idx = i;
+            }
+            if(image_idx < 0 || batch.targets_idx[b] != image_idx % 10){
+                std::cout << "Shuffled image does not match its label" << std::endl;
+                return false;
+            }
+            visits[image_idx]++;
+        }
+    }
+    for(int i = 0; i < count; i++){
+        if(visits[i] != 1){
+            std::cout << "Image " << i << " visited " << visits[i] << " times in a shuffled epoch" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(){
+
+    // 7x5 images so that a row of pixels is not a multiple of the vector width
+    const int count = 11, rows = 7, cols = 5;
+    write_idx_files("mmap_images.idx", "mmap_labels.idx", count, rows, cols);
+
+    if(!check_batches<double>("mmap_images.idx", "mmap_labels.idx", count, rows, cols, 1e-12)) return TEST_FAIL;
+    if(!check_batches<float>("mmap_images.idx", "mmap_labels.idx", count, rows, cols, 1e-6)) return TEST_FAIL;
+
+    // The images and labels files swapped are rejected
+    MNISTDataLoader swapped("mmap_labels.idx", "mmap_images.idx");
+    try{
+        swapped.load();
+        std::cout << "Labels file accepted as an images file" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    // A label that is not a digit would index past the one-hot targets
+    {
+        std::ofstream labels("mmap_bad_labels.idx", std::ios::binary);
+        write_idx_int(labels, 0x00000801);
+        write_idx_int(labels, count);
+        for(int i = 0; i < count; i++){
+            unsigned char label = i == 7 ? 10 : i % 10;
+            labels.write(reinterpret_cast<char*>(&label), 1);
+        }
+    }
+    MNISTDataLoader bad_labels("mmap_images.idx", "mmap_bad_labels.idx");
+    try{
+        bad_labels.load();
+        std::cout << "Label 10 accepted" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    // Counts and dimensions must be positive
+    write_idx_files("mmap_empty_images.idx", "mmap_empty_labels.idx", count, 0, cols);
+    MNISTDataLoader empty_images("mmap_empty_images.idx", "mmap_labels.idx");
+    try{
+        empty_images.load();
+        std::cout << "Images of 0 rows accepted" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    write_idx_files("mmap_empty_images.idx", "mmap_empty_labels.idx", 0, rows, cols);
+    MNISTDataLoader empty_labels("mmap_images.idx", "mmap_empty_labels.idx");
+    try{
+        empty_labels.load();
+        std::cout << "Labels file of 0 labels accepted" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    return TEST_SUCCESS;
+}
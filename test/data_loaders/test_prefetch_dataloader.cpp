@@ -0,0 +1,146 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+/**
+ * @brief Deterministic in-memory dataset, every feature of a sample
+ * holds its index. Optionally throws when a given sample is read.
+ */
+class IndexDataLoader : public TestDataLoader{
+    public:
+        IndexDataLoader(int samples, int features, int classes, int fail_at = -1)
+            : TestDataLoader(samples, features, classes){
+            m_fail_at = fail_at;
+            for(size_t i = 0; i < m_inputs.size(); i++) m_inputs[i] = (double) (i / features);
+        }
+
+        void fill_batch(int batch_size, BatchData& batch){
+            if(m_fail_at >= m_offset && m_fail_at < m_offset + batch_size){
+                throw std::runtime_error("Sample " + std::to_string(m_fail_at) + " is corrupted");
+            }
+            TestDataLoader::fill_batch(batch_size, batch);
+        }
+
+    private:
+        int m_fail_at;
+};
+
+/**
+ * @brief Check that the prefetched batches are the ones of
+ * the wrapped loader, in the same order
+ */
+bool check_sequence(int depth, int batch_size){
+    IndexDataLoader direct(100, 5, 3);
+    IndexDataLoader wrapped(100, 5, 3);
+    PrefetchDataLoader prefetch(wrapped, depth);
+
+    BatchData expected, actual;
+    for(int epoch = 0; epoch < 2; epoch++){
+        // One call more than steps_per_epoch, it must return an empty batch
+        for(int step = 0; step <= direct.steps_per_epoch(batch_size); step++){
+            direct.fill_batch(batch_size, expected);
+            prefetch.fill_batch(batch_size, actual);
+
+            if(actual.size() != expected.size()){
+                std::cout << "Depth " << depth << ", epoch " << epoch << ", step " << step << ": got "
+                    << actual.size() << " samples instead of " << expected.size() << std::endl;
+                return false;
+            }
+            if(expected.size() == 0) continue;
+
+            if(actual.targets_idx != expected.targets_idx
+                || !std::equal(expected.input_data.data(), expected.input_data.data() + expected.input_data.size(), actual.input_data.data())
+                || !std::equal(expected.targets_one_hot.data(), expected.targets_one_hot.data() + expected.targets_one_hot.size(), actual.targets_one_hot.data())){
+                std::cout << "Depth " << depth << ", epoch " << epoch << ", step " << step << ": batch differs" << std::endl;
+                return false;
+            }
+        }
+        direct.new_epoch();
+        prefetch.new_epoch();
+    }
+    return true;
+}
+
+int main(){
+
+    const int depths[] = {1, 2, 5};
+    for(int depth : depths){
+        if(!check_sequence(depth, 8)) return TEST_FAIL;
+        if(!check_sequence(depth, 7)) return TEST_FAIL;
+    }
+
+    // A new batch size starts the epoch over
+    IndexDataLoader resized_loader(100, 5, 3);
+    PrefetchDataLoader resized(resized_loader, 3);
+    BatchData batch;
+    resized.fill_batch(10, batch);
+    resized.fill_batch(4, batch);
+    if(batch.size() != 4 || batch.input_data[0] != 0){
+        std::cout << "Changing the batch size did not restart the epoch" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Errors of the wrapped loader are raised in the consumer
+    IndexDataLoader failing_loader(100, 5, 3, 42);
+    PrefetchDataLoader failing(failing_loader, 2);
+    bool raised = false;
+    try{
+        for(int step = 0; step < failing.steps_per_epoch(10); step++){
+            failing.fill_batch(10, batch);
+        }
+    } catch(std::runtime_error&){
+        raised = true;
+    }
+    if(!raised){
+        std::cout << "Error of the wrapped loader was not raised" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Training on prefetched batches updates the model exactly as
+    // training on the wrapped loader directly
+    IndexDataLoader train_loader(256, 20, 4);
+    PlainNN reference(1);
+    reference.add_layer(new Input({20}));
+    reference.add_layer(new Dense(8, new ReLU()));
+    reference.add_layer(new Dense(4, new Sigmoid()));
+    std::vector<double> initial_params = reference.get_layer(1)->get_saveable_params();
+    std::vector<double> initial_output_params = reference.get_layer(2)->get_saveable_params();
+    reference.train(train_loader, 0.01, 2, 16);
+
+    train_loader.new_epoch();
+    PrefetchDataLoader prefetch_loader(train_loader, 2);
+    PlainNN model(1);
+    model.add_layer(new Input({20}));
+    model.add_layer(new Dense(8, new ReLU()));
+    model.add_layer(new Dense(4, new Sigmoid()));
+    model.get_layer(1)->load_params(initial_params);
+    model.get_layer(2)->load_params(initial_output_params);
+    TrainingStats stats = model.train(prefetch_loader, 0.01, 2, 16);
+
+    if(stats.samples != 2 * 256 || stats.loader_time < 0 || stats.loader_time > stats.train_time){
+        std::cout << "Unexpected training stats: " << stats.samples << " samples, "
+            << stats.loader_time << "s in the loader out of " << stats.train_time << "s" << std::endl;
+        return TEST_FAIL;
+    }
+
+    for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+        std::vector<double> expected = reference.get_layer(layer_idx)->get_saveable_params();
+        std::vector<double> actual = model.get_layer(layer_idx)->get_saveable_params();
+        for(size_t i = 0; i < expected.size(); i++){
+            if(expected[i] != actual[i]){
+                std::cout << "Parameters of layer " << layer_idx << " differ at " << i << ": " << actual[i] << " != " << expected[i] << std::endl;
+                return TEST_FAIL;
+            }
+        }
+    }
+
+    return TEST_SUCCESS;
+}
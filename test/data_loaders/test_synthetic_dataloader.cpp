@@ -0,0 +1,125 @@
+#include "data_loaders.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+bool same_batch(BatchData& a, BatchData& b){
+    if(a.size() != b.size() || a.input_data.size() != b.input_data.size()) return false;
+    for(int i = 0; i < a.input_data.size(); i++){
+        if(a.input_data[i] != b.input_data[i]) return false;
+    }
+    for(int i = 0; i < a.size(); i++){
+        if(a.targets_idx[i] != b.targets_idx[i]) return false;
+    }
+    return true;
+}
+
+int main(){
+
+    const int samples = 50, features = 13, classes = 7, batch_size = 8;
+
+    SyntheticDataLoader loader(samples, features, classes);
+    SyntheticDataLoader same_seed(samples, features, classes);
+    SyntheticDataLoader other_seed(samples, features, classes, 7);
+    loader.load();
+    same_seed.load();
+    other_seed.load();
+
+    if(loader.num_classes() != classes || loader.steps_per_epoch(batch_size) != samples / batch_size){
+        std::cout << "Unexpected classes or steps per epoch: " << loader.num_classes() << ", "
+            << loader.steps_per_epoch(batch_size) << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Every batch of the same seed is the same, over two shuffled epochs
+    BatchData batch, expected, other;
+    bool seeds_differ = false;
+    for(int epoch = 0; epoch < 2; epoch++){
+        for(int step = 0; step < loader.steps_per_epoch(batch_size); step++){
+            loader.fill_batch(batch_size, batch);
+            same_seed.fill_batch(batch_size, expected);
+            other_seed.fill_batch(batch_size, other);
+
+            if(!same_batch(batch, expected)){
+                std::cout << "Batch " << step << " of epoch " << epoch << " differs with the same seed" << std::endl;
+                return TEST_FAIL;
+            }
+            if(!same_batch(batch, other)) seeds_differ = true;
+
+            if(batch.input_data.shape(0) != batch_size || batch.input_data.shape(1) != features
+                || batch.targets_one_hot.shape(1) != classes){
+                std::cout << "Wrong batch shape: " << batch.input_data.shape_str() << std::endl;
+                return TEST_FAIL;
+            }
+
+            for(int b = 0; b < batch_size; b++){
+                int target = batch.targets_idx[b];
+                if(target < 0 || target >= classes || batch.targets_one_hot[b * classes + target] != 1){
+                    std::cout << "Wrong label " << target << std::endl;
+                    return TEST_FAIL;
+                }
+                for(int j = 0; j < features; j++){
+                    double value = batch.input_data[b * features + j];
+                    if(value < 0 || value > 1 || std::fabs(value * 255 - std::round(value * 255)) > 1e-9){
+                        std::cout << "Feature out of range: " << value << std::endl;
+                        return TEST_FAIL;
+                    }
+                }
+            }
+        }
+
+        // The last partial batch is dropped and starts a new epoch
+        loader.fill_batch(batch_size, batch);
+        same_seed.fill_batch(batch_size, expected);
+        other_seed.fill_batch(batch_size, other);
+        if(batch.size() != 0){
+            std::cout << "The last partial batch was not dropped" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+    if(!seeds_differ){
+        std::cout << "Different seeds give the same samples" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Without dropping, the last partial batch is kept
+    SyntheticDataLoaderF ordered(samples, features, classes, 42, false, false);
+    ordered.load();
+    if(ordered.steps_per_epoch(batch_size) != (samples + batch_size - 1) / batch_size){
+        std::cout << "Unexpected steps per epoch without drop_last" << std::endl;
+        return TEST_FAIL;
+    }
+    BatchDataF float_batch;
+    int seen = 0;
+    for(int step = 0; step < ordered.steps_per_epoch(batch_size); step++){
+        ordered.fill_batch(batch_size, float_batch);
+        seen += float_batch.size();
+    }
+    if(seen != samples){
+        std::cout << "Expected " << samples << " samples, got " << seen << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Before load there is nothing to read, with or without dropping
+    for(int drop_last = 0; drop_last < 2; drop_last++){
+        SyntheticDataLoaderF unloaded(samples, features, classes, 42, false, drop_last);
+        unloaded.fill_batch(batch_size, float_batch);
+        if(float_batch.size() != 0){
+            std::cout << "A loader not loaded yet filled " << float_batch.size() << " samples" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    try{
+        SyntheticDataLoader empty(0, features, classes);
+        std::cout << "An empty synthetic dataset was accepted" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,153 @@
+#include "batch_scheduler.hpp"
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <stdexcept>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+bool all_close(Tensor& a, Tensor& b, double tol){
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++){
+        if(std::fabs(a[i] - b[i]) > tol) return false;
+    }
+    return true;
+}
+
+int main(){
+
+    PlainNN model;
+    model.add_layer(new Input({32}));
+    model.add_layer(new Dense(24, new ReLU()));
+    model.add_layer(new Dense(10, new Softmax()));
+
+    const int num_samples = 64;
+    std::vector<Tensor> samples, expected;
+    for(int s = 0; s < num_samples; s++){
+        Tensor sample({32});
+        for(int i = 0; i < sample.size(); i++) sample[i] = std::sin(0.1 * i + s);
+        samples.push_back(sample);
+        expected.push_back(model.forward(sample));
+    }
+
+    // A full batch starts without waiting for the others
+    {
+        BatchScheduler scheduler(model, 4, 10000.0);
+        std::vector<std::future<Tensor> > outputs;
+        for(int s = 0; s < 8; s++) outputs.push_back(scheduler.submit(samples[s]));
+
+        for(int s = 0; s < 8; s++){
+            if(outputs[s].wait_for(std::chrono::seconds(5)) != std::future_status::ready){
+                std::cout << "A full batch was not run" << std::endl;
+                return TEST_FAIL;
+            }
+            Tensor output = outputs[s].get();
+            if(!all_close(output, expected[s], 1e-12)){
+                std::cout << "Output of sample " << s << " does not match forward" << std::endl;
+                return TEST_FAIL;
+            }
+        }
+
+        BatchSchedulerStats stats = scheduler.stats();
+        if(stats.requests != 8 || stats.batches != 2 || stats.batch_sizes[4] != 2 || stats.queue_depth != 0
+            || stats.max_queue_depth < 4 || stats.avg_batch_size != 4){
+            std::cout << "Unexpected stats: " << stats.batches << " batches, " << stats.requests << " requests, max queue depth "
+                << stats.max_queue_depth << std::endl;
+            return TEST_FAIL;
+        }
+
+        scheduler.reset_stats();
+        if(scheduler.stats().batches != 0 || scheduler.stats().batch_sizes[4] != 0){
+            std::cout << "The stats were not reset" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    // A lone sample waits for the others at most max_wait_ms
+    {
+        BatchScheduler scheduler(model, 16, 20.0);
+        std::future<Tensor> output = scheduler.submit(samples[0]);
+        if(output.wait_for(std::chrono::seconds(5)) != std::future_status::ready){
+            std::cout << "A partial batch was not run after the maximum wait" << std::endl;
+            return TEST_FAIL;
+        }
+        Tensor result = output.get();
+        BatchSchedulerStats stats = scheduler.stats();
+        if(!all_close(result, expected[0], 1e-12) || stats.batch_sizes[1] != 1 || stats.max_queue_time < 19.0){
+            std::cout << "Unexpected lone sample, queued for " << stats.max_queue_time << " ms" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    // Samples submitted concurrently by several threads, run by two threads
+    {
+        BatchScheduler scheduler(model, 8, 2.0, 2);
+        const int num_clients = 8;
+        std::vector<bool> matches(num_clients, true);
+        std::vector<std::thread> clients;
+        for(int c = 0; c < num_clients; c++){
+            clients.push_back(std::thread([&, c]{
+                for(int s = c; s < num_samples; s += num_clients){
+                    Tensor output = scheduler.submit(samples[s]).get();
+                    if(!all_close(output, expected[s], 1e-12)) matches[c] = false;
+                }
+            }));
+        }
+        for(int c = 0; c < num_clients; c++) clients[c].join();
+
+        for(int c = 0; c < num_clients; c++){
+            if(!matches[c]){
+                std::cout << "Output of client " << c << " does not match forward" << std::endl;
+                return TEST_FAIL;
+            }
+        }
+
+        BatchSchedulerStats stats = scheduler.stats();
+        long int batched = 0, batches = 0;
+        for(size_t size = 1; size < stats.batch_sizes.size(); size++){
+            batched += size * stats.batch_sizes[size];
+            batches += stats.batch_sizes[size];
+        }
+        if(stats.requests != num_samples || batched != num_samples || batches != stats.batches){
+            std::cout << "The batch sizes do not add up to the requests: " << batched << " of " << stats.requests << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    // The samples still queued are run when the scheduler is destroyed
+    std::future<Tensor> pending;
+    {
+        BatchScheduler scheduler(model, 16, 10000.0);
+        pending = scheduler.submit(samples[1]);
+    }
+    if(pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+        std::cout << "A queued sample was dropped by the destructor" << std::endl;
+        return TEST_FAIL;
+    }
+    Tensor pending_output = pending.get();
+    if(!all_close(pending_output, expected[1], 1e-12)){
+        std::cout << "Output of the queued sample does not match forward" << std::endl;
+        return TEST_FAIL;
+    }
+
+    try{
+        BatchScheduler scheduler(model);
+        Tensor wrong_size({31});
+        scheduler.submit(wrong_size);
+        std::cout << "A sample of the wrong size was accepted" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    try{
+        BatchScheduler scheduler(model, 0);
+        std::cout << "A maximum batch size of 0 was accepted" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "plain_nn.hpp"
+#include "allocation_counter.hpp"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+bool all_close(Tensor& a, Tensor& b, double tol){
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++){
+        if(std::fabs(a[i] - b[i]) > tol) return false;
+    }
+    return true;
+}
+
+int main(){
+
+    PlainNN model;
+    model.add_layer(new Input({32}));
+    model.add_layer(new Dense(24, new ReLU()));
+    model.add_layer(new Dense(16, new Tanh()));
+    model.add_layer(new Dense(10, new Softmax()));
+
+    // Single samples
+    Tensor sample({32});
+    for(int i = 0; i < sample.size(); i++) sample[i] = 0.05 * i - 0.7;
+
+    Tensor expected = model.forward(sample);
+
+    model.compile();
+    Tensor& output = model.predict(sample);
+    if(!all_close(output, expected, 1e-12)){
+        std::cout << "predict does not match forward for a single sample" << std::endl;
+        return TEST_FAIL;
+    }
+
+    long int allocations = allocation_count();
+    for(int i = 0; i < 10; i++) model.predict(sample);
+    if(allocation_count() != allocations){
+        std::cout << "Steady-state predict allocated " << allocation_count() - allocations << " times" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Batches up to the planned size
+    Tensor batch({8, 32});
+    for(int i = 0; i < batch.size(); i++) batch[i] = std::sin(0.1 * i);
+    Tensor expected_batch = model.forward(batch);
+
+    model.compile(8);
+    Tensor& output_batch = model.predict(batch);
+    if(!all_close(output_batch, expected_batch, 1e-12)){
+        std::cout << "predict does not match forward for a batch" << std::endl;
+        return TEST_FAIL;
+    }
+
+    allocations = allocation_count();
+    for(int i = 0; i < 10; i++) model.predict(batch);
+    if(allocation_count() != allocations){
+        std::cout << "Steady-state batched predict allocated " << allocation_count() - allocations << " times" << std::endl;
+        return TEST_FAIL;
+    }
+
+    Tensor too_large({9, 32});
+    try{
+        model.predict(too_large);
+        std::cout << "predict accepted a batch larger than the plan" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    // Threads running at the same time, each with its own plan
+    if(model.input_size() != 32 || model.output_size() != 10){
+        std::cout << "Unexpected input and output size: " << model.input_size() << ", " << model.output_size() << std::endl;
+        return TEST_FAIL;
+    }
+
+    const int num_threads = 4;
+    std::vector<InferencePlan> plans;
+    for(int i = 0; i < num_threads; i++) plans.push_back(model.create_inference_plan(8));
+
+    std::vector<bool> matches(num_threads, true);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < num_threads; i++){
+        threads.push_back(std::thread([&, i]{
+            for(int pass = 0; pass < 50; pass++){
+                Tensor& thread_output = model.predict(batch, plans[i]);
+                if(!all_close(thread_output, expected_batch, 1e-12)) matches[i] = false;
+            }
+        }));
+    }
+    for(int i = 0; i < num_threads; i++) threads[i].join();
+    for(int i = 0; i < num_threads; i++){
+        if(!matches[i]){
+            std::cout << "predict with the plan of thread " << i << " does not match forward" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    model.add_layer(new Dense(4, new Sigmoid()));
+    try{
+        model.predict(batch, plans[0]);
+        std::cout << "predict accepted a plan created before a layer was added" << std::endl;
+        return TEST_FAIL;
+    } catch(std::runtime_error& e){}
+
+    return TEST_SUCCESS;
+}
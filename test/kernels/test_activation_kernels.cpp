@@ -0,0 +1,164 @@
+#include "kernels.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+template<typename T>
+bool all_close(const std::vector<T>& a, const std::vector<T>& b, const std::string& name, double tol){
+    for(size_t i = 0; i < a.size(); i++){
+        if(std::fabs(a[i] - b[i]) > tol * (1 + std::fabs(b[i]))){
+            std::cout << name << " mismatch at " << i << ": " << a[i] << " != " << b[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool check_elementwise(
+    void (*kernel)(int n, const T* x, T* out), void (*reference)(int n, const T* x, T* out),
+    const std::vector<T>& x, const std::string& name, double tol
+){
+    std::vector<T> out(x.size()), out_ref(x.size());
+    kernel(x.size(), x.data(), out.data());
+    reference(x.size(), x.data(), out_ref.data());
+    return all_close(out, out_ref, name, tol);
+}
+
+template<typename T>
+bool check_backward(
+    void (*kernel)(int n, const T* y, const T* dy, T* out), void (*derivative)(int n, const T* y, T* out),
+    const std::vector<T>& y, const std::vector<T>& dy, const std::string& name, double tol
+){
+    // The fused kernel runs in place on the gradients and must
+    // match the derivative multiplied by the gradients
+    std::vector<T> out(dy), out_ref(y.size());
+    kernel(y.size(), y.data(), out.data(), out.data());
+    derivative(y.size(), y.data(), out_ref.data());
+    for(size_t i = 0; i < y.size(); i++) out_ref[i] *= dy[i];
+    return all_close(out, out_ref, name, tol);
+}
+
+template<typename T>
+bool check_update(const BasicKernelTable<T>& k, const BasicKernelTable<T>& ref, const std::vector<T>& x, const std::vector<T>& y, double tol){
+    BasicUpdateParams<T> p;
+    p.lr = (T) 0.01;
+    p.scale = (T) 0.25;
+    p.beta1 = (T) 0.9;
+    p.beta2 = (T) 0.999;
+    p.eps = (T) 1e-8;
+    p.weight_decay = (T) 0.01;
+    p.bias_correction1 = 1 - p.beta1;
+    p.bias_correction2 = 1 - p.beta2;
+
+    const char* names[] = {"sgd_update", "momentum_update", "nesterov_update", "adam_update"};
+    for(int kernel = 0; kernel < 4; kernel++){
+        // The state starts from non zero values, as after some steps
+        std::vector<T> w(y), w_ref(y), g(x), g_ref(x);
+        std::vector<T> m(x), m_ref(x), v(y), v_ref(y);
+        for(int n = x.size(); n > 0; n -= x.size() / 2){
+            switch(kernel){
+                case 0:
+                    k.sgd_update(n, p, w.data(), g.data());
+                    ref.sgd_update(n, p, w_ref.data(), g_ref.data());
+                    break;
+                case 1:
+                    k.momentum_update(n, p, w.data(), g.data(), v.data());
+                    ref.momentum_update(n, p, w_ref.data(), g_ref.data(), v_ref.data());
+                    break;
+                case 2:
+                    k.nesterov_update(n, p, w.data(), g.data(), v.data());
+                    ref.nesterov_update(n, p, w_ref.data(), g_ref.data(), v_ref.data());
+                    break;
+                case 3:
+                    k.adam_update(n, p, w.data(), g.data(), m.data(), v.data());
+                    ref.adam_update(n, p, w_ref.data(), g_ref.data(), m_ref.data(), v_ref.data());
+                    break;
+            }
+            // Only the first n gradients are cleared
+            for(int i = 0; i < n; i++){
+                if(g[i] != 0){
+                    std::cout << names[kernel] << " did not clear the gradient at " << i << std::endl;
+                    return false;
+                }
+            }
+            for(size_t i = n; i < g.size(); i++) g[i] = g_ref[i] = x[i];
+        }
+        if(!all_close(w, w_ref, names[kernel], tol)) return false;
+        if(!all_close(m, m_ref, names[kernel], tol)) return false;
+        if(!all_close(v, v_ref, names[kernel], tol)) return false;
+    }
+    return true;
+}
+
+template<typename T>
+bool check_kernels(double tol){
+
+    // Odd size to exercise the vector tails, values span
+    // the range where exp under and overflows
+    const int rows = 7, cols = 37;
+    std::vector<T> x(rows * cols), y(rows * cols);
+    for(size_t i = 0; i < x.size(); i++){
+        x[i] = ((T) std::rand() / RAND_MAX - 0.5) * 40;
+        y[i] = (T) std::rand() / RAND_MAX;
+    }
+    x[0] = -800; x[1] = 800; x[2] = 0; x[3] = (T) -1e-300;
+
+    const BasicKernelTable<T>& ref = scalar_kernels<T>();
+
+    for(int isa = ISA_AVX2; isa <= detect_isa_level(); isa++){
+        set_isa_level((IsaLevel) isa);
+        const BasicKernelTable<T>& k = get_kernels<T>();
+        std::cout << "Checking " << ISA_LEVEL_NAMES[k.isa] << " kernels (" << sizeof(T) * 8 << " bit)" << std::endl;
+
+        if(!check_elementwise(k.relu, ref.relu, x, "relu", tol)) return false;
+        if(!check_elementwise(k.relu_derivative, ref.relu_derivative, x, "relu_derivative", tol)) return false;
+        if(!check_elementwise(k.sigmoid, ref.sigmoid, x, "sigmoid", tol)) return false;
+        if(!check_elementwise(k.sigmoid_derivative, ref.sigmoid_derivative, y, "sigmoid_derivative", tol)) return false;
+        if(!check_elementwise(k.tanh, ref.tanh, x, "tanh", tol)) return false;
+        if(!check_elementwise(k.tanh_derivative, ref.tanh_derivative, y, "tanh_derivative", tol)) return false;
+        if(!check_backward(k.relu_backward, ref.relu_derivative, x, y, "relu_backward", tol)) return false;
+        if(!check_backward(k.sigmoid_backward, ref.sigmoid_derivative, y, x, "sigmoid_backward", tol)) return false;
+        if(!check_backward(k.tanh_backward, ref.tanh_derivative, y, x, "tanh_backward", tol)) return false;
+
+        std::vector<T> out(x.size()), out_ref(x.size());
+        k.softmax(rows, cols, y.data(), out.data());
+        ref.softmax(rows, cols, y.data(), out_ref.data());
+        if(!all_close(out, out_ref, "softmax", tol)) return false;
+
+        // In place on the gradients, as done by the softmax activation
+        std::vector<T> probs(out_ref);
+        out = x; out_ref = x;
+        k.softmax_backward(rows, cols, probs.data(), out.data(), out.data());
+        ref.softmax_backward(rows, cols, probs.data(), out_ref.data(), out_ref.data());
+        if(!all_close(out, out_ref, "softmax_backward", tol)) return false;
+
+        out = y; out_ref = y;
+        k.bias_add(rows, cols, x.data(), out.data());
+        ref.bias_add(rows, cols, x.data(), out_ref.data());
+        if(!all_close(out, out_ref, "bias_add", tol)) return false;
+
+        std::vector<unsigned char> pixels(x.size());
+        for(size_t i = 0; i < pixels.size(); i++) pixels[i] = (unsigned char) (i * 37);
+        k.scale_u8(pixels.size(), pixels.data(), (T) (1 / 255.0), out.data());
+        ref.scale_u8(pixels.size(), pixels.data(), (T) (1 / 255.0), out_ref.data());
+        if(!all_close(out, out_ref, "scale_u8", tol)) return false;
+
+        if(!check_update(k, ref, x, y, tol)) return false;
+    }
+
+    return true;
+}
+
+int main(){
+
+    if(!check_kernels<double>(1e-12)) return TEST_FAIL;
+    if(!check_kernels<float>(1e-5)) return TEST_FAIL;
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include "gemm.hpp"
+#include "kernels.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+// Straightforward triple loop used as the reference result,
+// always accumulated in double precision
+template<typename T>
+void reference_gemm(
+    GemmTranspose trans_a, GemmTranspose trans_b,
+    int m, int n, int k, double alpha,
+    const T* a, int lda, const T* b, int ldb,
+    double beta, T* c, int ldc
+){
+    for(int i = 0; i < m; i++){
+        for(int j = 0; j < n; j++){
+            double acc = 0;
+            for(int p = 0; p < k; p++){
+                double _a = (trans_a == NO_TRANS) ? a[i * lda + p] : a[p * lda + i];
+                double _b = (trans_b == NO_TRANS) ? b[p * ldb + j] : b[j * ldb + p];
+                acc += _a * _b;
+            }
+            c[i * ldc + j] = alpha * acc + beta * c[i * ldc + j];
+        }
+    }
+}
+
+template<typename T>
+bool check(GemmTranspose trans_a, GemmTranspose trans_b, int m, int n, int k, T beta, double tol){
+    int lda = (trans_a == NO_TRANS) ? k : m;
+    int ldb = (trans_b == NO_TRANS) ? n : k;
+    std::vector<T> a(m * k), b(k * n), c(m * n), c_ref;
+
+    for(size_t i = 0; i < a.size(); i++) a[i] = (T) std::rand() / RAND_MAX - 0.5;
+    for(size_t i = 0; i < b.size(); i++) b[i] = (T) std::rand() / RAND_MAX - 0.5;
+    for(size_t i = 0; i < c.size(); i++) c[i] = (T) std::rand() / RAND_MAX - 0.5;
+    c_ref = c;
+
+    gemm(trans_a, trans_b, m, n, k, (T) 0.5, a.data(), lda, b.data(), ldb, beta, c.data(), n);
+    reference_gemm(trans_a, trans_b, m, n, k, 0.5, a.data(), lda, b.data(), ldb, beta, c_ref.data(), n);
+
+    for(size_t i = 0; i < c.size(); i++){
+        if(std::fabs(c[i] - c_ref[i]) > tol * (1 + k)){
+            std::cout << "Mismatch (" << sizeof(T) * 8 << " bit) for m=" << m << " n=" << n << " k=" << k 
+                << " trans_a=" << trans_a << " trans_b=" << trans_b << " beta=" << beta
+                << " at " << i << ": " << c[i] << " != " << c_ref[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool check_epilogue(int m, int n, int k, bool row_activation, double tol){
+    std::vector<T> a(m * k), b(k * n), bias(n), c(m * n), c_ref(m * n);
+
+    for(size_t i = 0; i < a.size(); i++) a[i] = (T) std::rand() / RAND_MAX - 0.5;
+    for(size_t i = 0; i < b.size(); i++) b[i] = (T) std::rand() / RAND_MAX - 0.5;
+    for(size_t i = 0; i < bias.size(); i++) bias[i] = (T) std::rand() / RAND_MAX - 0.5;
+
+    const BasicKernelTable<T>& kernels = get_kernels<T>();
+    BasicGemmEpilogue<T> epilogue = {bias.data(), nullptr, nullptr};
+    if(row_activation) epilogue.row_activation = kernels.softmax;
+    else epilogue.activation = kernels.tanh;
+
+    gemm(NO_TRANS, NO_TRANS, m, n, k, (T) 1, a.data(), k, b.data(), n, (T) 0, c.data(), n, epilogue);
+
+    // The same operations as separate passes
+    gemm(NO_TRANS, NO_TRANS, m, n, k, (T) 1, a.data(), k, b.data(), n, (T) 0, c_ref.data(), n);
+    kernels.bias_add(m, n, bias.data(), c_ref.data());
+    if(row_activation) kernels.softmax(m, n, c_ref.data(), c_ref.data());
+    else kernels.tanh(m * n, c_ref.data(), c_ref.data());
+
+    for(size_t i = 0; i < c.size(); i++){
+        if(std::fabs(c[i] - c_ref[i]) > tol){
+            std::cout << "Epilogue mismatch (" << sizeof(T) * 8 << " bit) for m=" << m << " n=" << n << " k=" << k
+                << " row_activation=" << row_activation << " at " << i << ": " << c[i] << " != " << c_ref[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(){
+
+    // Sizes chosen to hit the edges of the register tiles and
+    // of the cache blocks as well as the matrix-vector fast path
+    const int sizes[][3] = {
+        {1, 1, 1}, {1, 10, 128}, {3, 5, 7}, {64, 128, 784},
+        {97, 33, 300}, {130, 257, 19}, {8, 2100, 9}
+    };
+
+    // Every instruction set supported by the CPU is checked
+    for(int isa = ISA_SCALAR; isa <= detect_isa_level(); isa++){
+        set_isa_level((IsaLevel) isa);
+        std::cout << "Checking " << ISA_LEVEL_NAMES[isa] << " kernels" << std::endl;
+
+        for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+            for(int ta = 0; ta < 2; ta++){
+                for(int tb = 0; tb < 2; tb++){
+                    GemmTranspose _ta = (GemmTranspose) ta, _tb = (GemmTranspose) tb;
+                    if(!check<double>(_ta, _tb, sizes[s][0], sizes[s][1], sizes[s][2], 0.0, 1e-9)) return TEST_FAIL;
+                    if(!check<double>(_ta, _tb, sizes[s][0], sizes[s][1], sizes[s][2], 1.0, 1e-9)) return TEST_FAIL;
+                    if(!check<float>(_ta, _tb, sizes[s][0], sizes[s][1], sizes[s][2], 0.0f, 1e-5)) return TEST_FAIL;
+                    if(!check<float>(_ta, _tb, sizes[s][0], sizes[s][1], sizes[s][2], 1.0f, 1e-5)) return TEST_FAIL;
+                }
+            }
+
+            for(int row_activation = 0; row_activation < 2; row_activation++){
+                if(!check_epilogue<double>(sizes[s][0], sizes[s][1], sizes[s][2], row_activation, 1e-12)) return TEST_FAIL;
+                if(!check_epilogue<float>(sizes[s][0], sizes[s][1], sizes[s][2], row_activation, 1e-6)) return TEST_FAIL;
+            }
+        }
+    }
+
+    return TEST_SUCCESS;
+}
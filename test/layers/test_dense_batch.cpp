@@ -0,0 +1,86 @@
+#include "plain_nn.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+bool all_close(Tensor& a, Tensor& b, double tol = 1e-9){
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++){
+        if(std::fabs(a[i] - b[i]) > tol) return false;
+    }
+    return true;
+}
+
+int main(){
+
+    const int batch_size = 8, input_size = 17, hidden_size = 13, output_size = 5;
+
+    Dense hidden(input_size, hidden_size, new ReLU());
+    Dense last(hidden_size, output_size, new Sigmoid());
+
+    // Make both copies of the layers share the same parameters
+    Dense hidden_ref(input_size, hidden_size, new ReLU());
+    Dense last_ref(hidden_size, output_size, new Sigmoid());
+    std::vector<double> params = hidden.get_saveable_params();
+    hidden_ref.load_params(params);
+    params = last.get_saveable_params();
+    last_ref.load_params(params);
+
+    std::vector<Tensor> inputs, targets;
+    for(int b = 0; b < batch_size; b++){
+        Tensor input({input_size}, true);
+        inputs.push_back(input);
+        targets.push_back(one_hot_encode(b % output_size, output_size));
+    }
+
+    // Batched pass over the whole batch
+    Tensor input_batch = stack(inputs);
+    Tensor target_batch = stack(targets);
+
+    Tensor& hidden_out = hidden.forward(input_batch);
+    Tensor& batch_out = last.forward(hidden_out);
+    Tensor last_grads = last.backward(&hidden.output, nullptr, &target_batch);
+    hidden.backward(&input_batch, last.get_params(), &last_grads);
+
+    // Reference pass, one sample at a time
+    std::vector<Tensor> sample_outputs;
+    for(int b = 0; b < batch_size; b++){
+        Tensor& h = hidden_ref.forward(inputs[b]);
+        Tensor out = last_ref.forward(h);
+        sample_outputs.push_back(out);
+        Tensor g = last_ref.backward(&hidden_ref.output, nullptr, &targets[b]);
+        hidden_ref.backward(&inputs[b], last_ref.get_params(), &g);
+    }
+    Tensor ref_out = stack(sample_outputs);
+
+    if(batch_out.shape(0) != batch_size || batch_out.shape(1) != output_size){
+        std::cout << "Unexpected batched output shape: " << batch_out.shape_str() << std::endl;
+        return TEST_FAIL;
+    }
+
+    if(!all_close(batch_out, ref_out)){
+        std::cout << "Batched forward does not match per sample forward" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // After a step with the same accumulated gradients the parameters must match
+    hidden.step(0.1, batch_size); last.step(0.1, batch_size);
+    hidden_ref.step(0.1, batch_size); last_ref.step(0.1, batch_size);
+
+    Tensor* w = hidden.get_params(); Tensor* w_ref = hidden_ref.get_params();
+    if(!all_close(*w, *w_ref)){
+        std::cout << "Batched gradients do not match per sample gradients (hidden)" << std::endl;
+        return TEST_FAIL;
+    }
+    w = last.get_params(); w_ref = last_ref.get_params();
+    if(!all_close(*w, *w_ref)){
+        std::cout << "Batched gradients do not match per sample gradients (last)" << std::endl;
+        return TEST_FAIL;
+    }
+
+    return TEST_SUCCESS;
+}
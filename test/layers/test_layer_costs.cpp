@@ -0,0 +1,99 @@
+#include "plain_nn.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+void build_model(PlainNN& model, Optimizer* optimizer){
+    model.add_layer(new Input({20}));
+    model.add_layer(new Dense(16, new ReLU()));
+    model.add_layer(new Dense(8, new Sigmoid()));
+    model.add_layer(new Dense(4, new Softmax()));
+    model.set_loss(new CrossEntropy());
+    model.set_optimizer(optimizer);
+}
+
+bool check_cost(LayerCost& cost, long int forward_flops, long int backward_flops, long int activation_bytes,
+        long int gradient_bytes, long int optimizer_bytes, const char* layer){
+    if(cost.forward_flops != forward_flops || cost.backward_flops != backward_flops || cost.activation_bytes != activation_bytes
+        || cost.gradient_bytes != gradient_bytes || cost.optimizer_bytes != optimizer_bytes){
+        std::cout << "Unexpected cost of " << layer << ": " << cost.forward_flops << " forward FLOPs, "
+            << cost.backward_flops << " backward FLOPs, " << cost.activation_bytes << " activation bytes, "
+            << cost.gradient_bytes << " gradient bytes, " << cost.optimizer_bytes << " optimizer bytes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(){
+
+    const long int d = sizeof(double);
+
+    PlainNN model;
+    build_model(model, new Adam());
+    std::vector<LayerCost> costs = model.layer_costs();
+    if(costs.size() != 4){
+        std::cout << "Expected a cost per layer, got " << costs.size() << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Forward: 2 * in * out, the biases and the activation. Backward: the
+    // gradients of the weights and biases, the derivative of the activation,
+    // which the softmax skips when fused with the cross entropy, and the
+    // gradients of the input for all but the first layer
+    if(!check_cost(costs[0], 0, 0, 0, 0, 0, "the input")) return TEST_FAIL;
+    if(!check_cost(costs[1], 2 * 20 * 16 + 16 + 16 * 1, 2 * 20 * 16 + 16 + 16 * 1,
+        2 * 16 * d, (20 * 16 + 16) * d, 2 * (20 * 16 + 16) * d, "dense")) return TEST_FAIL;
+    if(!check_cost(costs[2], 2 * 16 * 8 + 8 + 8 * 4, 2 * 16 * 8 + 8 + 8 * 3 + 2 * 16 * 8,
+        2 * 8 * d, (16 * 8 + 8) * d, 2 * (16 * 8 + 8) * d, "dense_1")) return TEST_FAIL;
+    if(!check_cost(costs[3], 2 * 8 * 4 + 4 + 4 * 5, 2 * 8 * 4 + 4 + 2 * 8 * 4,
+        2 * 4 * d, (8 * 4 + 4) * d, 2 * (8 * 4 + 4) * d, "dense_2")) return TEST_FAIL;
+
+    // The parameters are read once per batch, a larger batch moves fewer bytes per sample
+    std::vector<LayerCost> batch_costs = model.layer_costs(64);
+    for(size_t layer_idx = 1; layer_idx < costs.size(); layer_idx++){
+        if(!(batch_costs[layer_idx].bytes_per_sample < costs[layer_idx].bytes_per_sample)
+            || batch_costs[layer_idx].forward_flops != costs[layer_idx].forward_flops){
+            std::cout << "The cost per sample of layer " << layer_idx << " does not scale with the batch size" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    // A frozen layer has no backward pass, gradients nor optimizer
+    // state, and the next layer does not propagate its gradients
+    model.freeze_layer(1);
+    costs = model.layer_costs();
+    if(costs[1].trainable || costs[1].param_count != 20 * 16 + 16){
+        std::cout << "The frozen layer is reported as trainable" << std::endl;
+        return TEST_FAIL;
+    }
+    if(!check_cost(costs[1], 2 * 20 * 16 + 16 + 16 * 1, 0, 16 * d, 0, 0, "the frozen dense")) return TEST_FAIL;
+    if(!check_cost(costs[2], 2 * 16 * 8 + 8 + 8 * 4, 2 * 16 * 8 + 8 + 8 * 3,
+        2 * 8 * d, (16 * 8 + 8) * d, 2 * (16 * 8 + 8) * d, "dense_1 after the frozen layer")) return TEST_FAIL;
+
+    // The state kept per parameter by each optimizer
+    Optimizer* optimizers[] = {new SGDOptimizer(), new Momentum(), new Adam()};
+    for(int state_size = 0; state_size < 3; state_size++){
+        PlainNN optimized;
+        build_model(optimized, optimizers[state_size]);
+        LayerCost cost = optimized.layer_costs()[1];
+        if(cost.optimizer_bytes != state_size * cost.param_count * d){
+            std::cout << "Unexpected state of " << optimizers[state_size]->name() << ": " << cost.optimizer_bytes << " bytes" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    try{
+        model.layer_costs(0);
+        std::cout << "A batch size of 0 was accepted" << std::endl;
+        return TEST_FAIL;
+    } catch(const std::runtime_error&){}
+
+    model.summary(32);
+
+    return TEST_SUCCESS;
+}
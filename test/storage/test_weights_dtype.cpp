@@ -0,0 +1,98 @@
+#include "plain_nn.hpp"
+#include "model_storage.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+template<typename A, typename B>
+bool all_close(BasicTensor<A>& a, BasicTensor<B>& b, double tol){
+    if(a.size() != b.size()) return false;
+    for(int i = 0; i < a.size(); i++){
+        if(std::fabs((double) a[i] - (double) b[i]) > tol) return false;
+    }
+    return true;
+}
+
+template<typename T>
+void build_model(BasicPlainNN<T>& model){
+    model.add_layer(new BasicInput<T>({12}));
+    model.add_layer(new BasicDense<T>(7, new BasicReLU<T>()));
+    model.add_layer(new BasicDense<T>(3, new BasicSigmoid<T>()));
+}
+
+template<typename T>
+BasicTensor<T> make_input(){
+    BasicTensor<T> input({12});
+    for(int i = 0; i < input.size(); i++) input[i] = (T) (0.1 * i - 0.5);
+    return input;
+}
+
+int main(){
+
+    // float32 model saved and loaded back both as float32 and float64
+    PlainNNF model_f;
+    build_model(model_f);
+    model_f.save("weights_dtype_f32");
+
+    TensorF input_f = make_input<float>();
+    TensorF expected_f = model_f.forward(input_f);
+
+    PlainNNF loaded_f;
+    loaded_f.load("weights_dtype_f32");
+    TensorF output_f = loaded_f.forward(input_f);
+    if(!all_close(output_f, expected_f, 0)){
+        std::cout << "float32 model does not match after a float32 round trip" << std::endl;
+        return TEST_FAIL;
+    }
+
+    PlainNN loaded_d;
+    loaded_d.load("weights_dtype_f32");
+    if(loaded_d.get_layer(1)->get_summary().param_size != sizeof(double)){
+        std::cout << "float32 weights were not converted to float64" << std::endl;
+        return TEST_FAIL;
+    }
+    Tensor input_d = make_input<double>();
+    Tensor output_d = loaded_d.forward(input_d);
+    if(!all_close(output_d, expected_f, 1e-5)){
+        std::cout << "float32 model does not match when loaded as float64" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // float64 model loaded as float32
+    PlainNN model_d;
+    build_model(model_d);
+    model_d.save("weights_dtype_f64");
+    Tensor expected_d = model_d.forward(input_d);
+
+    PlainNNF converted_f;
+    converted_f.load("weights_dtype_f64");
+    output_f = converted_f.forward(input_f);
+    if(!all_close(output_f, expected_d, 1e-5)){
+        std::cout << "float64 model does not match when loaded as float32" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Weights files without the header hold raw float64 parameters
+    std::ofstream legacy_file("weights_dtype_legacy" + MODEL_WEIGHTS_FILE_EXT, std::ios::binary);
+    for(int layer_idx = 0; layer_idx < 3; layer_idx++){
+        std::vector<double> params = model_d.get_layer(layer_idx)->get_saveable_params();
+        legacy_file.write((char*)params.data(), params.size() * sizeof(double));
+    }
+    legacy_file.close();
+
+    PlainNN legacy;
+    build_model(legacy);
+    legacy.load("weights_dtype_legacy", true);
+    output_d = legacy.forward(input_d);
+    if(!all_close(output_d, expected_d, 0)){
+        std::cout << "Legacy float64 weights file was not loaded correctly" << std::endl;
+        return TEST_FAIL;
+    }
+
+    return TEST_SUCCESS;
+}
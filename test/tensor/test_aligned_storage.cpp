@@ -0,0 +1,132 @@
+#include "plain_nn.hpp"
+
+#include <iostream>
+#include <cstdint>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+bool is_aligned(const void* ptr, size_t alignment){
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+template<typename T>
+bool check_small_tensors(){
+    for(int size = 1; size <= 100; size++){
+        BasicTensor<T> tensor({size});
+        BasicTensor<T> random({size, 3}, true);
+        if(!is_aligned(tensor.data(), BUFFER_ALIGNMENT) || !is_aligned(random.data(), BUFFER_ALIGNMENT)){
+            std::cout << "Tensor of " << size << " elements is not aligned to " << BUFFER_ALIGNMENT << " bytes" << std::endl;
+            return false;
+        }
+
+        tensor.reshape({size + 1, 2});
+        if(!is_aligned(tensor.data(), BUFFER_ALIGNMENT)){
+            std::cout << "Reshaped tensor of " << size << " elements is not aligned" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// A large tensor lives on its own huge page aligned mapping
+template<typename T>
+bool check_large_tensor(HugePageMode mode){
+    set_huge_page_mode(mode);
+
+    int rows = 1024, cols = 1536;
+    BasicTensor<T> tensor({rows, cols});
+    if(!is_aligned(tensor.data(), HUGE_PAGE_SIZE)){
+        std::cout << "Large tensor is not aligned to a huge page with mode " << HUGE_PAGE_MODE_NAMES[mode] << std::endl;
+        return false;
+    }
+
+    for(int i = 0; i < tensor.size(); i++){
+        if(tensor[i] != 0){
+            std::cout << "Large tensor is not zero initialized at " << i << std::endl;
+            return false;
+        }
+        tensor[i] = (T) (i % 97);
+    }
+
+    // The copy gets a mapping of its own
+    BasicTensor<T> copy = tensor;
+    if(copy.data() == tensor.data() || !is_aligned(copy.data(), HUGE_PAGE_SIZE)){
+        std::cout << "Copy of a large tensor does not have its own aligned storage" << std::endl;
+        return false;
+    }
+    for(int i = 0; i < copy.size(); i++){
+        if(copy[i] != (T) (i % 97)){
+            std::cout << "Copy of a large tensor differs at " << i << std::endl;
+            return false;
+        }
+    }
+
+    // Shrinking below a huge page goes back to the regular allocator
+    copy.reshape({16});
+    if(!is_aligned(copy.data(), BUFFER_ALIGNMENT)){
+        std::cout << "Shrunk tensor is not aligned" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(){
+
+    if(huge_page_mode() != HUGE_PAGES_TRANSPARENT){
+        std::cout << "Expected transparent huge pages by default, got " << HUGE_PAGE_MODE_NAMES[huge_page_mode()] << std::endl;
+        return TEST_FAIL;
+    }
+
+    if(!check_small_tensors<double>() || !check_small_tensors<float>()){
+        return TEST_FAIL;
+    }
+
+    // Without reserved huge pages the explicit mode falls back to transparent ones
+    const HugePageMode modes[] = {HUGE_PAGES_OFF, HUGE_PAGES_TRANSPARENT, HUGE_PAGES_EXPLICIT};
+    for(HugePageMode mode : modes){
+        if(!check_large_tensor<double>(mode) || !check_large_tensor<float>(mode)){
+            return TEST_FAIL;
+        }
+    }
+    set_huge_page_mode(HUGE_PAGES_TRANSPARENT);
+
+    // Large arenas are zeroed and aligned, and survive being moved
+    AlignedBuffer buffer;
+    buffer.allocate(HUGE_PAGE_SIZE / sizeof(double) + 5);
+    if(!is_aligned(buffer.data(), HUGE_PAGE_SIZE)){
+        std::cout << "Large buffer is not aligned to a huge page" << std::endl;
+        return TEST_FAIL;
+    }
+    for(long int i = 0; i < buffer.size(); i++){
+        if(buffer.data()[i] != 0){
+            std::cout << "Large buffer is not zero initialized at " << i << std::endl;
+            return TEST_FAIL;
+        }
+        buffer.data()[i] = 1;
+    }
+    AlignedBuffer moved(std::move(buffer));
+    if(buffer.data() != nullptr || moved.data()[moved.size() - 1] != 1){
+        std::cout << "Moving a large buffer lost its elements" << std::endl;
+        return TEST_FAIL;
+    }
+    moved.allocate(10);
+    if(!is_aligned(moved.data(), BUFFER_ALIGNMENT) || moved.data()[9] != 0){
+        std::cout << "Small buffer reallocated over a large one is not aligned or not zeroed" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // The parameters of a model start on an aligned boundary
+    PlainNN model;
+    model.add_layer(new Input({784}));
+    model.add_layer(new Dense(512, new ReLU()));
+    model.add_layer(new Dense(10, new Softmax()));
+    Tensor params = model.parameters();
+    if(!is_aligned(params.data(), HUGE_PAGE_SIZE)){
+        std::cout << "Parameter arena of " << params.size() << " elements is not aligned to a huge page" << std::endl;
+        return TEST_FAIL;
+    }
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "plain_nn.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+int main(){
+
+    const int rows = 6, cols = 10;
+    Tensor tensor({rows, cols});
+    for(int i = 0; i < tensor.size(); i++) tensor[i] = i;
+
+    // Slicing the batch dimension gives a contiguous view of the rows
+    Tensor rows_view = tensor.slice(2, 5);
+    if(!rows_view.is_view() || !rows_view.is_contiguous() || rows_view.shape(0) != 3
+        || rows_view.size() != 3 * cols || rows_view.data() != tensor.data() + 2 * cols){
+        std::cout << "Unexpected slice of the rows " << rows_view.shape_str() << std::endl;
+        return TEST_FAIL;
+    }
+
+    // The view writes through to the tensor
+    rows_view[0] = -1;
+    if(tensor[2 * cols] != -1){
+        std::cout << "The view does not share the memory of the tensor" << std::endl;
+        return TEST_FAIL;
+    }
+    tensor[2 * cols] = 2 * cols;
+
+    // Slicing the features keeps the stride of the rows
+    Tensor cols_view = tensor.slice(3, 7, 1);
+    if(cols_view.is_contiguous() || cols_view.stride(0) != cols || cols_view.stride(1) != 1 || cols_view.size() != rows * 4){
+        std::cout << "Unexpected slice of the columns " << cols_view.shape_str() << std::endl;
+        return TEST_FAIL;
+    }
+
+    Tensor copy = cols_view.contiguous();
+    for(int r = 0; r < rows; r++){
+        for(int c = 0; c < 4; c++){
+            if(copy[r * 4 + c] != r * cols + c + 3){
+                std::cout << "Wrong contiguous copy at " << r << ", " << c << std::endl;
+                return TEST_FAIL;
+            }
+        }
+    }
+
+    // Only the viewed elements are cleared
+    Tensor cleared({rows, cols}, false, 1);
+    cleared.slice(3, 7, 1).clear();
+    for(int i = 0; i < cleared.size(); i++){
+        int c = i % cols;
+        double expected = (c >= 3 && c < 7) ? 0 : 1;
+        if(cleared[i] != expected){
+            std::cout << "Wrong element " << i << " after clearing a strided view" << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    // Changing the shape needs a contiguous view with as many elements
+    Tensor flat = tensor.view({rows * cols});
+    if(flat.ndim() != 1 || flat.data() != tensor.data()){
+        std::cout << "Unexpected flat view " << flat.shape_str() << std::endl;
+        return TEST_FAIL;
+    }
+    bool threw = false;
+    try{ cols_view.view({rows * 4}); } catch(std::runtime_error&){ threw = true; }
+    try{ tensor.view({7}); threw = false; } catch(std::runtime_error&){}
+    try{ tensor.slice(4, 7); threw = false; } catch(std::runtime_error&){}
+    if(!threw){
+        std::cout << "Invalid views did not throw" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Reshaping a view detaches it from the viewed memory
+    Tensor detached = tensor.slice(0, 2);
+    detached.reshape({2, cols}, false, 7);
+    if(detached.is_view() || tensor[0] != 0){
+        std::cout << "Reshaping a view wrote to the viewed tensor" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // A dense layer reads a slice of the features in place
+    Dense dense(4, 3, new Sigmoid());
+    Tensor& strided_output = dense.forward(cols_view);
+    std::vector<double> expected(strided_output.data(), strided_output.data() + strided_output.size());
+    Tensor& output = dense.forward(copy);
+    for(int i = 0; i < output.size(); i++){
+        if(std::fabs(output[i] - expected[i]) > 1e-12){
+            std::cout << "The output on a strided view differs at " << i << ": " << expected[i] << " != " << output[i] << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    return TEST_SUCCESS;
+}
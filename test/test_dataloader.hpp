@@ -0,0 +1,72 @@
+#ifndef PLAIN_NN_TEST_DATALOADER_H
+#define PLAIN_NN_TEST_DATALOADER_H
+
+#include "plain_nn.hpp"
+
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+/**
+ * @brief Deterministic in-memory dataset shared by the tests, never
+ * shuffled. The features are drawn with std::rand, sample i is of
+ * class i % classes.
+ */
+class TestDataLoader : public DataLoader{
+    public:
+        /**
+         * @brief Construct a new TestDataLoader object
+         *
+         * @param samples The number of samples
+         * @param features The number of features of a sample
+         * @param classes The number of classes
+         * @param input_offset Added to the features, drawn in [0, 1], default is 0
+         * @param drop_last Whether the last partial batch of an epoch is
+         * dropped, otherwise it holds the remaining samples, default is true
+         */
+        TestDataLoader(int samples, int features, int classes, double input_offset = 0, bool drop_last = true){
+            m_samples = samples;
+            m_features = features;
+            m_classes = classes;
+            m_drop_last = drop_last;
+            m_offset = 0;
+            m_inputs.resize(static_cast<size_t>(samples) * features);
+            for(size_t i = 0; i < m_inputs.size(); i++) m_inputs[i] = (double) std::rand() / RAND_MAX + input_offset;
+        }
+
+        void load(){}
+        void shuffle(){}
+        void new_epoch(){ m_offset = 0; }
+        int num_classes(){ return m_classes; }
+
+        int steps_per_epoch(int batch_size){
+            if(m_drop_last) return m_samples / batch_size;
+            return (m_samples + batch_size - 1) / batch_size;
+        }
+
+        void fill_batch(int batch_size, BatchData& batch){
+            if(m_offset + batch_size > m_samples && m_drop_last){
+                batch.targets_idx.clear();
+                return;
+            }
+
+            int count = std::max(std::min(batch_size, m_samples - m_offset), 0);
+            batch.resize(count, m_features, m_classes);
+            std::copy(m_inputs.data() + static_cast<size_t>(m_offset) * m_features,
+                m_inputs.data() + static_cast<size_t>(m_offset + count) * m_features, batch.input_data.data());
+            for(int i = 0; i < count; i++){
+                int target = (m_offset + i) % m_classes;
+                batch.targets_one_hot.data()[i * m_classes + target] = 1;
+                batch.targets_idx[i] = target;
+            }
+            m_offset += count;
+        }
+
+    protected:
+        // @brief The features of the samples, back to back
+        std::vector<double> m_inputs;
+        int m_samples, m_features, m_classes, m_offset;
+        bool m_drop_last;
+};
+
+#endif // PLAIN_NN_TEST_DATALOADER_H
@@ -0,0 +1,126 @@
+#include "plain_nn.hpp"
+#include "allocation_counter.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <type_traits>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+void build_model(PlainNN& model){
+    model.add_layer(new Input({20}));
+    model.add_layer(new Dense(16, new ReLU()));
+    model.add_layer(new Dense(4, new Softmax()));
+    model.set_loss(new CrossEntropy());
+}
+
+/**
+ * @brief Count the allocations of an epoch of training, after a first
+ * epoch has grown the buffers of the model to the batch size
+ */
+long int training_allocations(int batch_size, int steps){
+    TestDataLoader dataloader(batch_size * steps, 20, 4);
+    PlainNN model(1);
+    build_model(model);
+    model.train(dataloader, 0.01, 1, batch_size);
+
+    dataloader.new_epoch();
+    long int start = allocation_count();
+    model.train(dataloader, 0.01, 1, batch_size);
+    return allocation_count() - start;
+}
+
+/**
+ * @brief Count the allocations of an evaluation, after a first
+ * one has grown the buffers of the model to the batch size
+ */
+long int evaluation_allocations(int batch_size, int steps){
+    TestDataLoader dataloader(batch_size * steps, 20, 4);
+    PlainNN model(1);
+    build_model(model);
+    model.evaluate(dataloader, batch_size, false);
+
+    dataloader.new_epoch();
+    long int start = allocation_count();
+    model.evaluate(dataloader, batch_size, false);
+    return allocation_count() - start;
+}
+
+int main(){
+
+    static_assert(std::is_nothrow_move_constructible<Tensor>::value, "Tensor must be nothrow move constructible");
+    static_assert(std::is_nothrow_move_assignable<Tensor>::value, "Tensor must be nothrow move assignable");
+    static_assert(std::is_nothrow_move_constructible<BatchData>::value, "BatchData must be nothrow move constructible");
+
+    // Moving a tensor takes over its buffers
+    Tensor tensor({64, 64}, true);
+    double* _data = tensor.data();
+    long int start = allocation_count();
+    Tensor moved(std::move(tensor));
+    Tensor assigned;
+    assigned = std::move(moved);
+    if(allocation_count() != start || assigned.data() != _data){
+        std::cout << "Moving a tensor copied its elements" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // The elements given as an rvalue aligned vector are not copied
+    AlignedVector values(256, 1.0);
+    double* _values = values.data();
+    Tensor adopted({16, 16}, std::move(values));
+    if(adopted.data() != _values || adopted.size() != 256){
+        std::cout << "The elements of an rvalue vector were copied" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // The shape is returned without copying it
+    start = allocation_count();
+    const std::vector<int>& shape = adopted.shape();
+    if(allocation_count() != start || shape.size() != 2 || shape[1] != 16){
+        std::cout << "Querying the shape allocated" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Batches are swapped, e.g. by the prefetching loader, without allocating
+    BatchData a, b;
+    a.resize(32, 20, 4);
+    b.resize(32, 20, 4);
+    start = allocation_count();
+    std::swap(a, b);
+    if(allocation_count() != start){
+        std::cout << "Swapping two batches allocated" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Once the buffers have grown the number of allocations of
+    // a step does not depend on the number of samples in the batch
+    long int small_batches = training_allocations(8, 16);
+    long int large_batches = training_allocations(64, 16);
+    if(small_batches != large_batches){
+        std::cout << "Training allocates per sample: " << small_batches << " allocations with batches of 8, "
+            << large_batches << " with batches of 64" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // and a step only makes a few of them, for the views of
+    // the rows of the workers and the task of the thread pool
+    long int more_steps = training_allocations(8, 48);
+    double per_step = (double) (more_steps - small_batches) / 32;
+    if(per_step > 16){
+        std::cout << "Training makes " << per_step << " allocations per step" << std::endl;
+        return TEST_FAIL;
+    }
+
+    small_batches = evaluation_allocations(8, 16);
+    large_batches = evaluation_allocations(64, 16);
+    if(small_batches != large_batches){
+        std::cout << "Evaluation allocates per sample: " << small_batches << " allocations with batches of 8, "
+            << large_batches << " with batches of 64" << std::endl;
+        return TEST_FAIL;
+    }
+
+    return TEST_SUCCESS;
+}
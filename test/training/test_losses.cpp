@@ -0,0 +1,76 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+/**
+ * @brief Check the update of a single training step against the
+ * gradient of the loss computed with central differences
+ */
+bool check_gradient(ActivationFn* activation, Loss* loss, const char* label){
+    const int samples = 8, features = 6, classes = 4;
+    const double eps = 1e-6;
+
+    TestDataLoader dataloader(samples, features, classes, -0.5);
+
+    PlainNN model;
+    model.add_layer(new Input({features}));
+    model.add_layer(new Dense(classes, activation));
+    model.set_loss(loss);
+
+    std::vector<double> params = model.get_layer(1)->get_saveable_params();
+
+    std::vector<double> expected(params.size());
+    for(size_t i = 0; i < params.size(); i++){
+        std::vector<double> shifted(params);
+        shifted[i] = params[i] + eps;
+        model.get_layer(1)->load_params(shifted);
+        double loss_plus = model.evaluate(dataloader, samples, false).avg_loss * samples;
+        shifted[i] = params[i] - eps;
+        model.get_layer(1)->load_params(shifted);
+        double loss_minus = model.evaluate(dataloader, samples, false).avg_loss * samples;
+
+        // The parameters move along minus the gradient
+        expected[i] = -(loss_plus - loss_minus) / (2 * eps);
+    }
+    model.get_layer(1)->load_params(params);
+
+    // A single step over the whole dataset, the update is
+    // learning_rate / batch_size times the error signal
+    model.train(dataloader, samples, 1, samples);
+    std::vector<double> updated = model.get_layer(1)->get_saveable_params();
+
+    for(size_t i = 0; i < params.size(); i++){
+        double actual = updated[i] - params[i];
+        if(std::fabs(actual - expected[i]) > 1e-5 * (1 + std::fabs(expected[i]))){
+            std::cout << label << ": gradient of parameter " << i << " is " << actual << " instead of " << expected[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(){
+
+    // Fused with the activation of the output layer
+    if(!check_gradient(new Softmax(), new CrossEntropy(), "Softmax + CrossEntropy")) return TEST_FAIL;
+    if(!check_gradient(new Sigmoid(), new BinaryCrossEntropy(), "Sigmoid + BinaryCrossEntropy")) return TEST_FAIL;
+    if(!check_gradient(new None(), new MSELoss(), "None + MSE")) return TEST_FAIL;
+
+    // Through the derivative of the activation, for the softmax
+    // this needs the whole jacobian and not only its diagonal
+    if(!check_gradient(new Softmax(), new MSELoss(), "Softmax + MSE")) return TEST_FAIL;
+    if(!check_gradient(new Sigmoid(), new MSELoss(), "Sigmoid + MSE")) return TEST_FAIL;
+    if(!check_gradient(new Tanh(), new MSELoss(), "Tanh + MSE")) return TEST_FAIL;
+    if(!check_gradient(new Sigmoid(), new CrossEntropy(), "Sigmoid + CrossEntropy")) return TEST_FAIL;
+    if(!check_gradient(new Softmax(), new BinaryCrossEntropy(), "Softmax + BinaryCrossEntropy")) return TEST_FAIL;
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,166 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+const int SAMPLES = 16, FEATURES = 6, HIDDEN = 5, CLASSES = 3;
+
+void build_model(PlainNN& model, std::vector<std::vector<double> >& params){
+    model.add_layer(new Input({FEATURES}));
+    model.add_layer(new Dense(HIDDEN, new Tanh()));
+    model.add_layer(new Dense(CLASSES, new Softmax()));
+    model.set_loss(new CrossEntropy());
+
+    if(params.empty()){
+        params.resize(3);
+        for(int layer_idx = 1; layer_idx < 3; layer_idx++) params[layer_idx] = model.get_layer(layer_idx)->get_saveable_params();
+    } else{
+        for(int layer_idx = 1; layer_idx < 3; layer_idx++) model.get_layer(layer_idx)->load_params(params[layer_idx]);
+    }
+}
+
+/**
+ * @brief The error signal of a full batch step, scaled by 1 / batch_size,
+ * i.e. the update of a single SGD step with a learning rate of 1
+ */
+std::vector<double> batch_gradient(TestDataLoader& dataloader, std::vector<std::vector<double> > params){
+    PlainNN probe;
+    build_model(probe, params);
+    probe.train(dataloader, 1.0, 1, SAMPLES);
+
+    std::vector<double> grads;
+    for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+        std::vector<double> updated = probe.get_layer(layer_idx)->get_saveable_params();
+        for(size_t i = 0; i < updated.size(); i++) grads.push_back(updated[i] - params[layer_idx][i]);
+    }
+    return grads;
+}
+
+/**
+ * @brief Train a few steps with an optimizer and compare the parameters
+ * with the update rule applied to the gradients of the same steps
+ */
+bool check_optimizer(Optimizer* optimizer, double lr, const char* label){
+    const int steps = 5;
+    const double beta1 = 0.9, beta2 = 0.999, eps = 1e-8, weight_decay = 0.01;
+
+    TestDataLoader dataloader(SAMPLES, FEATURES, CLASSES, -0.5);
+
+    std::vector<std::vector<double> > params;
+    PlainNN model;
+    build_model(model, params);
+    model.set_optimizer(optimizer);
+
+    std::vector<double> m, v;
+    for(int t = 1; t <= steps; t++){
+        // Each call to train resumes from the state of the optimizer
+        model.train(dataloader, lr, 1, SAMPLES);
+
+        std::vector<double> g = batch_gradient(dataloader, params);
+        m.resize(g.size(), 0);
+        v.resize(g.size(), 0);
+
+        size_t offset = 0;
+        for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+            std::vector<double>& w = params[layer_idx];
+            for(size_t i = 0; i < w.size(); i++, offset++){
+                double d = g[offset];
+                switch(optimizer->type()){
+                    case OptimizerType::SGD:
+                        w[i] += lr * d;
+                        break;
+                    case OptimizerType::MOMENTUM:
+                        v[offset] = beta1 * v[offset] + d;
+                        w[i] += lr * v[offset];
+                        break;
+                    case OptimizerType::NESTEROV:
+                        v[offset] = beta1 * v[offset] + d;
+                        w[i] += lr * (d + beta1 * v[offset]);
+                        break;
+                    case OptimizerType::ADAM:
+                    case OptimizerType::ADAMW:
+                        m[offset] = beta1 * m[offset] + (1 - beta1) * d;
+                        v[offset] = beta2 * v[offset] + (1 - beta2) * d * d;
+                        if(optimizer->type() == OptimizerType::ADAMW) w[i] -= lr * weight_decay * w[i];
+                        w[i] += lr * (m[offset] / (1 - std::pow(beta1, t))) / (std::sqrt(v[offset] / (1 - std::pow(beta2, t))) + eps);
+                        break;
+                }
+            }
+        }
+
+        for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+            std::vector<double> actual = model.get_layer(layer_idx)->get_saveable_params();
+            for(size_t i = 0; i < actual.size(); i++){
+                if(std::fabs(actual[i] - params[layer_idx][i]) > 1e-9){
+                    std::cout << label << ": parameters of layer " << layer_idx << " differ at step " << t << " at " << i
+                        << ": " << actual[i] << " != " << params[layer_idx][i] << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Apply a few updates with update and update_relaxed to
+ * the same parameters and compare the results
+ */
+bool check_relaxed(Optimizer* plain, Optimizer* relaxed, const char* label){
+    const int n = 37, steps = 4;
+    std::vector<double> w_plain(n), w_relaxed(n), g_plain(n), g_relaxed(n);
+    for(int i = 0; i < n; i++) w_plain[i] = w_relaxed[i] = std::sin(0.3 * i);
+
+    plain->init(n);
+    relaxed->init(n);
+    for(int t = 0; t < steps; t++){
+        for(int i = 0; i < n; i++) g_plain[i] = g_relaxed[i] = std::cos(0.7 * i + t);
+        plain->begin_step();
+        relaxed->begin_step();
+        plain->update(0, n, w_plain.data(), g_plain.data(), 0.05, 0.5);
+        relaxed->update_relaxed(0, n, w_relaxed.data(), g_relaxed.data(), 0.05, 0.5);
+
+        for(int i = 0; i < n; i++){
+            if(std::fabs(w_plain[i] - w_relaxed[i]) > 1e-12 || g_relaxed[i] != 0){
+                std::cout << label << ": relaxed update differs at step " << t << " at " << i
+                    << ": " << w_relaxed[i] << " != " << w_plain[i] << std::endl;
+                return false;
+            }
+        }
+    }
+
+    delete plain;
+    delete relaxed;
+    return true;
+}
+
+int main(){
+
+    if(!check_optimizer(new SGDOptimizer(), 0.5, "SGD")) return TEST_FAIL;
+    if(!check_optimizer(new Momentum(0.9), 0.1, "Momentum")) return TEST_FAIL;
+    if(!check_optimizer(new Nesterov(0.9), 0.1, "Nesterov")) return TEST_FAIL;
+    if(!check_optimizer(new Adam(), 0.01, "Adam")) return TEST_FAIL;
+    if(!check_optimizer(new AdamW(0.01), 0.01, "AdamW")) return TEST_FAIL;
+
+    if(!check_relaxed(new SGDOptimizer(), new SGDOptimizer(), "SGD")) return TEST_FAIL;
+    if(!check_relaxed(new Momentum(0.9), new Momentum(0.9), "Momentum")) return TEST_FAIL;
+    if(!check_relaxed(new Nesterov(0.9), new Nesterov(0.9), "Nesterov")) return TEST_FAIL;
+    if(!check_relaxed(new AdamW(0.01), new AdamW(0.01), "AdamW")) return TEST_FAIL;
+
+    // The names follow the types, Momentum with nesterov is a Nesterov optimizer
+    Momentum nesterov(0.9, true);
+    if(nesterov.name() != "Nesterov" || AdamW().name() != "AdamW" || Adam().name() != "Adam"){
+        std::cout << "Unexpected optimizer names" << std::endl;
+        return TEST_FAIL;
+    }
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+bool same_result(EvaluationResult& expected, EvaluationResult& actual, const char* label){
+    bool same = expected.correct == actual.correct && expected.total == actual.total
+        && std::fabs(expected.accuracy - actual.accuracy) < 1e-12
+        && std::fabs(expected.avg_loss - actual.avg_loss) < 1e-9
+        && expected.avg_loss_per_class.size() == actual.avg_loss_per_class.size();
+    for(size_t i = 0; same && i < expected.avg_loss_per_class.size(); i++){
+        same = std::fabs(expected.avg_loss_per_class[i] - actual.avg_loss_per_class[i]) < 1e-9;
+    }
+    if(!same){
+        std::cout << label << ": got " << actual.correct << "/" << actual.total << " correct, loss " << actual.avg_loss
+            << ", expected " << expected.correct << "/" << expected.total << " correct, loss " << expected.avg_loss << std::endl;
+    }
+    return same;
+}
+
+int main(){
+
+    // 101 samples, so that most batch sizes leave an incomplete last batch
+    TestDataLoader dataloader(101, 12, 5, 0, false);
+
+    PlainNN reference(1);
+    reference.add_layer(new Input({12}));
+    reference.add_layer(new Dense(9, new ReLU()));
+    reference.add_layer(new Dense(5, new Sigmoid()));
+    std::vector<double> hidden_params = reference.get_layer(1)->get_saveable_params();
+    std::vector<double> output_params = reference.get_layer(2)->get_saveable_params();
+
+    EvaluationResult expected = reference.evaluate(dataloader, false);
+    if(expected.total != 101 || expected.avg_loss_per_class.size() != 5){
+        std::cout << "Unexpected sample by sample evaluation: " << expected.total << " samples" << std::endl;
+        return TEST_FAIL;
+    }
+
+    const int thread_counts[] = {1, 2, 3};
+    const int batch_sizes[] = {1, 7, 16, 128};
+    for(int num_threads : thread_counts){
+        PlainNN model(num_threads);
+        model.add_layer(new Input({12}));
+        model.add_layer(new Dense(9, new ReLU()));
+        model.add_layer(new Dense(5, new Sigmoid()));
+        model.get_layer(1)->load_params(hidden_params);
+        model.get_layer(2)->load_params(output_params);
+
+        for(int batch_size : batch_sizes){
+            EvaluationResult actual = model.evaluate(dataloader, batch_size, false);
+            std::string label = std::to_string(num_threads) + " threads, batch of " + std::to_string(batch_size);
+            if(!same_result(expected, actual, label.c_str())) return TEST_FAIL;
+        }
+    }
+
+    return TEST_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+void build_model(PlainNN& model, std::vector<std::vector<double> >& params){
+    model.add_layer(new Input({20}));
+    model.add_layer(new Dense(16, new ReLU()));
+    model.add_layer(new Dense(4, new Sigmoid()));
+
+    for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+        if(params.size() < 3) params.resize(3);
+        if(params[layer_idx].empty()) params[layer_idx] = model.get_layer(layer_idx)->get_saveable_params();
+        else model.get_layer(layer_idx)->load_params(params[layer_idx]);
+    }
+}
+
+int main(){
+
+    TestDataLoader dataloader(256, 20, 4);
+    std::vector<std::vector<double> > params;
+
+    PlainNN reference(1);
+    build_model(reference, params);
+    TrainingStats stats = reference.train(dataloader, 0.1, 2, 30);
+    if(stats.num_threads != 1 || stats.samples != 2 * 8 * 30){
+        std::cout << "Unexpected training stats: " << stats.num_threads << " threads, " << stats.samples << " samples" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Odd thread counts leave some workers out of the last
+    // reduction rounds and give uneven chunks of the batch
+    const int thread_counts[] = {2, 3, 5};
+    for(int num_threads : thread_counts){
+        dataloader.new_epoch();
+
+        PlainNN model(num_threads);
+        build_model(model, params);
+        stats = model.train(dataloader, 0.1, 2, 30);
+
+        if(stats.num_threads != num_threads){
+            std::cout << "Expected " << num_threads << " threads, got " << stats.num_threads << std::endl;
+            return TEST_FAIL;
+        }
+
+        for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+            std::vector<double> expected = reference.get_layer(layer_idx)->get_saveable_params();
+            std::vector<double> actual = model.get_layer(layer_idx)->get_saveable_params();
+            for(size_t i = 0; i < expected.size(); i++){
+                if(std::fabs(expected[i] - actual[i]) > 1e-9){
+                    std::cout << "Parameters of layer " << layer_idx << " differ with " << num_threads
+                        << " threads at " << i << ": " << actual[i] << " != " << expected[i] << std::endl;
+                    return TEST_FAIL;
+                }
+            }
+        }
+    }
+
+    // With a single thread Hogwild applies the same updates in the
+    // same order as the synchronous loop
+    dataloader.new_epoch();
+    PlainNN hogwild(1);
+    hogwild.set_training_strategy(TrainingStrategy::HOGWILD);
+    build_model(hogwild, params);
+    hogwild.train(dataloader, 0.1, 2, 30);
+
+    for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+        std::vector<double> expected = reference.get_layer(layer_idx)->get_saveable_params();
+        std::vector<double> actual = hogwild.get_layer(layer_idx)->get_saveable_params();
+        for(size_t i = 0; i < expected.size(); i++){
+            if(std::fabs(expected[i] - actual[i]) > 1e-9){
+                std::cout << "Parameters of layer " << layer_idx << " differ with a single Hogwild thread at "
+                    << i << ": " << actual[i] << " != " << expected[i] << std::endl;
+                return TEST_FAIL;
+            }
+        }
+    }
+
+    // With more threads the updates interleave, only check that
+    // every batch is processed and the parameters stay finite
+    dataloader.new_epoch();
+    PlainNN hogwild_mt(3);
+    hogwild_mt.set_training_strategy(TrainingStrategy::HOGWILD);
+    build_model(hogwild_mt, params);
+    stats = hogwild_mt.train(dataloader, 0.1, 2, 30);
+
+    if(stats.num_threads != 3 || stats.samples != 2 * 8 * 30){
+        std::cout << "Unexpected Hogwild training stats: " << stats.num_threads << " threads, " << stats.samples << " samples" << std::endl;
+        return TEST_FAIL;
+    }
+    for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+        std::vector<double> actual = hogwild_mt.get_layer(layer_idx)->get_saveable_params();
+        for(size_t i = 0; i < actual.size(); i++){
+            if(!std::isfinite(actual[i])){
+                std::cout << "Parameters of layer " << layer_idx << " diverged with Hogwild at " << i << std::endl;
+                return TEST_FAIL;
+            }
+        }
+    }
+
+    return TEST_SUCCESS;
+}
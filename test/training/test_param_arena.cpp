@@ -0,0 +1,87 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+int main(){
+
+    PlainNN model(2);
+    model.add_layer(new Input({12}));
+    model.add_layer(new Dense(7, new ReLU()));
+    std::vector<double> first_layer = model.get_layer(1)->get_saveable_params();
+
+    // Adding a layer moves the previous ones to a new arena
+    model.add_layer(new Dense(3, new Softmax()));
+    model.set_loss(new CrossEntropy());
+
+    if(model.get_layer(1)->get_saveable_params() != first_layer){
+        std::cout << "The parameters changed when the arena was reallocated" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // Every layer views the arena, starting on an aligned boundary,
+    // with the weights followed by the biases
+    Tensor params = model.parameters();
+    if(!params.is_view() || reinterpret_cast<uintptr_t>(params.data()) % 64 != 0){
+        std::cout << "The parameters are not an aligned view" << std::endl;
+        return TEST_FAIL;
+    }
+
+    std::vector<int> offsets;
+    for(int layer_idx = 1; layer_idx < 3; layer_idx++){
+        Dense* dense = dynamic_cast<Dense*>(model.get_layer(layer_idx));
+        Tensor* weights = dense->get_params();
+        long int offset = weights->data() - params.data();
+        if(!weights->is_view() || offset < 0 || offset >= params.size() || reinterpret_cast<uintptr_t>(weights->data()) % 64 != 0){
+            std::cout << "The weights of layer " << layer_idx << " are not an aligned view of the arena" << std::endl;
+            return TEST_FAIL;
+        }
+
+        std::vector<double> saved = dense->get_saveable_params();
+        if(!std::equal(saved.begin(), saved.end(), params.data() + offset)){
+            std::cout << "The layout of layer " << layer_idx << " in the arena does not match its parameters" << std::endl;
+            return TEST_FAIL;
+        }
+        offsets.push_back(offset);
+    }
+    if(offsets[1] < offsets[0] + 12 * 7 + 7){
+        std::cout << "The layers overlap in the arena" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // A checkpoint is a single copy of the arena
+    std::vector<double> checkpoint(params.data(), params.data() + params.size());
+    std::vector<double> saved = model.get_layer(2)->get_saveable_params();
+
+    TestDataLoader dataloader(32, 12, 3, -0.5);
+    model.train(dataloader, 0.1, 2, 8);
+
+    if(model.get_layer(2)->get_saveable_params() == saved){
+        std::cout << "Training did not update the parameters" << std::endl;
+        return TEST_FAIL;
+    }
+    Tensor grads = model.gradients();
+    for(int i = 0; i < grads.size(); i++){
+        if(grads[i] != 0){
+            std::cout << "The gradients were not cleared by the update at " << i << std::endl;
+            return TEST_FAIL;
+        }
+    }
+
+    std::memcpy(model.parameters().data(), checkpoint.data(), checkpoint.size() * sizeof(double));
+    if(model.get_layer(2)->get_saveable_params() != saved){
+        std::cout << "Restoring the checkpoint did not restore the parameters" << std::endl;
+        return TEST_FAIL;
+    }
+
+    return TEST_SUCCESS;
+}
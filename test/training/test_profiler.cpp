@@ -0,0 +1,145 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+void build_model(PlainNN& model, std::vector<std::vector<double> >& params){
+    model.add_layer(new Input({20}));
+    model.add_layer(new Dense(32, new ReLU()));
+    model.add_layer(new Dense(16, new Tanh()));
+    model.add_layer(new Dense(4, new Softmax()));
+    model.set_loss(new CrossEntropy());
+    model.set_optimizer(new Adam());
+
+    params.resize(4);
+    for(int layer_idx = 1; layer_idx < 4; layer_idx++){
+        if(params[layer_idx].empty()) params[layer_idx] = model.get_layer(layer_idx)->get_saveable_params();
+        else model.get_layer(layer_idx)->load_params(params[layer_idx]);
+    }
+}
+
+bool check_profile(PlainNN& model, int epochs, int steps_per_epoch, int num_threads){
+    Profiler* profiler = model.profiler();
+    if(profiler == nullptr || static_cast<int>(profiler->epochs().size()) != epochs){
+        std::cout << "Expected a profile for each of the " << epochs << " epochs" << std::endl;
+        return false;
+    }
+
+    for(int epoch = 0; epoch < epochs; epoch++){
+        EpochProfile& profile = profiler->epochs()[epoch];
+        if(profile.epoch != epoch || profile.steps != steps_per_epoch || profile.num_threads != num_threads){
+            std::cout << "Unexpected profile of epoch " << epoch << ": " << profile.steps << " steps, "
+                << profile.num_threads << " threads" << std::endl;
+            return false;
+        }
+
+        // The input layer does nothing, every other layer does all of its sections
+        for(int section = 0; section < NUM_LAYER_SECTIONS; section++){
+            if(profile.layer_time[0][section] != 0){
+                std::cout << "The input layer has a " << PROFILE_SECTION_NAMES[section] << " time" << std::endl;
+                return false;
+            }
+            double layers_time = 0;
+            for(size_t layer_idx = 1; layer_idx < profile.layer_time.size(); layer_idx++){
+                if(profile.layer_time[layer_idx][section] <= 0){
+                    std::cout << "Layer " << layer_idx << " has no " << PROFILE_SECTION_NAMES[section] << " time" << std::endl;
+                    return false;
+                }
+                layers_time += profile.layer_time[layer_idx][section];
+            }
+            if(std::fabs(layers_time - profile.section_time[section]) > 1e-9){
+                std::cout << "The " << PROFILE_SECTION_NAMES[section] << " time is not the sum of the layers" << std::endl;
+                return false;
+            }
+        }
+
+        if(profile.section_time[PROFILE_LOADER] <= 0 || profile.wall_time <= 0){
+            std::cout << "Epoch " << epoch << " has no loader or wall time" << std::endl;
+            return false;
+        }
+    }
+
+    EpochProfile total = profiler->total();
+    if(total.steps != epochs * steps_per_epoch){
+        std::cout << "The total has " << total.steps << " steps" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(){
+
+    TestDataLoader dataloader(256, 20, 4);
+    std::vector<std::vector<double> > params;
+
+    PlainNN reference(2);
+    build_model(reference, params);
+    if(reference.profiler() != nullptr){
+        std::cout << "Profiling is enabled by default" << std::endl;
+        return TEST_FAIL;
+    }
+    reference.train(dataloader, 0.01, 2, 16);
+
+    bool thrown = false;
+    try{
+        reference.print_profile();
+    } catch(const std::runtime_error&){
+        thrown = true;
+    }
+    if(!thrown){
+        std::cout << "Printing the profile of a model without a profiler did not throw" << std::endl;
+        return TEST_FAIL;
+    }
+
+    dataloader.new_epoch();
+    PlainNN model(2);
+    build_model(model, params);
+    model.enable_profiling();
+    model.train(dataloader, 0.01, 2, 16);
+
+    if(!check_profile(model, 2, 16, 2)){
+        return TEST_FAIL;
+    }
+    model.print_profile();
+
+    // The layers updated one at a time while profiling give
+    // the same parameters as the single sweep of the arena
+    for(int layer_idx = 1; layer_idx < 4; layer_idx++){
+        std::vector<double> expected = reference.get_layer(layer_idx)->get_saveable_params();
+        std::vector<double> actual = model.get_layer(layer_idx)->get_saveable_params();
+        for(size_t i = 0; i < expected.size(); i++){
+            if(std::fabs(expected[i] - actual[i]) > 1e-12){
+                std::cout << "Parameters of layer " << layer_idx << " differ when profiling at " << i
+                    << ": " << actual[i] << " != " << expected[i] << std::endl;
+                return TEST_FAIL;
+            }
+        }
+    }
+
+    // Each Hogwild thread records in its own slot
+    dataloader.new_epoch();
+    PlainNN hogwild(2);
+    hogwild.set_training_strategy(TrainingStrategy::HOGWILD);
+    build_model(hogwild, params);
+    hogwild.enable_profiling();
+    hogwild.train(dataloader, 0.01, 1, 16);
+
+    if(!check_profile(hogwild, 1, 16, 2)){
+        return TEST_FAIL;
+    }
+
+    hogwild.enable_profiling(false);
+    if(hogwild.profiler() != nullptr){
+        std::cout << "The profiler was not disabled" << std::endl;
+        return TEST_FAIL;
+    }
+
+    return TEST_SUCCESS;
+}
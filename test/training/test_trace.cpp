@@ -0,0 +1,173 @@
+#include "plain_nn.hpp"
+#include "test_dataloader.hpp"
+#include "json.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <set>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+
+#define TEST_SUCCESS 0
+#define TEST_FAIL 1
+
+/**
+ * @brief Read the names of the complete events and of the threads of a trace
+ */
+bool read_trace(std::string file_name, std::multiset<std::string>& events, std::set<std::string>& threads){
+    std::ifstream file(file_name);
+    std::stringstream content;
+    content << file.rdbuf();
+    std::string json = content.str();
+
+    json_value_s* root = json_parse(json.c_str(), json.size());
+    if(root == nullptr){
+        std::cout << "The trace is not valid JSON" << std::endl;
+        return false;
+    }
+
+    json_object_s* root_obj = json_value_as_object(root);
+    json_array_s* trace_events = nullptr;
+    for(json_object_element_s* element = root_obj->start; element != nullptr; element = element->next){
+        if(std::strcmp(element->name->string, "traceEvents") == 0) trace_events = json_value_as_array(element->value);
+    }
+    if(trace_events == nullptr){
+        std::cout << "The trace has no traceEvents" << std::endl;
+        std::free(root);
+        return false;
+    }
+
+    for(json_array_element_s* item = trace_events->start; item != nullptr; item = item->next){
+        std::string name, phase, thread_name;
+        bool has_duration = false;
+        json_object_s* event = json_value_as_object(item->value);
+        for(json_object_element_s* element = event->start; element != nullptr; element = element->next){
+            std::string key = element->name->string;
+            if(key == "name") name = json_value_as_string(element->value)->string;
+            if(key == "ph") phase = json_value_as_string(element->value)->string;
+            if(key == "dur") has_duration = json_value_as_number(element->value) != nullptr;
+            if(key == "args"){
+                json_object_s* args = json_value_as_object(element->value);
+                thread_name = json_value_as_string(args->start->value)->string;
+            }
+        }
+
+        if(phase == "X" && has_duration) events.insert(name);
+        else if(phase == "M") threads.insert(thread_name);
+    }
+
+    std::free(root);
+    return true;
+}
+
+int main(){
+
+    PlainNN model(2);
+    model.add_layer(new Input({20}));
+    model.add_layer(new Dense(16, new ReLU()));
+    model.add_layer(new Dense(4, new Softmax()));
+    model.set_loss(new CrossEntropy());
+
+    TestDataLoader dataloader(128, 20, 4);
+    PrefetchDataLoader prefetch(dataloader, 2);
+
+    // Nothing is recorded until the trace starts
+    long int before = Tracer::num_events();
+    model.train(prefetch, 0.01, 1, 16);
+    if(Tracer::enabled() || Tracer::num_events() != before){
+        std::cout << "Events were recorded without tracing" << std::endl;
+        return TEST_FAIL;
+    }
+
+    Tracer::start();
+    prefetch.new_epoch();
+    model.train(prefetch, 0.01, 2, 16);
+
+    Tensor sample({20});
+    model.compile();
+    model.predict(sample);
+    Tracer::stop();
+
+    long int recorded = Tracer::num_events();
+    model.predict(sample);
+    if(Tracer::num_events() != recorded){
+        std::cout << "Events were recorded after the trace stopped" << std::endl;
+        return TEST_FAIL;
+    }
+
+    const char* file_name = "test_trace.json";
+    Tracer::save(file_name);
+
+    std::multiset<std::string> events;
+    std::set<std::string> threads;
+    if(!read_trace(file_name, events, threads)){
+        return TEST_FAIL;
+    }
+    std::remove(file_name);
+
+    if(static_cast<long int>(events.size()) != recorded){
+        std::cout << "The trace has " << events.size() << " events, " << recorded << " were recorded" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // 2 epochs of 8 steps, each split between the 2 workers
+    if(events.count("epoch") != 2 || events.count("step") != 16 || events.count("update") != 16
+        || events.count("train_worker") != 32 || events.count("reduce_gradients") != 16){
+        std::cout << "Unexpected number of training events: " << events.count("epoch") << " epochs, "
+            << events.count("step") << " steps, " << events.count("train_worker") << " worker tasks" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // The compile pass and the traced predict
+    if(events.count("dense.forward") != 32 + 2 || events.count("dense_1.backward") != 32 || events.count("predict") != 2){
+        std::cout << "Unexpected number of layer events: " << events.count("dense.forward") << " forward passes, "
+            << events.count("dense_1.backward") << " backward passes" << std::endl;
+        return TEST_FAIL;
+    }
+
+    if(events.count("prefetch_batch") == 0 || events.count("wait_batch") != 16 || events.count("fill_batch") != 16){
+        std::cout << "The loader events are missing" << std::endl;
+        return TEST_FAIL;
+    }
+
+    if(threads.count("prefetch") == 0 || threads.count("pool worker 1") == 0){
+        std::cout << "The prefetch and pool threads are not named" << std::endl;
+        return TEST_FAIL;
+    }
+
+    // The buffers are bounded, the extra events are counted
+    Tracer::start(4);
+    model.predict(sample);
+    model.predict(sample);
+    Tracer::stop();
+    if(Tracer::num_events() != 4 || Tracer::num_dropped() != 2){
+        std::cout << "Expected 4 events and 2 dropped, got " << Tracer::num_events() << " and " << Tracer::num_dropped() << std::endl;
+        return TEST_FAIL;
+    }
+
+    // A thread still recording while the trace is restarted, counted and saved
+    std::atomic<bool> recording(true);
+    std::thread recorder([&]{
+        while(recording.load()){
+            TraceScope scope("late", "test");
+        }
+    });
+    for(int i = 0; i < 20; i++){
+        Tracer::start(64);
+        Tracer::num_events();
+        Tracer::stop();
+        Tracer::num_dropped();
+        Tracer::save("trace_concurrent.json");
+    }
+    recording.store(false);
+    recorder.join();
+    std::remove("trace_concurrent.json");
+
+    return TEST_SUCCESS;
+}